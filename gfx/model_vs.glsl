@@ -17,19 +17,22 @@
  */
 #version 330 core
 out vec3 TexCoords;
-out vec3 FragNormal;
-out vec3 FragPosition;
 
-layout (location = 0) in vec3 a_Pos;
-layout (location = 1) in vec3 a_Normal;
-layout (location = 2) in vec3 a_TexCoords;
-layout (location = 3) in vec3 a_Tangent;
-layout (location = 4) in vec3 a_Bitangent;
+/*
+ * DsPencilPackedVertex (or DsPencilBasicVertex);
+ * tangent frame (locations 1 and 3) is not read,
+ * so model import strips it
+ */
+layout (location = 0) in vec4 a_Pos;
+layout (location = 2) in vec2 a_TexCoords;
 
 uniform mat4 a_mvp;
+uniform vec3 a_AabbCenter;
+uniform vec3 a_AabbExtent;
 
 void main()
 {
-  TexCoords = a_TexCoords;    
-  gl_Position = a_mvp * vec4(a_Pos, 1.0);
+  vec3 position = a_Pos.xyz * a_AabbExtent + a_AabbCenter;
+  TexCoords = vec3(a_TexCoords, 0.0);
+  gl_Position = a_mvp * vec4(position, 1.0);
 }
@@ -16,42 +16,166 @@
 -- along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
 --]]
 local event = {};
+local buckets = {};
 local handlers = {};
-local lastEvent = 0;
+local lastId = 0;
+
+--
+-- Handlers are kept on per-key arrays (nil key
+-- ones on 'wildcard'), so push only walks those
+-- interested in. Removed handlers are just marked
+-- dead, and arrays compacted once enough of them
+-- pile up (never while being walked)
+--
+
+local function newBucket(key)
+  return {key = key, n = 0, dead = 0, depth = 0};
+end
+
+local wildcard = newBucket(nil);
+
+local function compact(bucket)
+  local j = 0;
+  for i = 1, bucket.n do
+    local handler = bucket[i];
+    if(handler.callback) then
+      j = j + 1;
+      bucket[j] = handler;
+    end
+  end
+
+  for i = j + 1, bucket.n do
+    bucket[i] = nil;
+  end
+
+  bucket.n = j;
+  bucket.dead = 0;
+
+  if(j == 0 and bucket.key ~= nil and buckets[bucket.key] == bucket) then
+    buckets[bucket.key] = nil;
+  end
+end
+
+local function collect(bucket)
+  if(bucket.depth == 0 and bucket.dead > 0 and bucket.dead * 2 >= bucket.n) then
+    compact(bucket);
+  end
+end
+
+local function remove(handler)
+  if(handlers[handler.id] == handler) then
+    local bucket = handler.bucket;
+    handlers[handler.id] = nil;
+    handler.callback = nil;
+    bucket.dead = bucket.dead + 1;
+    collect(bucket);
+  end
+end
+
+local function dispatch(bucket, name, ...)
+  local n = bucket.n;
+  bucket.depth = bucket.depth + 1;
+
+  for i = 1, n do
+    local handler = bucket[i];
+    local callback = handler.callback;
+    if(callback) then
+--
+-- TTL collect
+--
+      handler.times = handler.times - 1;
+      if(0 >= handler.times) then
+        remove(handler);
+      end
+
+--
+-- Call
+--
+      local success, reason = pcall(callback, name, ...);
+      if(not success) then
+        pcall(event.onError, reason);
+      elseif(reason == false) then
+        remove(handler);
+      end
+    end
+  end
+
+  bucket.depth = bucket.depth - 1;
+  collect(bucket);
+end
 
 --
 -- Public API
 --
 function event.register(key, callback, times, opt_handlers)
+  checkArg(1, key, 'string', 'nil');
+  checkArg(2, callback, 'function');
+  local bucket = wildcard;
+
+--
+-- Caller-owned table, kept as is
+--
+  if(opt_handlers ~= nil) then
+    local id = 0;
+    repeat
+      id = id + 1;
+    until(not opt_handlers[id]);
+
+    opt_handlers[id] =
+    {
+      key = key,
+      times = times or 1,
+      callback = callback,
+    }
+  return id;
+  end
+
+  if(key ~= nil) then
+    bucket = buckets[key];
+    if(not bucket) then
+      bucket = newBucket(key);
+      buckets[key] = bucket;
+    end
+  end
+
+  lastId = lastId + 1;
+
   local handler =
   {
+    id = lastId,
     key = key,
     times = times or 1,
     callback = callback,
+    bucket = bucket,
   }
 
-  opt_handlers = opt_handlers or handlers;
-
-  local id = 0;
-  repeat
-    id = id + 1;
-  until(not opt_handlers[id]);
-
-  opt_handlers[id] = handler;
-return id;
+  bucket.n = bucket.n + 1;
+  bucket[bucket.n] = handler;
+  handlers[lastId] = handler;
+return lastId;
 end
 
 function event.unregister(key, callback)
   checkArg(1, key, 'string', 'number');
   if(type(key) == 'string') then
     checkArg(2, callback, 'function');
-    for id, handler in pairs(handlers) do
-      if(handler.key == key and handler.callback == callback) then
-        handlers[id] = nil;
+    local bucket = buckets[key];
+    if(bucket) then
+      bucket.depth = bucket.depth + 1;
+      for i = 1, bucket.n do
+        local handler = bucket[i];
+        if(handler.callback == callback) then
+          remove(handler);
+        end
       end
+      bucket.depth = bucket.depth - 1;
+      collect(bucket);
     end
   else
-    handlers[id] = nil;
+    local handler = handlers[key];
+    if(handler) then
+      remove(handler);
+    end
   end
 end
 
@@ -61,26 +185,13 @@ end
 
 function event.push(name, ...)
   checkArg(1, name, 'string');
-  for id, handler in pairs(handlers) do
-    if(handler.key == nil or handler.key == name) then
---
--- TTL collect
---
-      handler.times = handler.times - 1;
-      if((0 >= handler.times) and (handlers[id] == handler)) then
-          handlers[id] = nil;
-      end
+  local bucket = buckets[name];
+  if(bucket) then
+    dispatch(bucket, name, ...);
+  end
 
---
--- Call
---
-      local success, reason = pcall(handler.callback, name, ...);
-      if(not success) then
-        pcall(event.onError, reason);
-      elseif(reason == false and handlers[id] == handler) then
-        handlers[id] = nil;
-      end
-    end
+  if(wildcard.n > 0) then
+    dispatch(wildcard, name, ...);
   end
 end
 
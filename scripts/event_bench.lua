@@ -0,0 +1,95 @@
+--[[
+-- Copyright 2021-2022 MarcosHCK
+-- This file is part of deusexmakina2.
+--
+-- deusexmakina2 is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- deusexmakina2 is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+--]]
+
+--
+-- event.lua microbenchmark: 1k handlers spread
+-- across 50 event names, against a linear scan
+-- (what event.push used to do) as baseline.
+--
+-- Usage: lua event_bench.lua [pushes]
+--
+
+local N_HANDLERS = 1000;
+local N_NAMES = 50;
+local N_PUSHES = tonumber(arg and arg[1]) or 200000;
+
+checkArg = checkArg or function() end
+
+local dir = (arg and arg[0] or ''):match('^(.*[/\\])') or './';
+local event = dofile(dir .. 'event.lua');
+
+local names = {};
+for i = 1, N_NAMES do
+  names[i] = 'event' .. i;
+end
+
+local calls = 0;
+local function callback()
+  calls = calls + 1;
+end
+
+--
+-- Baseline
+--
+
+local linear = {};
+local function linearPush(name, ...)
+  for _, handler in pairs(linear) do
+    if(handler.key == nil or handler.key == name) then
+      handler.callback(name, ...);
+    end
+  end
+end
+
+for i = 1, N_HANDLERS do
+  local name = names[(i - 1) % N_NAMES + 1];
+  linear[i] = {key = name, callback = callback};
+  event.listen(name, callback);
+end
+
+local function run(label, push)
+  calls = 0;
+  local start = os.clock();
+  for i = 1, N_PUSHES do
+    push(names[(i - 1) % N_NAMES + 1], i);
+  end
+  local elapsed = os.clock() - start;
+  print(string.format('%-8s %8.3f s  %8.1f ns/push  %d calls',
+    label, elapsed, elapsed * 1e9 / N_PUSHES, calls));
+  return elapsed;
+end
+
+local base = run('linear', linearPush);
+local indexed = run('indexed', event.push);
+print(string.format('speedup  %.1fx', base / indexed));
+
+--
+-- Unregister cost
+--
+
+local ids = {};
+for i = 1, N_HANDLERS do
+  ids[i] = event.listen(names[(i - 1) % N_NAMES + 1], callback);
+end
+
+local start = os.clock();
+for i = N_HANDLERS, 1, -1 do
+  event.unregister(ids[i]);
+end
+print(string.format('unregister %d handlers by id: %.3f ms',
+  N_HANDLERS, (os.clock() - start) * 1e3));
@@ -0,0 +1,127 @@
+--[[
+-- Copyright 2021-2022 MarcosHCK
+-- This file is part of deusexmakina2.
+--
+-- deusexmakina2 is free software: you can redistribute it and/or modify
+-- it under the terms of the GNU General Public License as published by
+-- the Free Software Foundation, either version 3 of the License, or
+-- (at your option) any later version.
+--
+-- deusexmakina2 is distributed in the hope that it will be useful,
+-- but WITHOUT ANY WARRANTY; without even the implied warranty of
+-- MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+-- GNU General Public License for more details.
+--
+-- You should have received a copy of the GNU General Public License
+-- along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+--]]
+
+--
+-- Model texture loading benchmark: writes an
+-- OBJ with 50 materials (one quad each), every
+-- one with diffuse, specular, normal and height
+-- DXT1 layers (full mip chain, blank texels).
+--
+-- Load it in place of backpack.obj (setup.lua)
+-- with G_MESSAGES_DEBUG=all and compare the
+-- 'read N texture files' line of read_textures
+-- across builds (textures are read on every
+-- load, cached model or not).
+--
+-- Usage: lua model_bench.lua [directory] [size]
+--
+
+local N_MATERIALS = 50;
+local DIRECTORY = arg and arg[1] or '.';
+local SIZE = tonumber(arg and arg[2]) or 1024;
+
+local layers =
+{
+  {key = 'map_Kd', suffix = 'diffuse'},
+  {key = 'map_Ks', suffix = 'specular'},
+  {key = 'norm', suffix = 'normal'},
+  {key = 'map_bump', suffix = 'height'},
+};
+
+--
+-- DDS writer
+--
+
+local function u32(value)
+  return string.char(
+    value % 256,
+    math.floor(value / 256) % 256,
+    math.floor(value / 65536) % 256,
+    math.floor(value / 16777216) % 256);
+end
+
+local function dds(size)
+  local mipmaps, length = 0, 0;
+  local side = size;
+
+  repeat
+    local blocks = math.floor((side + 3) / 4);
+    length = length + blocks * blocks * 8;
+    mipmaps = mipmaps + 1;
+    side = math.floor(side / 2);
+  until(side < 1);
+
+  local header =
+  {
+    'DDS ',
+    u32(124),                     -- size
+    u32(0xa1007),                 -- caps, height, width, pixel format, mipmap count, linear size
+    u32(size),                    -- height
+    u32(size),                    -- width
+    u32(size * size / 2),         -- linear size
+    u32(0),                       -- depth
+    u32(mipmaps),
+    string.rep(u32(0), 11),
+    u32(32),                      -- pixel format size
+    u32(0x4),                     -- fourcc
+    'DXT1',
+    string.rep(u32(0), 5),
+    u32(0x401008),                -- complex, texture, mipmap
+    string.rep(u32(0), 4),
+  };
+
+return table.concat(header) .. string.rep('\0', length);
+end
+
+local function write(name, contents)
+  local file = assert(io.open(DIRECTORY .. '/' .. name, 'wb'));
+  file:write(contents);
+  file:close();
+end
+
+--
+-- Model
+--
+
+local obj = {'mtllib bench.mtl', 'vt 0 0', 'vt 1 0', 'vt 1 1', 'vt 0 1', 'vn 0 0 1'};
+local mtl = {};
+local image = dds(SIZE);
+
+for i = 1, N_MATERIALS do
+  local x = (i - 1) * 1.5;
+  local v = (i - 1) * 4;
+  local name = 'bench' .. i;
+
+  table.insert(obj, ('v %g 0 0'):format(x));
+  table.insert(obj, ('v %g 0 0'):format(x + 1));
+  table.insert(obj, ('v %g 1 0'):format(x + 1));
+  table.insert(obj, ('v %g 1 0'):format(x));
+  table.insert(obj, 'usemtl ' .. name);
+  table.insert(obj, ('f %d/1/1 %d/2/1 %d/3/1 %d/4/1'):format(v + 1, v + 2, v + 3, v + 4));
+
+  table.insert(mtl, 'newmtl ' .. name);
+  for _, layer in ipairs(layers) do
+    local texture = ('%s_%s.dds'):format(name, layer.suffix);
+    table.insert(mtl, ('%s %s'):format(layer.key, texture));
+    write(texture, image);
+  end
+end
+
+write('bench.obj', table.concat(obj, '\n') .. '\n');
+write('bench.mtl', table.concat(mtl, '\n') .. '\n');
+print(('%d materials, %d textures of %dx%d written to %s'):format(N_MATERIALS, N_MATERIALS * #layers, SIZE, SIZE, DIRECTORY));
@@ -45,6 +45,7 @@ do
   local pipeline = application.pipeline
   local renderer = application.renderer
   local events = application.events
+  local simulation = application.simulation
   local GFile = lgi.Gio.File
   local Ds = lgi.Ds
 
@@ -98,6 +99,7 @@ do
   assert(error == nil, error)
 
   pipeline:register_shader('model', ds.priority.default, shader);
+  local model_shader = shader
 
 --[[
 --
@@ -147,22 +149,25 @@ do
       cancellable);
     assert(error == nil, error)
 
-    pipeline:append_object('skybox', ds.priority.default, skybox);
+    pipeline:queue_append_object('skybox', ds.priority.default, skybox);
   end
   lgi.Gio.Async.start(mkskybox)()
 
   local function mkmodel()
     local model, error =
-    Ds.ModelSingle.new(
+    Ds.ModelRegistry.get_default():async_load(
       GFile.new_for_path(ds.ASSETSDIR),
       'backpack.obj',
+      model_shader,
+      Ds.ModelAttributes.ALL,
       cancellable);
     assert(error == nil, error);
     local object = ds.Pkg.Backpack {model = model};
     local vec3 = glm.vec3;
     object:set_scale(vec3(0.1, 0.1, 0.1).vec3);
     object:set_position(vec3(0, 0, -0.7).vec3);
-    pipeline:append_object('model', ds.priority.default, object);
+    pipeline:queue_append_object('model', ds.priority.default, object);
+    simulation:add_object(object);
   end
   lgi.Gio.Async.start(mkmodel)()
 
@@ -214,12 +219,18 @@ do
   local d_ = string.byte('D')
   local s_ = string.byte('S')
 
-  function events.on_cursor:motion(detail, event)
+  local function on_motion(entry)
+    local event = entry.data.cursor;
+    renderer:stamp_input(entry.timestamp)
     renderer:look(event.motion.dx, event.motion.dy)
   end
 
-  function events.on_keyboard:key(detail, event)
-    local key = event.key.key;
+  local function on_key(entry)
+    local key = entry.data.keyboard.key.key;
+    if(key == w_ or key == a_ or key == d_ or key == s_) then
+      renderer:stamp_input(entry.timestamp)
+    end
+
     if(key == w_) then
       renderer:move(   0,    0,  0.1, true);
     elseif(key == a_) then
@@ -230,4 +241,18 @@ do
       renderer:move(   0,    0, -0.1, true);
     end
   end
+
+  function events:on_batch(batch)
+    for _, entry in ipairs(batch) do
+      if(entry.type == 'cursor') then
+        if(entry.detail == 'motion') then
+          on_motion(entry)
+        end
+      elseif(entry.type == 'keyboard') then
+        if(entry.detail == 'key') then
+          on_key(entry)
+        end
+      end
+    end
+  end
 end
@@ -18,6 +18,8 @@
 #include <config.h>
 #include <ds_application.h>
 #include <ds_folder_provider.h>
+#include <ds_frame_clock.h>
+#include <ds_frame_stats.h>
 #include <ds_looper.h>
 #include <ds_macros.h>
 #include <ds_mvpholder.h>
@@ -26,6 +28,7 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <luad_core.h>
+#include <time.h>
 #undef main
 
 /**
@@ -85,6 +88,12 @@ struct _DsApplicationPrivate
   GData* window_datalist;
   guint glew_init;
   DsPencil* pencil;
+  gboolean headless;
+  gchar* record;
+  gchar* replay;
+  DsFrameStats* replay_stats;
+  clock_t replay_cpu;
+  gint64 replay_start;
 };
 
 enum {
@@ -100,6 +109,15 @@ enum {
   prop_pipeline,
   prop_renderer,
   prop_events,
+  prop_simulation,
+
+/*
+ * Command line switches, must
+ * be set before activation
+ *
+ */
+
+  prop_headless,
 
 /*
  * Property number, a convenience way
@@ -144,6 +162,7 @@ ds_application_g_initiable_iface_init_sync(GInitable     *pself,
   DsPipeline* pipeline = NULL;
   DsRenderer* renderer = NULL;
   DsEvents* events = NULL;
+  DsSimulation* simulation = NULL;
 
   GFile* current = NULL;
   GFile* child = NULL;
@@ -270,6 +289,15 @@ ds_application_g_initiable_iface_init_sync(GInitable     *pself,
  *
  */
 
+  if(priv->headless == TRUE)
+  {
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else // GLFW_VERSION_MAJOR
+    g_warning("Headless mode needs GLFW 3.4 or newer, a display will be required\r\n");
+#endif // GLFW_VERSION_MAJOR
+  }
+
   return_ = glfwInit();
   if G_UNLIKELY(return_ != GLFW_TRUE)
   {
@@ -305,6 +333,19 @@ ds_application_g_initiable_iface_init_sync(GInitable     *pself,
   g_settings_get(gsettings, "width", "i", &width);
   g_settings_get(gsettings, "height", "i", &height);
 
+  if(priv->headless == TRUE)
+  {
+    /*
+     * No surface at all: an offscreen
+     * context (OSMesa, under Mesa llvmpipe)
+     * which renderer covers with an FBO
+     *
+     */
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+  }
+  else
   if(fullscreen == TRUE && borderless == TRUE)
   {
     const GLFWvidmode* mode = glfwGetVideoMode(monitor);
@@ -340,6 +381,13 @@ ds_application_g_initiable_iface_init_sync(GInitable     *pself,
 
   window =
   glfwCreateWindow(width, height, GAPPNAME, monitor, NULL);
+  if G_UNLIKELY(window == NULL && priv->headless == TRUE)
+  {
+    /* surfaceless EGL fallback */
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    window = glfwCreateWindow(width, height, GAPPNAME, NULL, NULL);
+  }
+
   if G_UNLIKELY(window == NULL)
   {
     const gchar* err = NULL;
@@ -366,7 +414,19 @@ ds_application_g_initiable_iface_init_sync(GInitable     *pself,
  *
  */
 
-  return_ = glewInit();
+  /*
+   * glewInit() also loads window system
+   * extensions (GLX), which needs a display
+   *
+   */
+
+  if(priv->headless == TRUE)
+  {
+    glewExperimental = GL_TRUE;
+    return_ = glewContextInit();
+  }
+  else
+    return_ = glewInit();
   if G_UNLIKELY(return_ != GLEW_OK)
   {
     g_set_error
@@ -382,6 +442,21 @@ ds_application_g_initiable_iface_init_sync(GInitable     *pself,
     glew_init = 1;
   }
 
+/*
+ * Frame clock
+ *
+ */
+
+  const GLFWvidmode* vidmode =
+  (priv->headless == TRUE) ? NULL :
+  glfwGetVideoMode(glfwGetPrimaryMonitor());
+  if G_LIKELY(vidmode != NULL && vidmode->refreshRate > 0)
+  {
+    ds_frame_clock_set_interval
+    (ds_frame_clock_get_default(),
+     G_USEC_PER_SEC / vidmode->refreshRate);
+  }
+
 /*
  * Pencil
  *
@@ -422,7 +497,7 @@ ds_application_g_initiable_iface_init_sync(GInitable     *pself,
  */
 
   renderer =
-  ds_renderer_new(gsettings, pipeline, window, cancellable, &tmp_err);
+  ds_renderer_new(gsettings, pipeline, window, priv->headless, cancellable, &tmp_err);
   if G_UNLIKELY(tmp_err != NULL)
   {
     g_propagate_error(error, tmp_err);
@@ -467,6 +542,24 @@ ds_application_g_initiable_iface_init_sync(GInitable     *pself,
     self->events = events;
   }
 
+/*
+ * Simulation
+ *
+ */
+
+  simulation =
+  ds_simulation_new(gsettings, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    _g_object_unref0(simulation);
+    goto_error();
+  }
+  else
+  {
+    self->simulation = simulation;
+  }
+
 /*
  * Execute setup script
  *
@@ -527,6 +620,98 @@ void ds_application_g_initiable_iface_init(GInitableIface* iface) {
   iface->init = ds_application_g_initiable_iface_init_sync;
 }
 
+static void
+on_replay_done(DsEvents* events, DsApplication* self)
+{
+  DsFrameStats* stats = self->priv->replay_stats;
+  gdouble cpu = (gdouble) (clock() - self->priv->replay_cpu) / CLOCKS_PER_SEC;
+  gdouble wall = (gdouble) (g_get_monotonic_time() - self->priv->replay_start) / G_USEC_PER_SEC;
+
+  g_print
+  ("replay: %u frames, %.3f s wall, %.3f s CPU\r\n"
+   "replay: frame time p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\r\n",
+   ds_frame_stats_get_total(stats),
+   wall,
+   cpu,
+   ds_frame_stats_percentile(stats, DS_FRAME_METRIC_FRAME, 50.),
+   ds_frame_stats_percentile(stats, DS_FRAME_METRIC_FRAME, 95.),
+   ds_frame_stats_percentile(stats, DS_FRAME_METRIC_FRAME, 99.),
+   ds_frame_stats_max(stats, DS_FRAME_METRIC_FRAME));
+
+  g_application_quit(G_APPLICATION(self));
+}
+
+static gboolean
+start_input_log(DsApplication* self, GCancellable* cancellable, GError** error)
+{
+  DsApplicationPrivate* priv = self->priv;
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GFile* file = NULL;
+  gint64 interval;
+  guint n_frames;
+
+  if(priv->replay != NULL)
+  {
+    file = g_file_new_for_path(priv->replay);
+
+    success =
+    ds_events_replay(self->events, file, &interval, &n_frames, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+
+/*
+ * Replay runs at recorded pace, and
+ * simulation steps on it regardless
+ * of how long frames actually take,
+ * so every run computes same states
+ *
+ */
+
+    ds_frame_clock_set_interval(ds_frame_clock_get_default(), interval);
+    ds_simulation_set_fixed_delta(self->simulation, interval);
+
+/*
+ * Keep whole run, not just last
+ * frames default ring holds
+ *
+ */
+
+    priv->replay_stats = ds_frame_stats_new(MAX(n_frames, 1) + 1);
+    ds_renderer_set_frame_stats(self->renderer, priv->replay_stats);
+
+    g_signal_connect
+    (self->events,
+     "replay-done",
+     G_CALLBACK(on_replay_done),
+     self);
+
+    priv->replay_cpu = clock();
+    priv->replay_start = g_get_monotonic_time();
+    _g_object_unref0(file);
+  }
+
+  if(priv->record != NULL)
+  {
+    file = g_file_new_for_path(priv->record);
+
+    success =
+    ds_events_record(self->events, file, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+  }
+
+_error_:
+  _g_object_unref0(file);
+return success;
+}
+
 static
 void ds_application_class_activate(GApplication* pself)
 {
@@ -554,12 +739,33 @@ void ds_application_class_activate(GApplication* pself)
     return;
   }
 
+/*
+ * Input record / replay
+ *
+ */
+
+  success =
+  start_input_log(self, g_cancellable_get_current(), &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_critical
+    ("(%s: %i): %s: %i: %s\r\n",
+     G_STRFUNC,
+     __LINE__,
+     g_quark_to_string(tmp_err->domain),
+     tmp_err->code,
+     tmp_err->message);
+    g_error_free(tmp_err);
+    return;
+  }
+
 /*
  * Start loopers
  *
  */
 
   ds_looper_start(DS_LOOPER(self->renderer));
+  ds_looper_start(DS_LOOPER(self->simulation));
   ds_looper_start(DS_LOOPER(self->events));
 
 /*
@@ -570,6 +776,19 @@ void ds_application_class_activate(GApplication* pself)
   g_application_hold(pself);
 }
 
+static
+gint ds_application_class_handle_local_options(GApplication* pself, GVariantDict* options)
+{
+  DsApplication* self = DS_APPLICATION(pself);
+
+  if(g_variant_dict_contains(options, "headless"))
+    self->priv->headless = TRUE;
+
+  g_variant_dict_lookup(options, "record", "^ay", &(self->priv->record));
+  g_variant_dict_lookup(options, "replay", "^ay", &(self->priv->replay));
+return -1;
+}
+
 static
 void ds_application_class_get_property(GObject* pself, guint prop_id, GValue* value, GParamSpec* pspec)
 {
@@ -588,6 +807,12 @@ void ds_application_class_get_property(GObject* pself, guint prop_id, GValue* va
   case prop_events:
     g_value_set_object(value, self->events);
     break;
+  case prop_simulation:
+    g_value_set_object(value, self->simulation);
+    break;
+  case prop_headless:
+    g_value_set_boolean(value, self->priv->headless);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(pself, prop_id, pspec);
     break;
@@ -600,6 +825,9 @@ void ds_application_class_set_property(GObject* pself, guint prop_id, const GVal
   DsApplication* self = DS_APPLICATION(pself);
   switch(prop_id)
   {
+  case prop_headless:
+    self->priv->headless = g_value_get_boolean(value);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(pself, prop_id, pspec);
     break;
@@ -612,12 +840,16 @@ void ds_application_class_finalize(GObject* pself) {
   _glew_fini0(self->priv->glew_init);
   _glfw_DestroyWindow0(self->priv->window);
   _glfw_fini0(self->priv->glfw_init);
+  _g_free0(self->priv->record);
+  _g_free0(self->priv->replay);
+  g_clear_pointer(&(self->priv->replay_stats), ds_frame_stats_unref);
 G_OBJECT_CLASS(ds_application_parent_class)->finalize(pself);
 }
 
 static
 void ds_application_class_dispose(GObject* pself) {
   DsApplication* self = DS_APPLICATION(pself);
+  g_clear_object(&(self->simulation));
   g_clear_object(&(self->events));
   g_clear_object(&(self->renderer));
   g_clear_object(&(self->pipeline));
@@ -635,6 +867,7 @@ void ds_application_class_init(DsApplicationClass* klass) {
   GObjectClass* oclass = G_OBJECT_CLASS(klass);
 
   aclass->activate = ds_application_class_activate;
+  aclass->handle_local_options = ds_application_class_handle_local_options;
 
   oclass->get_property = ds_application_class_get_property;
   oclass->set_property = ds_application_class_set_property;
@@ -668,6 +901,20 @@ void ds_application_class_init(DsApplicationClass* klass) {
      G_PARAM_READABLE
      | G_PARAM_STATIC_STRINGS);
 
+  properties[prop_simulation] =
+    g_param_spec_object
+    (_TRIPLET("simulation"),
+     DS_TYPE_SIMULATION,
+     G_PARAM_READABLE
+     | G_PARAM_STATIC_STRINGS);
+
+  properties[prop_headless] =
+    g_param_spec_boolean
+    (_TRIPLET("headless"),
+     FALSE,
+     G_PARAM_READWRITE
+     | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties
   (oclass,
    prop_number,
@@ -21,6 +21,7 @@
 #include <ds_export.h>
 #include <ds_pipeline.h>
 #include <ds_renderer.h>
+#include <ds_simulation.h>
 #include <gio/gio.h>
 
 /**
@@ -95,6 +96,7 @@ struct _DsApplication
   DsPipeline* pipeline;
   DsRenderer* renderer;
   DsEvents* events;
+  DsSimulation* simulation;
 };
 
 /**
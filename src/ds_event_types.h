@@ -26,6 +26,8 @@ typedef union  _DsEvCursor          DsEvCursor;
 typedef struct _DsEvKeyboardUnichar DsEvKeyboardUnichar;
 typedef struct _DsEvKeyboardKey     DsEvKeyboardKey;
 typedef union  _DsEvKeyboard        DsEvKeyboard;
+typedef union  _DsEvData            DsEvData;
+typedef struct _DsEvEntry           DsEvEntry;
 
 /**
  * DsEvCursorMotion:
@@ -135,4 +137,39 @@ union _DsEvKeyboard
   DsEvKeyboardKey key;
 };
 
+/**
+ * DsEvData:
+ * @cursor: event descriptor, if entry type is 'cursor'.
+ * @keyboard: event descriptor, if entry type is 'keyboard'.
+ *
+ * Holds any event descriptor a #DsEvEntry may carry.
+ *
+ */
+union _DsEvData
+{
+  DsEvCursor cursor;
+  DsEvKeyboard keyboard;
+};
+
+/**
+ * DsEvEntry:
+ * @type: event namespace ('cursor' or 'keyboard').
+ * @detail: event type name within namespace.
+ * @timestamp: when event was sampled (monotonic time, in microseconds);
+ * for merged motion or scroll entries, when first of them was.
+ * @data: event descriptor, either @data.cursor or
+ * @data.keyboard depending on @type.
+ *
+ * Represents an event inside a frame batch
+ * (see #DsEvents::batch).
+ *
+ */
+struct _DsEvEntry
+{
+  const gchar* type;
+  const gchar* detail;
+  gint64 timestamp;
+  DsEvData data;
+};
+
 #endif // __DS_EVENT_TYPES_INCLUDED__
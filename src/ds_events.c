@@ -19,6 +19,8 @@
 #include <ds_application.h>
 #include <ds_event_types.h>
 #include <ds_events.h>
+#include <ds_frame_clock.h>
+#include <ds_frame_stats.h>
 #include <ds_looper.h>
 #include <ds_macros.h>
 #include <ds_marshals.h>
@@ -47,16 +49,68 @@ G_DEFINE_QUARK(key,
  * DsEvents encapsulates complexities of
  * launching events into Lua space
  *
+ * Input can be recorded into a compact log, along
+ * with frame it arrived on, and replayed later (see
+ * ds_events_record() and ds_events_replay()); together
+ * with headless mode, this makes a session repeatable
+ * for benchmarking.
+ *
  */
 
 #define EVENT_PUSH "__DS_EVENT_PUSH"
 
+/*
+ * Input log format: a header, then
+ * fixed-size records in frame order;
+ * each one is stamped with frame it
+ * was delivered on, not sampled on
+ *
+ */
+
+#define LOG_MAGIC   "DSEV"
+#define LOG_VERSION (2)
+
+typedef struct _LogHeader LogHeader;
+typedef struct _Record    Record;
+
+struct _LogHeader
+{
+  gchar magic[4];
+  guint32 version;
+  gint64 interval;
+};
+
+struct _Record
+{
+  guint32 frame;
+  guint8 kind;
+  guint8 padding[3];
+  union
+  {
+    gdouble d[2];
+    gint32 i[4];
+  };
+};
+
+G_STATIC_ASSERT(sizeof(Record) == 24);
+
+enum
+{
+  kind_cursor_motion,
+  kind_cursor_button,
+  kind_cursor_scroll,
+  kind_keyboard_unichar,
+  kind_keyboard_key,
+};
+
 static void
 ds_events_g_initable_iface_init(GInitableIface* iface);
 
 enum
 {
   conn_invert_y,
+  conn_raw_mouse,
+  conn_input_rate,
   conn_number,
 };
 
@@ -90,6 +144,26 @@ struct _DsEvents
   double x_fact, y_fact;
 
   gulong connections[conn_number];
+
+  /*<private>*/
+  guint32 frame;
+  gboolean stepping;
+  GOutputStream* record;
+  guint32 record_base;
+  GBytes* replay;
+  gsize replay_at;
+  guint32 replay_base;
+
+  /*<private>*/
+  gboolean raw_events;
+  GArray* batch;
+  gint motion_at;
+  gint scroll_at;
+
+  /*<private>*/
+  gboolean running;
+  gint input_rate;
+  GSource* sampler;
 };
 
 struct _DsEventsClass
@@ -102,6 +176,7 @@ enum
   prop_0,
   prop_gsettings,
   prop_window,
+  prop_raw_events,
   prop_number,
 };
 
@@ -112,6 +187,8 @@ enum
 {
   sig_cursor,
   sig_keyboard,
+  sig_batch,
+  sig_replay_done,
   sig_number,
 };
 
@@ -136,6 +213,78 @@ on_invert_y_changed(GSettings       *gsettings,
   self->y_fact = (invert_y) ? -1.d : 1.d;
 }
 
+static void
+on_raw_mouse_changed(GSettings       *gsettings,
+                     const gchar     *key,
+                     DsEvents        *self)
+{
+  gboolean raw_mouse;
+  g_settings_get(gsettings, key, "b", &raw_mouse);
+
+/*
+ * Raw (unaccelerated) motion is only
+ * delivered while cursor is disabled,
+ * but cursor mode belongs to whoever
+ * set it (game or scripts), so only
+ * motion mode is touched here
+ *
+ */
+
+#ifdef GLFW_RAW_MOUSE_MOTION
+  if(glfwRawMouseMotionSupported())
+    glfwSetInputMode(self->window, GLFW_RAW_MOUSE_MOTION, raw_mouse);
+  else
+#endif // GLFW_RAW_MOUSE_MOTION
+  if(raw_mouse == TRUE)
+    g_warning("Raw mouse motion is not supported\r\n");
+}
+
+/*
+ * Sampler: extra input polls between
+ * frames, so samples for next frame are
+ * as recent as possible. GLFW only polls
+ * on main thread, so this runs on main
+ * context (which is free between frames
+ * when 'render-thread' is on)
+ *
+ */
+
+static gboolean
+sample_input(DsEvents* self)
+{
+  if G_LIKELY(self->replay == NULL)
+    glfwPollEvents();
+return G_SOURCE_CONTINUE;
+}
+
+static void
+sampler_update(DsEvents* self)
+{
+  if(self->sampler != NULL)
+  {
+    g_source_destroy(self->sampler);
+    g_clear_pointer(&(self->sampler), g_source_unref);
+  }
+
+  if(self->running == TRUE && self->input_rate > 0)
+  {
+    self->sampler = g_timeout_source_new(MAX(1, 1000 / self->input_rate));
+    g_source_set_name(self->sampler, "(Source) DsEvents sampler");
+    g_source_set_priority(self->sampler, G_PRIORITY_HIGH);
+    g_source_set_callback(self->sampler, (GSourceFunc) sample_input, self, NULL);
+    g_source_attach(self->sampler, NULL);
+  }
+}
+
+static void
+on_input_rate_changed(GSettings       *gsettings,
+                      const gchar     *key,
+                      DsEvents        *self)
+{
+  g_settings_get(gsettings, key, "i", &(self->input_rate));
+  sampler_update(self);
+}
+
 
 static gboolean
 ds_events_g_initable_iface_init_sync(GInitable* pself, GCancellable* cancellable, GError** error)
@@ -186,6 +335,22 @@ ds_events_g_initable_iface_init_sync(GInitable* pself, GCancellable* cancellable
    self);
   on_invert_y_changed(self->gsettings, "invert-y", self);
 
+  self->connections[conn_raw_mouse] =
+  g_signal_connect
+  (self->gsettings,
+   "changed::raw-mouse",
+   G_CALLBACK(on_raw_mouse_changed),
+   self);
+  on_raw_mouse_changed(self->gsettings, "raw-mouse", self);
+
+  self->connections[conn_input_rate] =
+  g_signal_connect
+  (self->gsettings,
+   "changed::input-rate",
+   G_CALLBACK(on_input_rate_changed),
+   self);
+  on_input_rate_changed(self->gsettings, "input-rate", self);
+
 _error_:
 return success;
 }
@@ -196,13 +361,73 @@ ds_events_g_initable_iface_init(GInitableIface* iface)
   iface->init = ds_events_g_initable_iface_init_sync;
 }
 
+static void
+dispatch(DsEvents* self, const Record* record);
+static void
+flush_(DsEvents* self);
+
+static void
+replay_step(DsEvents* self)
+{
+  const Record* records;
+  gsize n_records;
+  guint32 frame;
+
+  records = g_bytes_get_data(self->replay, &n_records);
+  n_records /= sizeof(Record);
+  frame = self->frame - self->replay_base;
+
+  while(self->replay_at < n_records
+    && records[self->replay_at].frame <= frame)
+  {
+    dispatch(self, &(records[self->replay_at]));
+    ++self->replay_at;
+  }
+
+  if G_UNLIKELY(self->replay_at >= n_records)
+  {
+    g_clear_pointer(&(self->replay), g_bytes_unref);
+    g_signal_emit(self, signals[sig_replay_done], 0);
+  }
+}
+
 static gboolean
 ds_events_class_loop_step(DsLooper* pself)
 {
+  DsEvents* self = DS_EVENTS(pself);
+  ++self->frame;
+  self->stepping = TRUE;
+
+  if G_UNLIKELY(self->replay != NULL)
+    replay_step(self);
+
   glfwPollEvents();
+
+  if(self->batch->len > 0)
+    flush_(self);
+
+  self->stepping = FALSE;
 return G_SOURCE_CONTINUE;
 }
 
+static void
+ds_events_class_start(DsLooper* pself)
+{
+  DsEvents* self = DS_EVENTS(pself);
+  self->running = TRUE;
+  sampler_update(self);
+DS_LOOPER_CLASS(ds_events_parent_class)->start(pself);
+}
+
+static void
+ds_events_class_stop(DsLooper* pself)
+{
+  DsEvents* self = DS_EVENTS(pself);
+  self->running = FALSE;
+  sampler_update(self);
+DS_LOOPER_CLASS(ds_events_parent_class)->stop(pself);
+}
+
 static void
 ds_events_class_set_property(GObject* pself, guint prop_id, const GValue* value, GParamSpec* pspec)
 {
@@ -215,6 +440,9 @@ ds_events_class_set_property(GObject* pself, guint prop_id, const GValue* value,
   case prop_window:
     self->window = g_value_get_pointer(value);
     break;
+  case prop_raw_events:
+    self->raw_events = g_value_get_boolean(value);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(pself, prop_id, pspec);
     break;
@@ -236,6 +464,21 @@ ds_events_class_dispose(GObject* pself)
     self->connections[i] = 0;
   }
 
+  if(self->record != NULL)
+  {
+    g_output_stream_close(self->record, NULL, NULL);
+    g_clear_object(&(self->record));
+  }
+
+  g_clear_pointer(&(self->replay), g_bytes_unref);
+  g_clear_pointer(&(self->batch), g_array_unref);
+
+  if(self->sampler != NULL)
+  {
+    g_source_destroy(self->sampler);
+    g_clear_pointer(&(self->sampler), g_source_unref);
+  }
+
   g_clear_object(&(self->gsettings));
 G_OBJECT_CLASS(ds_events_parent_class)->dispose(pself);
 }
@@ -247,6 +490,8 @@ ds_events_class_init(DsEventsClass* klass)
   DsLooperClass* lclass = DS_LOOPER_CLASS(klass);
 
   lclass->loop_step = ds_events_class_loop_step;
+  lclass->start = ds_events_class_start;
+  lclass->stop = ds_events_class_stop;
 
   oclass->set_property = ds_events_class_set_property;
   oclass->dispose = ds_events_class_dispose;
@@ -257,7 +502,9 @@ ds_events_class_init(DsEventsClass* klass)
    * @detail: event type name.
    * @event: (type Ds.EvCursor): event descriptor.
    *
-   * Launches a generic 'cursor' namespace event.
+   * Launches a generic 'cursor' namespace event, as
+   * soon as it is received. Only launched when
+   * #DsEvents:raw-events is set, see #DsEvents::batch.
    *
    */
   signals[sig_cursor] =
@@ -281,7 +528,9 @@ ds_events_class_init(DsEventsClass* klass)
    * @detail: event type name.
    * @event: (type Ds.EvKeyboard): event descriptor.
    *
-   * Launches a generic 'keyboard' namespace event.
+   * Launches a generic 'keyboard' namespace event, as
+   * soon as it is received. Only launched when
+   * #DsEvents:raw-events is set, see #DsEvents::batch.
    *
    */
   signals[sig_keyboard] =
@@ -299,6 +548,55 @@ ds_events_class_init(DsEventsClass* klass)
      G_TYPE_POINTER | G_SIGNAL_TYPE_STATIC_SCOPE,
      G_TYPE_NONE);
 
+  /**
+   * DsEvents::batch:
+   * @object: the #DsEvent object which launches the signal.
+   * @n_events: how many events are in @events.
+   * @events: (array length=n_events) (element-type Ds.EvEntry): events received this frame.
+   *
+   * Launches every event received during a frame at
+   * once, in arrival order, unless #DsEvents:raw-events
+   * is set. Cursor motion and scroll events are merged
+   * into one each, holding summed deltas and last position,
+   * at place first one arrived.
+   *
+   */
+  signals[sig_batch] =
+    g_signal_new
+    ("batch",
+     G_TYPE_FROM_CLASS(klass),
+     G_SIGNAL_RUN_FIRST,
+     0,
+     NULL,
+     NULL,
+     ds_cclosure_marshal_VOID__UINT_POINTER,
+     G_TYPE_NONE,
+     2,
+     G_TYPE_UINT,
+     G_TYPE_POINTER | G_SIGNAL_TYPE_STATIC_SCOPE,
+     G_TYPE_NONE);
+
+  /**
+   * DsEvents::replay-done:
+   * @object: the #DsEvent object which launches the signal.
+   *
+   * Emitted when an input log being replayed
+   * (see ds_events_replay()) runs out of events.
+   *
+   */
+  signals[sig_replay_done] =
+    g_signal_new
+    ("replay-done",
+     G_TYPE_FROM_CLASS(klass),
+     G_SIGNAL_RUN_LAST,
+     0,
+     NULL,
+     NULL,
+     g_cclosure_marshal_VOID__VOID,
+     G_TYPE_NONE,
+     0,
+     G_TYPE_NONE);
+
   g_signal_set_va_marshaller
   (signals[sig_cursor],
    G_TYPE_FROM_CLASS(klass),
@@ -309,6 +607,11 @@ ds_events_class_init(DsEventsClass* klass)
    G_TYPE_FROM_CLASS(klass),
    ds_cclosure_marshal_VOID__STRING_POINTERv);
 
+  g_signal_set_va_marshaller
+  (signals[sig_batch],
+   G_TYPE_FROM_CLASS(klass),
+   ds_cclosure_marshal_VOID__UINT_POINTERv);
+
   properties[prop_gsettings] =
     g_param_spec_object
     (_TRIPLET("gsettings"),
@@ -324,6 +627,13 @@ ds_events_class_init(DsEventsClass* klass)
      | G_PARAM_CONSTRUCT_ONLY
      | G_PARAM_STATIC_STRINGS);
 
+  properties[prop_raw_events] =
+    g_param_spec_boolean
+    (_TRIPLET("raw-events"),
+     FALSE,
+     G_PARAM_WRITABLE
+     | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties
   (oclass,
    prop_number,
@@ -333,6 +643,9 @@ ds_events_class_init(DsEventsClass* klass)
 static void
 ds_events_init(DsEvents* self)
 {
+  self->batch = g_array_new(FALSE, FALSE, sizeof(DsEvEntry));
+  self->motion_at = -1;
+  self->scroll_at = -1;
 }
 
 /*
@@ -386,6 +699,7 @@ push_(lua_State* L, int argc)
 #define EMIT(object,namespace,detail,event) \
   G_STMT_START { \
     GValue values[3] = {0}; \
+    gint64 script = g_get_monotonic_time(); \
     GQuark quark = ds_##namespace##_##detail##_quark(); \
     g_value_init(values + 0, DS_TYPE_EVENTS); \
     g_value_set_object(values + 0, (object)); \
@@ -394,6 +708,9 @@ push_(lua_State* L, int argc)
     g_value_init(values + 2, G_TYPE_POINTER); \
     g_value_set_pointer(values + 2, (event)); \
     g_signal_emitv(values, signals[ sig_##namespace ], quark, NULL); \
+    ds_frame_stats_add_script_time \
+    (ds_frame_stats_get_default(), \
+     g_get_monotonic_time() - script); \
     g_value_unset(values + 2); \
     g_value_unset(values + 1); \
     g_value_unset(values + 0); \
@@ -405,65 +722,268 @@ on_window_close(GLFWwindow* window)
   g_application_quit(g_application_get_default());
 }
 
+static void
+record_(DsEvents* self, Record* record)
+{
+  GError* tmp_err = NULL;
+
+  /*
+   * Events sampled between frames
+   * are delivered on next one, which
+   * is where replay must feed them
+   *
+   */
+
+  record->frame = self->frame - self->record_base;
+  if(self->stepping == FALSE)
+    record->frame += 1;
+
+  g_output_stream_write_all
+  (self->record,
+   record,
+   sizeof(Record),
+   NULL,
+   NULL,
+   &tmp_err);
+
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_warning
+    ("(%s: %i): %s: %i: %s\r\n",
+     G_STRFUNC,
+     __LINE__,
+     g_quark_to_string(tmp_err->domain),
+     tmp_err->code,
+     tmp_err->message);
+    g_error_free(tmp_err);
+    g_clear_object(&(self->record));
+  }
+}
+
+/*
+ * Unless raw events were requested, a
+ * frame worth of events is delivered
+ * at once, with motion and scroll merged
+ * into a single event each
+ *
+ */
+
+static inline DsEvEntry*
+batch_(DsEvents* self, gint* coalesce)
+{
+  GArray* batch = self->batch;
+  if(coalesce != NULL && *coalesce >= 0)
+    return &g_array_index(batch, DsEvEntry, *coalesce);
+  if(coalesce != NULL)
+    *coalesce = batch->len;
+
+  g_array_set_size(batch, batch->len + 1);
+return &g_array_index(batch, DsEvEntry, batch->len - 1);
+}
+
+static void
+flush_(DsEvents* self)
+{
+  gint64 script = g_get_monotonic_time();
+
+  g_signal_emit
+  (self,
+   signals[sig_batch],
+   0,
+   self->batch->len,
+   self->batch->data);
+
+  ds_frame_stats_add_script_time
+  (ds_frame_stats_get_default(),
+   g_get_monotonic_time() - script);
+
+  g_array_set_size(self->batch, 0);
+  self->motion_at = -1;
+  self->scroll_at = -1;
+}
+
+static void
+dispatch(DsEvents* self, const Record* record)
+{
+  gint64 timestamp = g_get_monotonic_time();
+  DsEvEntry* entry = NULL;
+  DsEvEntry value;
+
+  switch(record->kind)
+  {
+  case kind_cursor_motion:
+    {
+      gdouble x = record->d[0];
+      gdouble y = record->d[1];
+      gdouble dx = (x - self->x_prev) * self->x_fact;
+      gdouble dy = (y - self->y_prev) * self->y_fact;
+
+      self->x_prev = x;
+      self->y_prev = y;
+
+      if G_UNLIKELY(self->raw_events == TRUE)
+      {
+        value.data.cursor.motion.x = x;
+        value.data.cursor.motion.y = y;
+        value.data.cursor.motion.dx = dx;
+        value.data.cursor.motion.dy = dy;
+        EMIT(self, cursor, motion, &(value.data.cursor));
+      }
+      else
+      {
+        gboolean merge = (self->motion_at >= 0);
+
+        entry = batch_(self, &(self->motion_at));
+        entry->type = "cursor";
+        entry->detail = "motion";
+        entry->timestamp = (merge) ? entry->timestamp : timestamp;
+        entry->data.cursor.motion.x = x;
+        entry->data.cursor.motion.y = y;
+        entry->data.cursor.motion.dx = dx + ((merge) ? entry->data.cursor.motion.dx : 0.);
+        entry->data.cursor.motion.dy = dy + ((merge) ? entry->data.cursor.motion.dy : 0.);
+      }
+    }
+    break;
+  case kind_cursor_button:
+    {
+      entry = (self->raw_events) ? &value : batch_(self, NULL);
+      entry->type = "cursor";
+      entry->detail = "button";
+      entry->timestamp = timestamp;
+      entry->data.cursor.button.button = record->i[0];
+      entry->data.cursor.button.action = record->i[1];
+      entry->data.cursor.button.mods = record->i[2];
+
+      if G_UNLIKELY(self->raw_events == TRUE)
+        EMIT(self, cursor, button, &(value.data.cursor));
+    }
+    break;
+  case kind_cursor_scroll:
+    {
+      if G_UNLIKELY(self->raw_events == TRUE)
+      {
+        value.data.cursor.scroll.dx = record->d[0];
+        value.data.cursor.scroll.dy = record->d[1];
+        EMIT(self, cursor, scroll, &(value.data.cursor));
+      }
+      else
+      {
+        gboolean merge = (self->scroll_at >= 0);
+
+        entry = batch_(self, &(self->scroll_at));
+        entry->type = "cursor";
+        entry->detail = "scroll";
+        entry->timestamp = (merge) ? entry->timestamp : timestamp;
+        entry->data.cursor.scroll.dx = record->d[0] + ((merge) ? entry->data.cursor.scroll.dx : 0.);
+        entry->data.cursor.scroll.dy = record->d[1] + ((merge) ? entry->data.cursor.scroll.dy : 0.);
+      }
+    }
+    break;
+  case kind_keyboard_unichar:
+    {
+      entry = (self->raw_events) ? &value : batch_(self, NULL);
+      entry->type = "keyboard";
+      entry->detail = "unichar";
+      entry->timestamp = timestamp;
+      entry->data.keyboard.unichar.codepoint = record->i[0];
+
+      if G_UNLIKELY(self->raw_events == TRUE)
+        EMIT(self, keyboard, unichar, &(value.data.keyboard));
+    }
+    break;
+  case kind_keyboard_key:
+    {
+      entry = (self->raw_events) ? &value : batch_(self, NULL);
+      entry->type = "keyboard";
+      entry->detail = "key";
+      entry->timestamp = timestamp;
+      entry->data.keyboard.key.key = record->i[0];
+      entry->data.keyboard.key.scancode = record->i[1];
+      entry->data.keyboard.key.action = record->i[2];
+      entry->data.keyboard.key.mods = record->i[3];
+
+      if G_UNLIKELY(self->raw_events == TRUE)
+        EMIT(self, keyboard, key, &(value.data.keyboard));
+    }
+    break;
+  default:
+    g_warning("Unknown input record kind %i\r\n", record->kind);
+    break;
+  }
+}
+
+/*
+ * Live input goes through same path
+ * as replayed one, and it is ignored
+ * while a replay is running
+ *
+ */
+
+static inline void
+live_(DsEvents* self, Record* record)
+{
+  if G_UNLIKELY(self->replay != NULL)
+    return;
+  if G_UNLIKELY(self->record != NULL)
+    record_(self, record);
+  dispatch(self, record);
+}
+
 static void
 on_cursor_motion(GLFWwindow* window, double x, double y)
 {
-  DsEvents* self = this_(window);
-  DsEvCursorMotion value;
+  Record record = {0};
 
-  value.x = x;
-  value.y = y;
-  value.dx = (x - self->x_prev) * self->x_fact;
-  value.dy = (y - self->y_prev) * self->y_fact;
-  self->x_prev = x;
-  self->y_prev = y;
-EMIT(self, cursor, motion, &value);
+  record.kind = kind_cursor_motion;
+  record.d[0] = x;
+  record.d[1] = y;
+live_(this_(window), &record);
 }
 
 static void
 on_cursor_button(GLFWwindow* window, int button, int action, int mods)
 {
-  DsEvents* self = this_(window);
-  DsEvCursorButton value;
+  Record record = {0};
 
-  value.button = button;
-  value.action = action;
-  value.mods = mods;
-EMIT(self, cursor, button, &value);
+  record.kind = kind_cursor_button;
+  record.i[0] = button;
+  record.i[1] = action;
+  record.i[2] = mods;
+live_(this_(window), &record);
 }
 
 static void
 on_cursor_scroll(GLFWwindow* window, double x_offs, double y_offs)
 {
-  DsEvents* self = this_(window);
-  DsEvCursorScroll value;
+  Record record = {0};
 
-  value.dx = x_offs;
-  value.dy = y_offs;
-EMIT(self, cursor, scroll, &value);
+  record.kind = kind_cursor_scroll;
+  record.d[0] = x_offs;
+  record.d[1] = y_offs;
+live_(this_(window), &record);
 }
 
 static void
 on_keyboard_unichar(GLFWwindow* window, gunichar codepoint)
 {
-  DsEvents* self = this_(window);
-  DsEvKeyboardUnichar value;
+  Record record = {0};
 
-  value.codepoint = codepoint;
-EMIT(self, keyboard, unichar, &value);
+  record.kind = kind_keyboard_unichar;
+  record.i[0] = codepoint;
+live_(this_(window), &record);
 }
 
 static void
 on_keyboard_key(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-  DsEvents* self = this_(window);
-  DsEvKeyboardKey value;
-
-  value.key = key;
-  value.scancode = scancode;
-  value.action = action;
-  value.mods = mods;
-EMIT(self, keyboard, key, &value);
+  Record record = {0};
+
+  record.kind = kind_keyboard_key;
+  record.i[0] = key;
+  record.i[1] = scancode;
+  record.i[2] = action;
+  record.i[3] = mods;
+live_(this_(window), &record);
 }
 
 #undef EMIT
@@ -498,5 +1018,152 @@ ds_events_new(GSettings      *gsettings,
    error,
    "gsettings", gsettings,
    "window", window,
+   "phase", DS_FRAME_CLOCK_PHASE_INPUT,
    NULL);
 }
+
+/**
+ * ds_events_record:
+ * @events: a #DsEvents instance.
+ * @file: where to write input log.
+ * @cancellable: (nullable): a %GCancellable.
+ * @error: return location for a #GError.
+ *
+ * Starts recording every input event @events
+ * receives, along with frame it was received on,
+ * into @file (which is replaced). Recording stops
+ * when @events is disposed.
+ *
+ * Returns: TRUE on success, FALSE otherwise.
+ */
+gboolean
+ds_events_record(DsEvents      *events,
+                 GFile         *file,
+                 GCancellable  *cancellable,
+                 GError       **error)
+{
+  g_return_val_if_fail(DS_IS_EVENTS(events), FALSE);
+  g_return_val_if_fail(G_IS_FILE(file), FALSE);
+  g_return_val_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable), FALSE);
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+  DsEvents* self = events;
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GFileOutputStream* stream = NULL;
+  GOutputStream* buffered = NULL;
+  LogHeader header = {0};
+
+  stream =
+  g_file_replace(file, NULL, FALSE, G_FILE_CREATE_NONE, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  buffered =
+  g_buffered_output_stream_new(G_OUTPUT_STREAM(stream));
+
+  memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+  header.version = LOG_VERSION;
+  header.interval = ds_frame_clock_get_interval(ds_frame_clock_get_default());
+
+  success =
+  g_output_stream_write_all(buffered, &header, sizeof(header), NULL, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  g_set_object(&(self->record), buffered);
+  self->record_base = self->frame;
+
+_error_:
+  _g_object_unref0(buffered);
+  _g_object_unref0(stream);
+return success;
+}
+
+/**
+ * ds_events_replay:
+ * @events: a #DsEvents instance.
+ * @file: input log to replay.
+ * @interval: (out) (optional): frame interval log was recorded with, in microseconds.
+ * @n_frames: (out) (optional): frames log spans.
+ * @cancellable: (nullable): a %GCancellable.
+ * @error: return location for a #GError.
+ *
+ * Feeds events recorded with ds_events_record()
+ * back, on same frames (counted from now on) they
+ * were recorded on. Live input is ignored meanwhile.
+ * #DsEvents::replay-done is emitted once log is over.
+ *
+ * Returns: TRUE on success, FALSE otherwise.
+ */
+gboolean
+ds_events_replay(DsEvents      *events,
+                 GFile         *file,
+                 gint64        *interval,
+                 guint         *n_frames,
+                 GCancellable  *cancellable,
+                 GError       **error)
+{
+  g_return_val_if_fail(DS_IS_EVENTS(events), FALSE);
+  g_return_val_if_fail(G_IS_FILE(file), FALSE);
+  g_return_val_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable), FALSE);
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+  DsEvents* self = events;
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GBytes* bytes = NULL;
+  const LogHeader* header;
+  const Record* last;
+  gsize length;
+
+  bytes =
+  g_file_load_bytes(file, cancellable, NULL, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  header = g_bytes_get_data(bytes, &length);
+  if G_UNLIKELY
+    (length < sizeof(LogHeader)
+     || memcmp(header->magic, LOG_MAGIC, sizeof(header->magic)) != 0
+     || header->version != LOG_VERSION
+     || (length - sizeof(LogHeader)) % sizeof(Record) != 0)
+  {
+    g_set_error_literal
+    (error,
+     G_IO_ERROR,
+     G_IO_ERROR_INVALID_DATA,
+     "Not an input log or unsupported version\r\n");
+    goto_error();
+  }
+
+  if(interval != NULL)
+    *interval = header->interval;
+
+  if(n_frames != NULL)
+  {
+    /* records come in frame order */
+    last = (const Record*) ((const guint8*) header + length) - 1;
+    *n_frames = (length > sizeof(LogHeader)) ? last->frame + 1 : 0;
+  }
+
+  g_clear_pointer(&(self->replay), g_bytes_unref);
+  self->replay =
+  g_bytes_new_from_bytes
+  (bytes,
+   sizeof(LogHeader),
+   length - sizeof(LogHeader));
+  self->replay_at = 0;
+  self->replay_base = self->frame;
+
+_error_:
+  g_clear_pointer(&bytes, g_bytes_unref);
+return success;
+}
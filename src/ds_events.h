@@ -44,6 +44,20 @@ ds_events_new(GSettings      *gsettings,
               gpointer        window,
               GCancellable   *cancellable,
               GError        **error);
+DEUSEXMAKINA2_API
+gboolean
+ds_events_record(DsEvents      *events,
+                 GFile         *file,
+                 GCancellable  *cancellable,
+                 GError       **error);
+DEUSEXMAKINA2_API
+gboolean
+ds_events_replay(DsEvents      *events,
+                 GFile         *file,
+                 gint64        *interval,
+                 guint         *n_frames,
+                 GCancellable  *cancellable,
+                 GError       **error);
 
 #if __cplusplus
 }
@@ -0,0 +1,437 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <ds_frame_clock.h>
+#include <ds_macros.h>
+#ifdef HAVE_SYS_TIMERFD_H
+# include <errno.h>
+# include <glib-unix.h>
+# include <sys/timerfd.h>
+# include <unistd.h>
+#endif // HAVE_SYS_TIMERFD_H
+
+/**
+ * SECTION:dsframeclock
+ * @Short_description: Frame pacing source
+ * @Title: DsFrameClock
+ *
+ * DsFrameClock is a #GSource which wakes up once per
+ * frame interval, and dispatches its handlers ordered
+ * by #DsFrameClockPhase (input, then update, then render).
+ * Between ticks main loop sleeps, instead of spinning
+ * as an idle source would. A clock without handlers
+ * does not wakes at all.
+ *
+ */
+
+typedef struct _Handler Handler;
+
+/*
+ * Object definition
+ *
+ */
+
+struct _DsFrameClock
+{
+  GSource parent_source;
+
+  /*<private>*/
+  gint64 interval;
+  gint64 next;
+  guint n_handlers;
+  guint last_id;
+  gboolean dispatching;
+  GList* handlers[DS_FRAME_CLOCK_N_PHASES];
+
+  /*<private>*/
+#ifdef HAVE_SYS_TIMERFD_H
+  gint timerfd;
+  gpointer tag;
+#endif // HAVE_SYS_TIMERFD_H
+};
+
+struct _Handler
+{
+  guint id;
+  GSourceFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+};
+
+static void
+handler_free(Handler* handler)
+{
+  if(handler->notify != NULL)
+    handler->notify(handler->user_data);
+  g_slice_free(Handler, handler);
+}
+
+/*
+ * Timer
+ *
+ */
+
+static void
+rearm(DsFrameClock* clock)
+{
+  gboolean armed =
+     clock->n_handlers > 0
+  && clock->interval > 0;
+
+  clock->next =
+  g_get_monotonic_time()
+  + clock->interval;
+
+#ifdef HAVE_SYS_TIMERFD_H
+  if G_LIKELY(clock->timerfd >= 0)
+  {
+    struct itimerspec spec = {0};
+    if(armed == TRUE)
+    {
+      spec.it_interval.tv_sec = clock->interval / G_USEC_PER_SEC;
+      spec.it_interval.tv_nsec = (clock->interval % G_USEC_PER_SEC) * 1000;
+      spec.it_value = spec.it_interval;
+    }
+
+    timerfd_settime(clock->timerfd, 0, &spec, NULL);
+    return;
+  }
+#endif // HAVE_SYS_TIMERFD_H
+
+  g_source_set_ready_time
+  ((GSource*) clock,
+   (armed == TRUE)
+   ? clock->next
+   : -1);
+}
+
+/*
+ * Source functions
+ *
+ */
+
+static gboolean
+ds_frame_clock_dispatch(GSource      *source,
+                        GSourceFunc   callback,
+                        gpointer      user_data)
+{
+  DsFrameClock* clock = (DsFrameClock*) source;
+  Handler* handler = NULL;
+  GList* list = NULL;
+  GList* next = NULL;
+  guint i;
+
+#ifdef HAVE_SYS_TIMERFD_H
+  if G_LIKELY(clock->timerfd >= 0)
+  {
+    guint64 expirations;
+    if(read(clock->timerfd, &expirations, sizeof(expirations)) < 0)
+    {
+      if G_UNLIKELY(errno != EAGAIN)
+        g_warning("read(): failed!: %s\r\n", g_strerror(errno));
+      return G_SOURCE_CONTINUE;
+    }
+  }
+  else
+#endif // HAVE_SYS_TIMERFD_H
+  {
+    /*
+     * Keep cadence, but do not try
+     * to catch up missed frames
+     *
+     */
+
+    gint64 now = g_get_monotonic_time();
+    clock->next += clock->interval;
+    if G_UNLIKELY(clock->next <= now)
+      clock->next = now + clock->interval;
+    g_source_set_ready_time(source, clock->next);
+  }
+
+/*
+ * Dispatch phases
+ *
+ */
+
+  clock->dispatching = TRUE;
+
+  for(i = 0;
+      i < DS_FRAME_CLOCK_N_PHASES;
+      i++)
+  for(list = clock->handlers[i];
+      list != NULL;
+      list = next)
+  {
+    next = list->next;
+    handler = list->data;
+
+    /* removed while dispatching */
+    if G_UNLIKELY(handler->func == NULL)
+      continue;
+
+    if(handler->func(handler->user_data) == G_SOURCE_REMOVE)
+    {
+      ds_frame_clock_remove_handler(clock, handler->id);
+    }
+  }
+
+  clock->dispatching = FALSE;
+
+/*
+ * Collect removed handlers
+ *
+ */
+
+  for(i = 0;
+      i < DS_FRAME_CLOCK_N_PHASES;
+      i++)
+  for(list = clock->handlers[i];
+      list != NULL;
+      list = next)
+  {
+    next = list->next;
+    handler = list->data;
+
+    if(handler->func == NULL)
+    {
+      clock->handlers[i] = g_list_delete_link(clock->handlers[i], list);
+      handler_free(handler);
+    }
+  }
+return G_SOURCE_CONTINUE;
+}
+
+static void
+ds_frame_clock_finalize(GSource* source)
+{
+  DsFrameClock* clock = (DsFrameClock*) source;
+  guint i;
+
+  for(i = 0;
+      i < DS_FRAME_CLOCK_N_PHASES;
+      i++)
+  {
+    g_list_free_full
+    (clock->handlers[i],
+     (GDestroyNotify)
+     handler_free);
+    clock->handlers[i] = NULL;
+  }
+
+#ifdef HAVE_SYS_TIMERFD_H
+  if G_LIKELY(clock->timerfd >= 0)
+  {
+    close(clock->timerfd);
+    clock->timerfd = -1;
+  }
+#endif // HAVE_SYS_TIMERFD_H
+}
+
+static GSourceFuncs
+ds_frame_clock_funcs =
+{
+  NULL,
+  NULL,
+  ds_frame_clock_dispatch,
+  ds_frame_clock_finalize,
+};
+
+/*
+ * Object methods
+ *
+ */
+
+/**
+ * ds_frame_clock_new: (skip)
+ * @interval: frame interval, in microseconds.
+ *
+ * Creates a new frame clock. It should be attached
+ * to a #GMainContext with g_source_attach().
+ *
+ * Returns: (transfer full): a new #DsFrameClock.
+ */
+DsFrameClock*
+ds_frame_clock_new(gint64 interval)
+{
+  g_return_val_if_fail(interval >= 0, NULL);
+
+  GSource* source =
+  g_source_new(&ds_frame_clock_funcs, sizeof(DsFrameClock));
+  DsFrameClock* clock = (DsFrameClock*) source;
+
+  g_source_set_name(source, "(Source) DsFrameClock");
+  g_source_set_priority(source, G_PRIORITY_DEFAULT);
+
+  clock->interval = interval;
+
+#ifdef HAVE_SYS_TIMERFD_H
+  clock->timerfd =
+  timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if G_LIKELY(clock->timerfd >= 0)
+    clock->tag = g_source_add_unix_fd(source, clock->timerfd, G_IO_IN);
+  else
+    g_warning("timerfd_create(): failed!: %s\r\n", g_strerror(errno));
+#endif // HAVE_SYS_TIMERFD_H
+
+  rearm(clock);
+return clock;
+}
+
+/**
+ * ds_frame_clock_get_default: (skip)
+ *
+ * Gets frame clock attached to global-default
+ * main context, creating it if needed.
+ *
+ * Returns: (transfer none): a #DsFrameClock.
+ */
+DsFrameClock*
+ds_frame_clock_get_default()
+{
+  static DsFrameClock* clock = NULL;
+  if(g_once_init_enter(&clock))
+  {
+    DsFrameClock* clock_ =
+    ds_frame_clock_new(DS_FRAME_CLOCK_DEFAULT_INTERVAL);
+    g_source_attach((GSource*) clock_, NULL);
+    g_once_init_leave(&clock, clock_);
+  }
+return clock;
+}
+
+/**
+ * ds_frame_clock_set_interval: (skip)
+ * @clock: a #DsFrameClock.
+ * @interval: frame interval, in microseconds.
+ *
+ * Sets frame interval (1 / frame rate). Zero
+ * interval stops clock.
+ *
+ */
+void
+ds_frame_clock_set_interval(DsFrameClock  *clock,
+                            gint64         interval)
+{
+  g_return_if_fail(clock != NULL);
+  g_return_if_fail(interval >= 0);
+
+  if(clock->interval != interval)
+  {
+    clock->interval = interval;
+    rearm(clock);
+  }
+}
+
+/**
+ * ds_frame_clock_get_interval: (skip)
+ * @clock: a #DsFrameClock.
+ *
+ * Gets frame interval.
+ *
+ * Returns: frame interval, in microseconds.
+ */
+gint64
+ds_frame_clock_get_interval(DsFrameClock  *clock)
+{
+  g_return_val_if_fail(clock != NULL, 0);
+return clock->interval;
+}
+
+/**
+ * ds_frame_clock_add_handler: (skip)
+ * @clock: a #DsFrameClock.
+ * @phase: phase on which @func is dispatched.
+ * @func: function to call on every frame.
+ * @user_data: data to pass to @func.
+ * @notify: (nullable): function to call when handler is removed.
+ *
+ * Adds @func to be called on @phase of every frame,
+ * until it returns %G_SOURCE_REMOVE or it is removed
+ * with #ds_frame_clock_remove_handler().
+ *
+ * Returns: handler id.
+ */
+guint
+ds_frame_clock_add_handler(DsFrameClock      *clock,
+                           DsFrameClockPhase  phase,
+                           GSourceFunc        func,
+                           gpointer           user_data,
+                           GDestroyNotify     notify)
+{
+  g_return_val_if_fail(clock != NULL, 0);
+  g_return_val_if_fail(phase < DS_FRAME_CLOCK_N_PHASES, 0);
+  g_return_val_if_fail(func != NULL, 0);
+
+  Handler* handler = g_slice_new(Handler);
+  handler->id = ++clock->last_id;
+  handler->func = func;
+  handler->user_data = user_data;
+  handler->notify = notify;
+
+  clock->handlers[phase] =
+  g_list_append(clock->handlers[phase], handler);
+
+  if(clock->n_handlers++ == 0)
+    rearm(clock);
+return handler->id;
+}
+
+/**
+ * ds_frame_clock_remove_handler: (skip)
+ * @clock: a #DsFrameClock.
+ * @handler_id: id returned by #ds_frame_clock_add_handler().
+ *
+ * Removes a handler from @clock.
+ *
+ */
+void
+ds_frame_clock_remove_handler(DsFrameClock  *clock,
+                              guint          handler_id)
+{
+  g_return_if_fail(clock != NULL);
+  g_return_if_fail(handler_id > 0);
+  Handler* handler = NULL;
+  GList* list = NULL;
+  guint i;
+
+  for(i = 0;
+      i < DS_FRAME_CLOCK_N_PHASES;
+      i++)
+  for(list = clock->handlers[i];
+      list != NULL;
+      list = list->next)
+  {
+    handler = list->data;
+    if(handler->id != handler_id || handler->func == NULL)
+      continue;
+
+    if(clock->dispatching == TRUE)
+      handler->func = NULL;
+    else
+    {
+      clock->handlers[i] = g_list_delete_link(clock->handlers[i], list);
+      handler_free(handler);
+    }
+
+    if(--clock->n_handlers == 0)
+      rearm(clock);
+    return;
+  }
+
+  g_warning("Attempt to remove an inexistent handler\r\n");
+}
@@ -0,0 +1,88 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __DS_FRAME_CLOCK_INCLUDED__
+#define __DS_FRAME_CLOCK_INCLUDED__ 1
+#include <ds_export.h>
+#include <glib-object.h>
+
+/**
+ * DsFrameClockPhase:
+ * @DS_FRAME_CLOCK_PHASE_INPUT: input is gathered.
+ * @DS_FRAME_CLOCK_PHASE_UPDATE: game state is updated.
+ * @DS_FRAME_CLOCK_PHASE_RENDER: game state is rendered.
+ *
+ * Phases a frame is divided on. Every phase
+ * handler is dispatched in this order on each
+ * frame clock tick.
+ */
+typedef enum
+{
+  DS_FRAME_CLOCK_PHASE_INPUT,
+  DS_FRAME_CLOCK_PHASE_UPDATE,
+  DS_FRAME_CLOCK_PHASE_RENDER,
+} DsFrameClockPhase;
+
+#define DS_FRAME_CLOCK_N_PHASES (DS_FRAME_CLOCK_PHASE_RENDER + 1)
+
+/**
+ * DS_FRAME_CLOCK_DEFAULT_INTERVAL:
+ *
+ * Default frame interval, in microseconds.
+ */
+#define DS_FRAME_CLOCK_DEFAULT_INTERVAL (G_USEC_PER_SEC / 60)
+
+typedef struct _DsFrameClock DsFrameClock;
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+DEUSEXMAKINA2_API
+GType
+ds_frame_clock_phase_get_type();
+
+DEUSEXMAKINA2_API
+DsFrameClock*
+ds_frame_clock_new(gint64 interval);
+DEUSEXMAKINA2_API
+DsFrameClock*
+ds_frame_clock_get_default();
+DEUSEXMAKINA2_API
+void
+ds_frame_clock_set_interval(DsFrameClock  *clock,
+                            gint64         interval);
+DEUSEXMAKINA2_API
+gint64
+ds_frame_clock_get_interval(DsFrameClock  *clock);
+DEUSEXMAKINA2_API
+guint
+ds_frame_clock_add_handler(DsFrameClock      *clock,
+                           DsFrameClockPhase  phase,
+                           GSourceFunc        func,
+                           gpointer           user_data,
+                           GDestroyNotify     notify);
+DEUSEXMAKINA2_API
+void
+ds_frame_clock_remove_handler(DsFrameClock  *clock,
+                              guint          handler_id);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __DS_FRAME_CLOCK_INCLUDED__
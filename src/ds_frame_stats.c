@@ -0,0 +1,462 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <ds_frame_stats.h>
+#include <ds_macros.h>
+#include <math.h>
+
+/**
+ * SECTION:dsframestats
+ * @Short_description: Frame time statistics
+ * @Title: DsFrameStats
+ *
+ * DsFrameStats keeps a ring of last frame records,
+ * written by renderer and readable from any thread
+ * without locking. Each slot is guarded by a sequence
+ * counter (odd while it is being written), so readers
+ * just skip slots which change under their feet.
+ *
+ * Queries sort nothing but a copy of a single metric,
+ * using selection, so they are cheap enough to be
+ * called every frame from Lua.
+ *
+ */
+
+typedef struct _Slot Slot;
+
+/*
+ * Object definition
+ *
+ */
+
+struct _Slot
+{
+  gint seq;
+  gint64 timestamp;
+  gint32 values[DS_FRAME_METRIC_N];
+};
+
+struct _DsFrameStats
+{
+  gint refs;
+  guint mask;
+  guint head;
+  gint script;
+  Slot slots[];
+};
+
+G_DEFINE_BOXED_TYPE
+(DsFrameStats,
+ ds_frame_stats,
+ ds_frame_stats_ref,
+ ds_frame_stats_unref);
+
+/*
+ * Helpers
+ *
+ */
+
+static guint
+snapshot(DsFrameStats  *stats,
+         DsFrameMetric  metric,
+         gint32        *values)
+{
+  guint head = g_atomic_int_get(&(stats->head));
+  guint size = stats->mask + 1;
+  guint n = MIN(head, size);
+  guint i, count = 0;
+  Slot* slot;
+  gint seq;
+
+  for(i = head - n;
+      i != head;
+      i++)
+  {
+    slot = &(stats->slots[i & stats->mask]);
+    seq = g_atomic_int_get(&(slot->seq));
+    if G_UNLIKELY(seq & 1)
+      continue;
+
+    values[count] = slot->values[metric];
+
+    /* overwritten while reading */
+    if G_UNLIKELY(g_atomic_int_get(&(slot->seq)) != seq)
+      continue;
+    ++count;
+  }
+return count;
+}
+
+static gint32
+select_nth(gint32* values, guint n, guint k)
+{
+  gint lo = 0, hi = n - 1;
+  gint i, store;
+  gint32 pivot, tmp;
+
+#define swap(a,b) G_STMT_START { tmp = (a); (a) = (b); (b) = tmp; } G_STMT_END
+
+  while(lo < hi)
+  {
+    i = lo + (hi - lo) / 2;
+    pivot = values[i];
+    swap(values[i], values[hi]);
+
+    for(i = lo, store = lo;
+        i < hi;
+        i++)
+    if(values[i] < pivot)
+    {
+      swap(values[i], values[store]);
+      ++store;
+    }
+
+    swap(values[store], values[hi]);
+
+    if(store == (gint) k)
+      break;
+    else
+    if(store < (gint) k)
+      lo = store + 1;
+    else
+      hi = store - 1;
+  }
+
+#undef swap
+return values[k];
+}
+
+/*
+ * Object methods
+ *
+ */
+
+/**
+ * ds_frame_stats_new: (constructor)
+ * @size: how many frames to keep (rounded up to a power of two).
+ *
+ * Creates a new frame statistics ring.
+ *
+ * Returns: (transfer full): a new #DsFrameStats.
+ */
+DsFrameStats*
+ds_frame_stats_new(guint size)
+{
+  g_return_val_if_fail(size > 0, NULL);
+
+  guint bits = g_bit_storage(size - 1);
+  guint real = 1 << bits;
+
+  DsFrameStats* stats =
+  g_malloc0(sizeof(DsFrameStats) + sizeof(Slot) * real);
+  stats->refs = 1;
+  stats->mask = real - 1;
+return stats;
+}
+
+/**
+ * ds_frame_stats_get_default:
+ *
+ * Gets process-wide frame statistics, the
+ * ones #DsRenderer records into.
+ *
+ * Returns: (transfer none): a #DsFrameStats.
+ */
+DsFrameStats*
+ds_frame_stats_get_default()
+{
+  static DsFrameStats* stats = NULL;
+  if(g_once_init_enter(&stats))
+  {
+    DsFrameStats* stats_ =
+    ds_frame_stats_new(DS_FRAME_STATS_DEFAULT_SIZE);
+    g_once_init_leave(&stats, stats_);
+  }
+return stats;
+}
+
+/**
+ * ds_frame_stats_ref:
+ * @stats: a #DsFrameStats.
+ *
+ * Increments @stats reference count.
+ *
+ * Returns: (transfer full): @stats.
+ */
+DsFrameStats*
+ds_frame_stats_ref(DsFrameStats* stats)
+{
+  g_return_val_if_fail(stats != NULL, NULL);
+  g_atomic_int_inc(&(stats->refs));
+return stats;
+}
+
+/**
+ * ds_frame_stats_unref:
+ * @stats: (transfer full): a #DsFrameStats.
+ *
+ * Decrements @stats reference count, freeing
+ * it when it reaches zero.
+ *
+ */
+void
+ds_frame_stats_unref(DsFrameStats* stats)
+{
+  g_return_if_fail(stats != NULL);
+  if(g_atomic_int_dec_and_test(&(stats->refs)))
+    g_free(stats);
+}
+
+/**
+ * ds_frame_stats_push: (skip)
+ * @stats: a #DsFrameStats.
+ * @frame: frame CPU time, in microseconds.
+ * @execute: pipeline execution time, in microseconds.
+ * @swap: presentation time, in microseconds.
+ * @wait: time waited on frames in flight, in microseconds.
+ *
+ * Records a frame. Script time accumulated since
+ * last call is recorded along. There should be a
+ * single writer at a time.
+ *
+ */
+void
+ds_frame_stats_push(DsFrameStats  *stats,
+                    gint64         frame,
+                    gint64         execute,
+                    gint64         swap,
+                    gint64         wait)
+{
+  g_return_if_fail(stats != NULL);
+  guint head = stats->head;
+  Slot* slot = &(stats->slots[head & stats->mask]);
+  gint script;
+
+  script = (gint) _ds_frame_stats_take_script_time(stats);
+
+  g_atomic_int_inc(&(slot->seq));
+
+  slot->timestamp = g_get_monotonic_time();
+  slot->values[DS_FRAME_METRIC_FRAME] = (gint32) frame;
+  slot->values[DS_FRAME_METRIC_EXECUTE] = (gint32) execute;
+  slot->values[DS_FRAME_METRIC_SWAP] = (gint32) swap;
+  slot->values[DS_FRAME_METRIC_SCRIPT] = script;
+  slot->values[DS_FRAME_METRIC_WAIT] = (gint32) wait;
+
+  g_atomic_int_inc(&(slot->seq));
+  g_atomic_int_set(&(stats->head), head + 1);
+}
+
+/**
+ * ds_frame_stats_add_script_time: (skip)
+ * @stats: a #DsFrameStats.
+ * @elapsed: time spent on scripts, in microseconds.
+ *
+ * Accounts time spent on Lua handlers, which is
+ * recorded with next frame. Can be called from
+ * any thread.
+ *
+ */
+void
+ds_frame_stats_add_script_time(DsFrameStats  *stats,
+                               gint64         elapsed)
+{
+  g_return_if_fail(stats != NULL);
+  g_atomic_int_add(&(stats->script), (gint) elapsed);
+}
+
+/**
+ * ds_frame_stats_get_count:
+ * @stats: a #DsFrameStats.
+ *
+ * Gets how many frames are currently kept.
+ *
+ * Returns: frames kept.
+ */
+guint
+ds_frame_stats_get_count(DsFrameStats* stats)
+{
+  g_return_val_if_fail(stats != NULL, 0);
+  guint head = g_atomic_int_get(&(stats->head));
+return MIN(head, stats->mask + 1);
+}
+
+/**
+ * ds_frame_stats_get_total:
+ * @stats: a #DsFrameStats.
+ *
+ * Gets how many frames were recorded since
+ * @stats was created, including those which
+ * no longer are kept.
+ *
+ * Returns: frames recorded.
+ */
+guint
+ds_frame_stats_get_total(DsFrameStats* stats)
+{
+  g_return_val_if_fail(stats != NULL, 0);
+return g_atomic_int_get(&(stats->head));
+}
+
+/**
+ * ds_frame_stats_percentile:
+ * @stats: a #DsFrameStats.
+ * @metric: which measurement to query.
+ * @percentile: percentile to query, from 0 to 100.
+ *
+ * Gets @percentile (nearest rank) of @metric
+ * over frames kept.
+ *
+ * Returns: value in milliseconds, zero if there is no frames yet.
+ */
+gdouble
+ds_frame_stats_percentile(DsFrameStats  *stats,
+                          DsFrameMetric  metric,
+                          gdouble        percentile)
+{
+  g_return_val_if_fail(stats != NULL, 0.);
+  g_return_val_if_fail(metric < DS_FRAME_METRIC_N, 0.);
+  g_return_val_if_fail(percentile >= 0. && percentile <= 100., 0.);
+  gint32* values = NULL;
+  gdouble result = 0.;
+  guint count, k;
+
+  /* ring may be large, keep it off stack */
+  values = g_new(gint32, stats->mask + 1);
+  count = snapshot(stats, metric, values);
+  if G_UNLIKELY(count == 0)
+    goto _error_;
+
+  /* nearest rank: ceil(p * n), one-based */
+  k = (guint) ceil((percentile / 100.) * count);
+  k = CLAMP(k, 1, count) - 1;
+  result = (gdouble) select_nth(values, count, k) / 1000.;
+
+_error_:
+  g_free(values);
+return result;
+}
+
+/**
+ * ds_frame_stats_max:
+ * @stats: a #DsFrameStats.
+ * @metric: which measurement to query.
+ *
+ * Gets worst @metric over frames kept.
+ *
+ * Returns: value in milliseconds, zero if there is no frames yet.
+ */
+gdouble
+ds_frame_stats_max(DsFrameStats  *stats,
+                   DsFrameMetric  metric)
+{
+  g_return_val_if_fail(stats != NULL, 0.);
+  g_return_val_if_fail(metric < DS_FRAME_METRIC_N, 0.);
+  gint32* values = g_new(gint32, stats->mask + 1);
+  gint32 max = 0;
+  guint i, count;
+
+  count = snapshot(stats, metric, values);
+  for(i = 0;
+      i < count;
+      i++)
+  if(values[i] > max)
+    max = values[i];
+
+  g_free(values);
+return (gdouble) max / 1000.;
+}
+
+/**
+ * ds_frame_stats_dump_csv:
+ * @stats: a #DsFrameStats.
+ * @filename: (type filename): where to write.
+ * @error: return location for a #GError.
+ *
+ * Writes frames kept to @filename as CSV, oldest
+ * first, one row per frame. Times are written in
+ * microseconds.
+ *
+ * Returns: TRUE on success, FALSE otherwise.
+ */
+gboolean
+ds_frame_stats_dump_csv(DsFrameStats  *stats,
+                        const gchar   *filename,
+                        GError       **error)
+{
+  g_return_val_if_fail(stats != NULL, FALSE);
+  g_return_val_if_fail(filename != NULL, FALSE);
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+  guint head = g_atomic_int_get(&(stats->head));
+  guint n = MIN(head, stats->mask + 1);
+  gboolean success = TRUE;
+  GString* csv = NULL;
+  Slot copy, *slot;
+  gint seq;
+  guint i;
+
+  csv = g_string_sized_new(64 * (n + 1));
+  g_string_append(csv, "timestamp,frame,execute,swap,script,wait\n");
+
+  for(i = head - n;
+      i != head;
+      i++)
+  {
+    slot = &(stats->slots[i & stats->mask]);
+    seq = g_atomic_int_get(&(slot->seq));
+    if G_UNLIKELY(seq & 1)
+      continue;
+
+    memcpy(&copy, slot, sizeof(Slot));
+    if G_UNLIKELY(g_atomic_int_get(&(slot->seq)) != seq)
+      continue;
+
+    g_string_append_printf
+    (csv,
+     "%" G_GINT64_FORMAT ",%i,%i,%i,%i,%i\n",
+     copy.timestamp,
+     copy.values[DS_FRAME_METRIC_FRAME],
+     copy.values[DS_FRAME_METRIC_EXECUTE],
+     copy.values[DS_FRAME_METRIC_SWAP],
+     copy.values[DS_FRAME_METRIC_SCRIPT],
+     copy.values[DS_FRAME_METRIC_WAIT]);
+  }
+
+  success =
+  g_file_set_contents(filename, csv->str, csv->len, error);
+  g_string_free(csv, TRUE);
+return success;
+}
+
+/*
+ * Takes script time accounted on @stats
+ * and not yet recorded, so it can be
+ * moved to another ring
+ *
+ */
+G_GNUC_INTERNAL
+gint64
+_ds_frame_stats_take_script_time(DsFrameStats* stats)
+{
+  gint script;
+
+  do
+    script = g_atomic_int_get(&(stats->script));
+  while(!g_atomic_int_compare_and_exchange(&(stats->script), script, 0));
+return script;
+}
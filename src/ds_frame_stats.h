@@ -0,0 +1,129 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __DS_FRAME_STATS_INCLUDED__
+#define __DS_FRAME_STATS_INCLUDED__ 1
+#include <ds_export.h>
+#include <glib-object.h>
+
+#define DS_TYPE_FRAME_STATS (ds_frame_stats_get_type())
+
+/**
+ * DsFrameMetric:
+ * @DS_FRAME_METRIC_FRAME: CPU time spent on whole frame.
+ * @DS_FRAME_METRIC_EXECUTE: time spent executing pipeline.
+ * @DS_FRAME_METRIC_SWAP: time spent presenting frame.
+ * @DS_FRAME_METRIC_SCRIPT: time spent on Lua handlers since last frame.
+ * @DS_FRAME_METRIC_WAIT: time spent waiting for GPU to catch up before frame.
+ *
+ * Per-frame measurements kept by #DsFrameStats.
+ */
+typedef enum
+{
+  DS_FRAME_METRIC_FRAME,
+  DS_FRAME_METRIC_EXECUTE,
+  DS_FRAME_METRIC_SWAP,
+  DS_FRAME_METRIC_SCRIPT,
+  DS_FRAME_METRIC_WAIT,
+} DsFrameMetric;
+
+#define DS_FRAME_METRIC_N (DS_FRAME_METRIC_WAIT + 1)
+
+/**
+ * DS_FRAME_STATS_DEFAULT_SIZE:
+ *
+ * Frames kept by default frame statistics.
+ */
+#define DS_FRAME_STATS_DEFAULT_SIZE (1024)
+
+/**
+ * DS_FRAME_STATS_CSV_ENV:
+ *
+ * Environment variable which, when set, holds
+ * a path where renderer dumps its own frame
+ * statistics (see ds_renderer_get_frame_stats())
+ * when it is finalized.
+ */
+#define DS_FRAME_STATS_CSV_ENV "DS_FRAME_STATS_CSV"
+
+typedef struct _DsFrameStats DsFrameStats;
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+DEUSEXMAKINA2_API
+GType
+ds_frame_metric_get_type();
+DEUSEXMAKINA2_API
+GType
+ds_frame_stats_get_type();
+
+DEUSEXMAKINA2_API
+DsFrameStats*
+ds_frame_stats_new(guint size);
+DEUSEXMAKINA2_API
+DsFrameStats*
+ds_frame_stats_get_default();
+DEUSEXMAKINA2_API
+DsFrameStats*
+ds_frame_stats_ref(DsFrameStats* stats);
+DEUSEXMAKINA2_API
+void
+ds_frame_stats_unref(DsFrameStats* stats);
+DEUSEXMAKINA2_API
+void
+ds_frame_stats_push(DsFrameStats  *stats,
+                    gint64         frame,
+                    gint64         execute,
+                    gint64         swap,
+                    gint64         wait);
+DEUSEXMAKINA2_API
+void
+ds_frame_stats_add_script_time(DsFrameStats  *stats,
+                               gint64         elapsed);
+DEUSEXMAKINA2_API
+guint
+ds_frame_stats_get_count(DsFrameStats* stats);
+DEUSEXMAKINA2_API
+guint
+ds_frame_stats_get_total(DsFrameStats* stats);
+DEUSEXMAKINA2_API
+gdouble
+ds_frame_stats_percentile(DsFrameStats  *stats,
+                          DsFrameMetric  metric,
+                          gdouble        percentile);
+DEUSEXMAKINA2_API
+gdouble
+ds_frame_stats_max(DsFrameStats  *stats,
+                   DsFrameMetric  metric);
+DEUSEXMAKINA2_API
+gboolean
+ds_frame_stats_dump_csv(DsFrameStats  *stats,
+                        const gchar   *filename,
+                        GError       **error);
+
+/* Internal API */
+G_GNUC_INTERNAL
+gint64
+_ds_frame_stats_take_script_time(DsFrameStats* stats);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __DS_FRAME_STATS_INCLUDED__
@@ -16,7 +16,7 @@
  *
  */
 #include <config.h>
-#include <ds_game_object.h>
+#include <ds_game_object_private.h>
 #include <ds_macros.h>
 #include <ds_marshals.h>
 #include <ds_model.h>
@@ -50,6 +50,14 @@ struct _DsGameObjectPrivate
   vec3 position;
   mat4 model;
 
+  /* previous simulation state */
+  vec3 scale_prev;
+  vec3 position_prev;
+
+  /* model matrix, as seen by GL thread */
+  mat4 frames[DS_GAME_OBJECT_SLOTS];
+  GList link;
+
   union
   {
     DsModel* model_;
@@ -68,12 +76,26 @@ GParamSpec* properties[prop_number] = {0};
 
 enum {
   sig_collide,
+  sig_update,
   sig_number,
 };
 
 static
 guint signals[sig_number] = {0};
 
+/*
+ * Render transforms: main thread copies
+ * every object model matrix into a frame
+ * slot, which is handed to GL thread as a
+ * whole (see DsRenderer frame state), so
+ * it never reads a matrix being written
+ *
+ */
+
+static GQueue live = G_QUEUE_INIT;
+G_LOCK_DEFINE_STATIC(live);
+static guint read_slot = 0;
+
 G_DEFINE_TYPE_WITH_CODE
 (DsGameObject,
  ds_game_object,
@@ -86,60 +108,54 @@ G_DEFINE_TYPE_WITH_CODE
  (DS_TYPE_MVP_HOLDER,
   ds_game_object_ds_mvp_holder_iface_init));
 
+static void
+update_model_frame(JitMvps* mvps, DsGameObjectPrivate* priv)
+{
+  _ds_jit_helper_update_model(mvps, priv->frames[read_slot]);
+}
+
 static gboolean
-ds_game_object_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
+ds_game_object_ds_renderable_iface_plan(DsRenderable* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
 {
   gboolean success = TRUE;
   GError* tmp_err = NULL;
   DsGameObjectPrivate* priv =
   ((DsGameObject*) pself)->priv;
 
-  GLuint program;
-  GLuint uloc;
-
-  program = ds_render_state_get_current_program(state);
+  GLint uloc;
 
 /*
  * Update model matrix
  *
  */
 
-  __gl_try_catch(
-    uloc = glGetUniformLocation(program, A_MVP);
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
-
+  uloc = ds_render_state_get_uniform_location(state, A_MVP);
   if G_LIKELY(uloc != (-1))
   {
-    JitState* ctx =
-    (JitState*) state;
+    JitPlan* plan =
+    (JitPlan*) state;
 
-    _ds_jit_compile_call
-    (ctx,
-     G_CALLBACK(_ds_jit_helper_update_model),
-     FALSE,
+    ds_render_state_call
+    (state,
+     G_CALLBACK(update_model_frame),
      2,
-     (guintptr) &(ctx->mvps),
-     (guintptr) priv->model);
+     (guintptr) plan->mvps,
+     (guintptr) priv);
 
-    _ds_jit_compile_call
-    (ctx,
+    ds_render_state_call
+    (state,
      G_CALLBACK(_ds_jit_helper_update_mvp),
-     FALSE,
      1,
-     (guintptr) &(ctx->mvps));
+     (guintptr) plan->mvps);
 
-    _ds_jit_compile_call
-    (ctx,
+    ds_render_state_pcall
+    (state,
      G_CALLBACK(glUniformMatrix4fv),
-     TRUE,
      4,
      (guintptr) uloc,
      (guintptr) 1,
      (guintptr) GL_FALSE,
-     (guintptr) &(ctx->mvps.mvp));
+     (guintptr) &(plan->mvps->mvp));
   }
 
 /*
@@ -148,7 +164,7 @@ ds_game_object_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* s
  */
 
   success =
-  ds_renderable_compile(priv->draw, state, cancellable, &tmp_err);
+  ds_renderable_plan(priv->draw, state, cancellable, &tmp_err);
   if G_UNLIKELY(tmp_err != NULL)
   {
     g_propagate_error(error, tmp_err);
@@ -162,15 +178,21 @@ return success;
 static void
 ds_game_object_ds_renderable_iface_init(DsRenderableIface* iface)
 {
-  iface->compile = ds_game_object_ds_renderable_iface_compile;
+  iface->plan = ds_game_object_ds_renderable_iface_plan;
+}
+
+static void
+compute_model(mat4 model, vec3 position, vec3 scale)
+{
+  glm_mat4_identity(model);
+  glm_translate(model, position);
+  glm_scale(model, scale);
 }
 
 static void
 update_model(DsGameObjectPrivate* priv)
 {
-  glm_mat4_identity(priv->model);
-  glm_translate(priv->model, priv->position);
-  glm_scale(priv->model, priv->scale);
+  compute_model(priv->model, priv->position, priv->scale);
 }
 
 static void
@@ -247,6 +269,10 @@ static void
 ds_game_object_class_finalize(GObject* pself)
 {
   DsGameObjectPrivate* priv = DS_GAME_OBJECT(pself)->priv;
+
+  G_LOCK(live);
+  g_queue_unlink(&live, &(priv->link));
+  G_UNLOCK(live);
 G_OBJECT_CLASS(ds_game_object_parent_class)->finalize(pself);
 }
 
@@ -295,6 +321,27 @@ ds_game_object_class_init(DsGameObjectClass* klass)
    G_TYPE_FROM_CLASS(klass),
    ds_cclosure_marshal_BOOLEAN__OBJECT_POINTERv);
 
+  /**
+   * DsGameObject::update:
+   * @this_: the object that received the signal.
+   * @step: simulation step length, in seconds.
+   *
+   * Emitted once per fixed simulation step, while
+   * @this_ is part of a #DsSimulation.
+   */
+  signals[sig_update] =
+    g_signal_new
+    ("update",
+     G_TYPE_FROM_CLASS(klass),
+     G_SIGNAL_RUN_LAST,
+     G_STRUCT_OFFSET(DsGameObjectClass, update),
+     NULL,
+     NULL,
+     g_cclosure_marshal_VOID__DOUBLE,
+     G_TYPE_NONE,
+     1,
+     G_TYPE_DOUBLE);
+
   properties[prop_model] =
     g_param_spec_object
     ("model",
@@ -316,8 +363,21 @@ ds_game_object_init(DsGameObject* self)
 {
   DsGameObjectPrivate* priv = ds_game_object_get_instance_private(self);
   self->priv = priv;
+  guint i;
 
+  glm_vec3_one(priv->scale);
+  glm_vec3_one(priv->scale_prev);
   glm_mat4_identity(priv->model);
+
+  for(i = 0;
+      i < DS_GAME_OBJECT_SLOTS;
+      i++)
+    glm_mat4_identity(priv->frames[i]);
+
+  priv->link.data = self;
+  G_LOCK(live);
+  g_queue_push_tail_link(&live, &(priv->link));
+  G_UNLOCK(live);
 }
 
 /*
@@ -344,3 +404,77 @@ ds_game_object_collide(DsGameObject* this_, DsGameObject* collider, GError** err
   DsGameObjectClass* klass = DS_GAME_OBJECT_GET_CLASS(this_);
 return klass->collide(this_, collider, error);
 }
+
+/**
+ * ds_game_object_update:
+ * @this_: a #DsGameObject instance.
+ * @step: simulation step length, in seconds.
+ *
+ * Emits #DsGameObject::update signal.
+ *
+ */
+void
+ds_game_object_update(DsGameObject* this_, gdouble step)
+{
+  g_return_if_fail(DS_IS_GAME_OBJECT(this_));
+  g_signal_emit(this_, signals[sig_update], 0, step);
+}
+
+G_GNUC_INTERNAL
+void
+_ds_game_object_snapshot(DsGameObject* this_)
+{
+  DsGameObjectPrivate* priv = this_->priv;
+  glm_vec3_copy(priv->position, priv->position_prev);
+  glm_vec3_copy(priv->scale, priv->scale_prev);
+}
+
+G_GNUC_INTERNAL
+void
+_ds_game_object_interpolate(DsGameObject* this_, gfloat alpha)
+{
+  DsGameObjectPrivate* priv = this_->priv;
+  vec3 position;
+  vec3 scale;
+
+  glm_vec3_lerp(priv->position_prev, priv->position, alpha, position);
+  glm_vec3_lerp(priv->scale_prev, priv->scale, alpha, scale);
+  compute_model(priv->model, position, scale);
+}
+
+/*
+ * Called from main thread, after
+ * simulation, to fill frame @slot
+ *
+ */
+G_GNUC_INTERNAL
+void
+_ds_game_object_publish(guint slot)
+{
+  g_return_if_fail(slot < DS_GAME_OBJECT_SLOTS);
+  DsGameObjectPrivate* priv;
+  GList* list;
+
+  G_LOCK(live);
+  for(list = live.head;
+      list != NULL;
+      list = list->next)
+  {
+    priv = DS_GAME_OBJECT(list->data)->priv;
+    glm_mat4_copy(priv->model, priv->frames[slot]);
+  }
+  G_UNLOCK(live);
+}
+
+/*
+ * Called from GL thread, once frame
+ * @slot is handed to it
+ *
+ */
+G_GNUC_INTERNAL
+void
+_ds_game_object_consume(guint slot)
+{
+  g_return_if_fail(slot < DS_GAME_OBJECT_SLOTS);
+  read_slot = slot;
+}
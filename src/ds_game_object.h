@@ -56,6 +56,7 @@ struct _DsGameObject
  * DsGameObjectClass:
  * @parent_class: parent class.
  * @collide: emitted when a collision is detected between two object (on both objects)
+ * @update: emitted on every fixed simulation step.
  *
  */
 struct _DsGameObjectClass
@@ -63,11 +64,15 @@ struct _DsGameObjectClass
   GObjectClass parent_class;
 
   gboolean (*collide) (DsGameObject* this_, DsGameObject* collider, GError** error);
+  void (*update) (DsGameObject* this_, gdouble step);
 };
 
 DEUSEXMAKINA2_API
 gboolean
 ds_game_object_collide(DsGameObject* this_, DsGameObject* collider, GError** error);
+DEUSEXMAKINA2_API
+void
+ds_game_object_update(DsGameObject* this_, gdouble step);
 
 #if __cplusplus
 }
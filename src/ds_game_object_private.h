@@ -0,0 +1,46 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __DS_GAME_OBJECT_PRIVATE_INCLUDED__
+#define __DS_GAME_OBJECT_PRIVATE_INCLUDED__ 1
+#include <ds_game_object.h>
+
+/* frame slots, as many as DsRenderer keeps */
+#define DS_GAME_OBJECT_SLOTS (3)
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+G_GNUC_INTERNAL
+void
+_ds_game_object_snapshot(DsGameObject* this_);
+G_GNUC_INTERNAL
+void
+_ds_game_object_interpolate(DsGameObject* this_, gfloat alpha);
+G_GNUC_INTERNAL
+void
+_ds_game_object_publish(guint slot);
+G_GNUC_INTERNAL
+void
+_ds_game_object_consume(guint slot);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __DS_GAME_OBJECT_PRIVATE_INCLUDED__
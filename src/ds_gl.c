@@ -68,3 +68,169 @@ ds_gl_get_error()
    "glGetError(): %s\r\n",
    value->value_nick);
 }
+
+/*
+ * GL thread dispatch
+ *
+ * GL calls are only valid on thread which
+ * has context current, which is main thread
+ * unless renderer runs on its own thread; in
+ * that case renderer publishes its main context
+ * here, so loaders can run GL work on it.
+ *
+ */
+
+typedef struct _Invoke Invoke;
+typedef struct _Deferred Deferred;
+
+struct _Invoke
+{
+  DsGLFunc func;
+  gpointer user_data;
+  gboolean success;
+  GError* error;
+  gboolean done;
+  GMutex lock;
+  GCond cond;
+};
+
+struct _Deferred
+{
+  GDestroyNotify func;
+  gpointer user_data;
+};
+
+static
+GMainContext* gl_context = NULL;
+G_LOCK_DEFINE_STATIC(gl_context);
+
+G_GNUC_INTERNAL
+void
+_ds_gl_set_context(GMainContext* context)
+{
+  G_LOCK(gl_context);
+  if(gl_context != NULL)
+    g_main_context_unref(gl_context);
+  gl_context = (context != NULL) ? g_main_context_ref(context) : NULL;
+  G_UNLOCK(gl_context);
+}
+
+static gboolean
+invoke_run(Invoke* invoke)
+{
+  invoke->success =
+  invoke->func(invoke->user_data, &(invoke->error));
+
+  g_mutex_lock(&(invoke->lock));
+  invoke->done = TRUE;
+  g_cond_signal(&(invoke->cond));
+  g_mutex_unlock(&(invoke->lock));
+return G_SOURCE_REMOVE;
+}
+
+/*
+ * Runs @func on GL thread and waits for
+ * it; meant for worker threads, since
+ * GL thread can only call it from a
+ * source dispatched on its own context
+ *
+ */
+G_GNUC_INTERNAL
+gboolean
+_ds_gl_invoke_sync(DsGLFunc   func,
+                   gpointer   user_data,
+                   GError   **error)
+{
+  g_return_val_if_fail(func != NULL, FALSE);
+  GMainContext* context = NULL;
+  GSource* source = NULL;
+  Invoke invoke = {0};
+
+  invoke.func = func;
+  invoke.user_data = user_data;
+  g_mutex_init(&(invoke.lock));
+  g_cond_init(&(invoke.cond));
+
+  /*
+   * Source is attached under lock, so once
+   * renderer takes its context back (and
+   * flushes it) nothing is left behind
+   *
+   */
+
+  G_LOCK(gl_context);
+  context = (gl_context != NULL) ? gl_context : g_main_context_default();
+  if G_UNLIKELY(g_main_context_is_owner(context) == TRUE)
+  {
+    G_UNLOCK(gl_context);
+    invoke_run(&invoke);
+  }
+  else
+  {
+    source = g_idle_source_new();
+    g_source_set_priority(source, G_PRIORITY_DEFAULT);
+    g_source_set_callback(source, (GSourceFunc) invoke_run, &invoke, NULL);
+    g_source_attach(source, context);
+    g_source_unref(source);
+    G_UNLOCK(gl_context);
+  }
+
+  g_mutex_lock(&(invoke.lock));
+  while(invoke.done == FALSE)
+    g_cond_wait(&(invoke.cond), &(invoke.lock));
+  g_mutex_unlock(&(invoke.lock));
+
+  g_mutex_clear(&(invoke.lock));
+  g_cond_clear(&(invoke.cond));
+
+  if G_UNLIKELY(invoke.error != NULL)
+    g_propagate_error(error, invoke.error);
+return invoke.success;
+}
+
+static gboolean
+deferred_run(Deferred* deferred)
+{
+  deferred->func(deferred->user_data);
+  g_slice_free(Deferred, deferred);
+return G_SOURCE_REMOVE;
+}
+
+/*
+ * Runs @func on GL thread without waiting
+ * for it (right away if caller already is
+ * GL thread); meant for releasing GL objects
+ * from wherever their last reference drops
+ *
+ */
+G_GNUC_INTERNAL
+void
+_ds_gl_invoke(GDestroyNotify   func,
+              gpointer         user_data)
+{
+  g_return_if_fail(func != NULL);
+  GMainContext* context = NULL;
+  GSource* source = NULL;
+  Deferred* deferred = NULL;
+
+  G_LOCK(gl_context);
+  context = (gl_context != NULL) ? gl_context : g_main_context_default();
+  if(g_main_context_is_owner(context) == TRUE)
+  {
+    G_UNLOCK(gl_context);
+    func(user_data);
+  }
+  else
+  {
+    deferred = g_slice_new(Deferred);
+    deferred->func = func;
+    deferred->user_data = user_data;
+
+    source = g_idle_source_new();
+    g_source_set_priority(source, G_PRIORITY_DEFAULT);
+    g_source_set_callback(source, (GSourceFunc) deferred_run, deferred, NULL);
+    g_source_attach(source, context);
+    g_source_unref(source);
+    G_UNLOCK(gl_context);
+  }
+}
@@ -161,6 +161,7 @@ typedef enum
 } DsGLDebugSeverity;
 
 typedef GLenum DsGLenum;
+typedef gboolean (*DsGLFunc) (gpointer user_data, GError** error);
 
 #if __cplusplus
 extern "C" {
@@ -211,6 +212,20 @@ ds_gl_has_error();
 GError*
 ds_gl_get_error();
 
+/* Internal API */
+G_GNUC_INTERNAL
+void
+_ds_gl_set_context(GMainContext* context);
+G_GNUC_INTERNAL
+gboolean
+_ds_gl_invoke_sync(DsGLFunc   func,
+                   gpointer   user_data,
+                   GError   **error);
+G_GNUC_INTERNAL
+void
+_ds_gl_invoke(GDestroyNotify   func,
+              gpointer         user_data);
+
 #if __cplusplus
 }
 #endif // __cplusplus
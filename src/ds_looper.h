@@ -17,6 +17,7 @@
  */
 #ifndef __DS_LOOPER_INCLUDED__
 #define __DS_LOOPER_INCLUDED__ 1
+#include <ds_frame_clock.h>
 #include <glib-object.h>
 
 #define DS_TYPE_LOOPER            (ds_looper_get_type ())
@@ -47,10 +48,13 @@ struct _DsLooperClass
 {
   GObjectClass parent_class;
   gboolean (*loop_step) (DsLooper* self);
+  void (*start) (DsLooper* self);
+  void (*stop) (DsLooper* self);
 };
 
 void ds_looper_start (DsLooper* self);
 void ds_looper_stop (DsLooper* self);
+DsFrameClockPhase ds_looper_get_phase (DsLooper* self);
 
 #if __cplusplus
 }
@@ -20,37 +20,31 @@ namespace Ds
 {
   public abstract class Looper : GLib.Object
   {
-    private uint source_id = 0;
-    private GLib.Source source = null;
+    private uint handler_id = 0;
     protected abstract bool loop_step();
 
-    public void start()
+    public Ds.FrameClockPhase phase { get; construct; default = Ds.FrameClockPhase.UPDATE; }
+
+    public virtual void start()
     {
-      if(likely(source_id == 0))
+      if(likely(handler_id == 0))
       {
-        source_id = source.attach(null);
+        unowned var clock = Ds.FrameClock.get_default();
+        unowned var callback = (GLib.SourceFunc) this.loop_step;
+        handler_id = clock.add_handler(phase, callback);
       }
     }
 
-    public void stop()
+    public virtual void stop()
     {
-      if(likely(source_id != 0))
+      if(likely(handler_id != 0))
       {
-        GLib.Source.remove(source_id);
-        source_id = 0;
+        unowned var clock = Ds.FrameClock.get_default();
+        clock.remove_handler(handler_id);
+        handler_id = 0;
       }
     }
 
-    construct
-    {
-      source = new GLib.IdleSource();
-      source.set_priority(GLib.Priority.DEFAULT);
-      source.set_name(@"(Source) for type '$(GLib.Type.from_instance(this).name())'");
-
-      unowned var callback = (GLib.SourceFunc) this.loop_step;
-      source.set_callback(callback);
-    }
-
     ~Looper()
     {
       this.stop();
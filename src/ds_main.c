@@ -77,6 +77,9 @@ main(int argc, char* argv[])
   GOptionEntry entries[] =
   {
     {"version", 'v', G_OPTION_FLAG_IN_MAIN | G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, version_arg, "Displays version information", NULL},
+    {"headless", '\0', G_OPTION_FLAG_IN_MAIN, G_OPTION_ARG_NONE, NULL, "Renders offscreen, without a display", NULL},
+    {"record", '\0', G_OPTION_FLAG_IN_MAIN, G_OPTION_ARG_FILENAME, NULL, "Records input into FILE", "FILE"},
+    {"replay", '\0', G_OPTION_FLAG_IN_MAIN, G_OPTION_ARG_FILENAME, NULL, "Replays input from FILE, then reports frame times", "FILE"},
     {NULL, '\0', 0, 0, NULL, NULL, NULL},
   };
 
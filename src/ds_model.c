@@ -40,11 +40,15 @@ G_DEFINE_QUARK(ds-model-error-quark,
 static void
 ds_model_g_initable_iface_init(GInitableIface* iface);
 static void
+ds_model_g_async_initable_iface_init(GAsyncInitableIface* iface);
+static void
 ds_model_ds_renderable_iface_init(DsRenderableIface* iface);
 
 typedef union  _DsModelTioArray   DsModelTioArray;
 typedef union  _DsModelMeshArray  DsModelMeshArray;
 typedef struct _DsModelTio        DsModelTio;
+typedef struct _Staging           Staging;
+typedef struct _ReadData          ReadData;
 
 /* type safety */
 #if defined(glib_typeof) && GLIB_VERSION_MAX_ALLOWED >= GLIB_VERSION_2_58 && (!defined(glib_typeof_2_68) || GLIB_VERSION_MIN_REQUIRED >= GLIB_VERSION_2_68)
@@ -79,6 +83,13 @@ gchar* tex_uniforms[] =
 
 G_STATIC_ASSERT(G_N_ELEMENTS(tex_uniforms) == G_N_ELEMENTS(gl2ai));
 
+static const
+gchar* aabb_uniforms[] =
+{
+  "a_AabbCenter",
+  "a_AabbExtent",
+};
+
 /*
  * Object definition
  *
@@ -87,8 +98,16 @@ G_STATIC_ASSERT(G_N_ELEMENTS(tex_uniforms) == G_N_ELEMENTS(gl2ai));
 struct _DsModelPrivate
 {
   DsPencil* pencil;
+  DsCacheProvider* cache_provider;
+  DsShader* shader;
+  DsModelAttributes attributes;
+  DsPencilFormat format;
+  guint index_size;
+  DsModelRange vertices;
+  DsModelRange indices;
   GFile* source;
   gchar* filename;
+  gfloat aabb[6];
 
   union _DsModelTioArray
   {
@@ -132,6 +151,8 @@ enum {
   prop_source,
   prop_name,
   prop_pencil,
+  prop_shader,
+  prop_attributes,
   prop_number,
 };
 
@@ -146,6 +167,9 @@ G_DEFINE_TYPE_WITH_CODE
  (G_TYPE_INITABLE,
   ds_model_g_initable_iface_init)
  G_IMPLEMENT_INTERFACE
+ (G_TYPE_ASYNC_INITABLE,
+  ds_model_g_async_initable_iface_init)
+ G_IMPLEMENT_INTERFACE
  (DS_TYPE_RENDERABLE,
   ds_model_ds_renderable_iface_init)
  G_ADD_PRIVATE(DsModel));
@@ -180,88 +204,389 @@ static void
 {
 }
 
+static void
+glBindBuffer_s(GLenum target, const GLuint* p_buffer)
+{
+  glBindBuffer(target, *p_buffer);
+}
+
+/*
+ * Vertex quantization
+ *
+ */
+
+static inline gint16
+pack_snorm(gfloat x)
+{
+  x = CLAMP(x, -1.f, 1.f);
+return (gint16) (x * 32767.f + ((x >= 0.f) ? .5f : -.5f));
+}
+
+static inline guint16
+pack_half(gfloat x)
+{
+  union { gfloat f; guint32 u; } bits = { .f = x };
+  guint32 sign = (bits.u >> 16) & 0x8000;
+  gint32 exponent = (gint32) ((bits.u >> 23) & 0xff) - 127 + 15;
+  guint32 mantissa = bits.u & 0x7fffff;
+
+  if G_UNLIKELY(exponent <= 0)
+  {
+    /* subnormal (or zero) */
+    if(exponent < -10)
+      return (guint16) sign;
+    mantissa |= 0x800000;
+    return (guint16) (sign | (mantissa >> (14 - exponent)));
+  }
+  else
+  if G_UNLIKELY(exponent >= 31)
+  {
+    /* overflow (and NaN) */
+    return (guint16) (sign | 0x7c00);
+  }
+
+  /* rounding carry may bump exponent, which is fine */
+return (guint16) (sign | (((guint32) exponent << 10) + ((mantissa + 0x1000) >> 13)));
+}
+
+static inline void
+pack_octahedral(const C_STRUCT aiVector3D* n, gint16* out)
+{
+  gfloat l1 = fabsf(n->x) + fabsf(n->y) + fabsf(n->z);
+  gfloat x, y, t;
+
+  if G_UNLIKELY(l1 == 0.f)
+  {
+    out[0] = 0;
+    out[1] = 0;
+    return;
+  }
+
+  x = n->x / l1;
+  y = n->y / l1;
+
+  /* fold lower hemisphere */
+  if(n->z < 0.f)
+  {
+    t = x;
+    x = (1.f - fabsf(y)) * ((t >= 0.f) ? 1.f : -1.f);
+    y = (1.f - fabsf(t)) * ((y >= 0.f) ? 1.f : -1.f);
+  }
+
+  out[0] = pack_snorm(x);
+  out[1] = pack_snorm(y);
+}
+
 static inline void
 copy_vertex(DsModel                *self,
             const C_STRUCT aiMesh  *mesh,
             guint                   i,
-            DsPencilVertex         *v)
+            const gfloat           *aabb,
+            DsPencilPackedVertex   *v)
 {
-  /* position */
-  v->position[0] = mesh->mVertices[i].x;
-  v->position[1] = mesh->mVertices[i].y;
-  v->position[2] = mesh->mVertices[i].z;
+  const C_STRUCT aiVector3D* n = NULL;
+  const C_STRUCT aiVector3D* t = NULL;
+  const C_STRUCT aiVector3D* b = NULL;
+  gfloat handedness;
+
+  /* attributes mesh lacks stay zero */
+  memset(v, 0, sizeof(DsPencilPackedVertex));
+
+  /* position (relative to bounding box) */
+  v->position[0] = pack_snorm((mesh->mVertices[i].x - aabb[0]) / aabb[3]);
+  v->position[1] = pack_snorm((mesh->mVertices[i].y - aabb[1]) / aabb[4]);
+  v->position[2] = pack_snorm((mesh->mVertices[i].z - aabb[2]) / aabb[5]);
+  v->position[3] = G_MAXINT16;
 
   /* normal */
   if(mesh->mNormals != NULL)
   {
-    v->normal[0] = mesh->mNormals[i].x;
-    v->normal[1] = mesh->mNormals[i].y;
-    v->normal[2] = mesh->mNormals[i].z;
+    n = &(mesh->mNormals[i]);
+    pack_octahedral(n, v->normal);
   }
 
   /* textures */
-  if(mesh->mTextureCoords != NULL)
+  if(mesh->mTextureCoords[0] != NULL)
   {
-    /* uvw */
+    /* uv */
     switch(mesh->mNumUVComponents[0])
     {
     case 3:
-      v->uvw[2] = mesh->mTextureCoords[0][i].z;
-      G_GNUC_FALLTHROUGH;
     case 2:
-      v->uvw[1] = mesh->mTextureCoords[0][i].y;
+      v->uv[1] = pack_half(mesh->mTextureCoords[0][i].y);
       G_GNUC_FALLTHROUGH;
     case 1:
-      v->uvw[0] = mesh->mTextureCoords[0][i].x;
+      v->uv[0] = pack_half(mesh->mTextureCoords[0][i].x);
       break;
     default:
       g_critical
-      ("(%s: %i): mesh->mNumUVComponents[i] = %u\r\n",
-       G_STRFUNC, __LINE__, mesh->mNumUVComponents[i]);
+      ("(%s: %i): mesh->mNumUVComponents[0] = %u\r\n",
+       G_STRFUNC, __LINE__, mesh->mNumUVComponents[0]);
       g_assert_not_reached();
       break;
     }
 
     if(mesh->mTangents != NULL)
     {
-      v->tangent[0] = mesh->mTangents[i].x;
-      v->tangent[1] = mesh->mTangents[i].y;
-      v->tangent[2] = mesh->mTangents[i].z;
+      t = &(mesh->mTangents[i]);
+      pack_octahedral(t, v->tangent);
+    }
+
+    /* bitangent is rebuilt from sign */
+    if(n != NULL && t != NULL && mesh->mBitangents != NULL)
+    {
+      b = &(mesh->mBitangents[i]);
+      handedness =
+        (n->y * t->z - n->z * t->y) * b->x
+      + (n->z * t->x - n->x * t->z) * b->y
+      + (n->x * t->y - n->y * t->x) * b->z;
+
+      if(handedness < 0.f)
+        v->position[3] = -G_MAXINT16;
+    }
+  }
+}
+
+static inline void
+compute_bounds(const C_STRUCT aiScene* scene, gfloat* aabb)
+{
+  const C_STRUCT aiMesh* mesh = NULL;
+  gfloat lo[3] = { G_MAXFLOAT, G_MAXFLOAT, G_MAXFLOAT};
+  gfloat hi[3] = {-G_MAXFLOAT,-G_MAXFLOAT,-G_MAXFLOAT};
+  guint i, j, k;
+
+  for(i = 0;
+      i < scene->mNumMeshes;
+      i++)
+  for(j = 0, mesh = scene->mMeshes[i];
+      j < mesh->mNumVertices;
+      j++)
+  {
+    const gfloat p[3] =
+    {
+      mesh->mVertices[j].x,
+      mesh->mVertices[j].y,
+      mesh->mVertices[j].z,
+    };
+
+    for(k = 0;
+        k < 3;
+        k++)
+    {
+      lo[k] = MIN(lo[k], p[k]);
+      hi[k] = MAX(hi[k], p[k]);
     }
+  }
 
-    if(mesh->mBitangents != NULL)
+  for(k = 0;
+      k < 3;
+      k++)
+  {
+    if G_UNLIKELY(lo[k] > hi[k])
+      lo[k] = hi[k] = 0.f;
+
+    /* center, then half extent (never zero) */
+    aabb[k] = (lo[k] + hi[k]) * .5f;
+    aabb[k + 3] = (hi[k] - lo[k]) * .5f;
+    if G_UNLIKELY(aabb[k + 3] <= 0.f)
+      aabb[k + 3] = 1.f;
+  }
+}
+
+/*
+ * Everything a model needs before touching
+ * GL: converted geometry and texture images
+ * already read from disk. It is produced on
+ * whatever thread initialization runs, and
+ * consumed on GL one.
+ *
+ */
+
+struct _Staging
+{
+  DsModelData* data;
+  DsDds** images;
+  DsModel* model;
+};
+
+#define _staging_free0(var) ((var == NULL) ? NULL : (var = (_staging_free0 (var), NULL)))
+
+static void
+(_staging_free0)(Staging* staging)
+{
+  guint i;
+
+  if G_LIKELY(staging->images != NULL)
+  {
+    for(i = 0;
+        i < staging->data->n_names;
+        i++)
     {
-      v->bitangent[0] = mesh->mBitangents[i].x;
-      v->bitangent[1] = mesh->mBitangents[i].y;
-      v->bitangent[2] = mesh->mBitangents[i].z;
+      _g_object_unref0(staging->images[i]);
     }
+
+    g_free(staging->images);
+  }
+
+  _ds_model_data_free0(staging->data);
+  g_slice_free(Staging, staging);
+}
+
+/*
+ * Texture files are independent from
+ * each other, so they are read (and its
+ * headers validated) on a thread pool;
+ * only GL uploads remain serialized
+ *
+ */
+
+struct _ReadData
+{
+  GFile* source;
+  Staging* staging;
+  GCancellable* cancellable;
+  GMutex lock;
+  GError* error;
+};
+
+static void
+read_texture_job(gpointer job, ReadData* rdata)
+{
+  DsModelData* data = rdata->staging->data;
+  guint k = GPOINTER_TO_UINT(job) - 1;
+  GError* tmp_err = NULL;
+  GFile* child = NULL;
+  DsDds* image = NULL;
+
+  /* a previous job failed */
+  if G_UNLIKELY(g_atomic_pointer_get(&(rdata->error)) != NULL)
+    return;
+
+  child = g_file_get_child(rdata->source, _ds_model_data_get_name(data, k));
+  image = ds_dds_new(child, rdata->cancellable, &tmp_err);
+  g_object_unref(child);
+
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_mutex_lock(&(rdata->lock));
+    if(rdata->error == NULL)
+      g_atomic_pointer_set(&(rdata->error), tmp_err);
+    else
+      g_error_free(tmp_err);
+    g_mutex_unlock(&(rdata->lock));
+  }
+  else
+  {
+    rdata->staging->images[k] = image;
   }
 }
 
 static gboolean
-translate_material(DsModel* self, C_STRUCT aiMaterial* material, C_ENUM aiTextureType type, GCancellable* cancellable, GError** error)
+read_textures(DsModel* self, Staging* staging, GCancellable* cancellable, GError** error)
 {
+  DsModelData* data = staging->data;
   gboolean success = TRUE;
   GError* tmp_err = NULL;
-  C_STRUCT aiString name = {0};
-  GFile* child = NULL;
-  guint i;
+  DsModelDataMaterial* material = NULL;
+  GThreadPool* pool = NULL;
+  ReadData rdata = {0};
+  gboolean* seen = NULL;
+  guint i, j, k, tid, n_jobs = 0;
+  gint64 start = g_get_monotonic_time();
+
+  staging->images = g_new0(DsDds*, data->n_names);
+  seen = g_new0(gboolean, data->n_materials);
+
+  rdata.source = self->priv->source;
+  rdata.staging = staging;
+  rdata.cancellable = cancellable;
+  g_mutex_init(&(rdata.lock));
+
+  pool =
+  g_thread_pool_new
+  ((GFunc)
+   read_texture_job,
+   &rdata,
+   MAX(1, MIN(g_get_num_processors(), data->n_names)),
+   FALSE,
+   &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
 
-  guint n_images = aiGetMaterialTextureCount(material, type);
-  if(n_images == 0) return success;
+/*
+ * Read images for every material
+ * actually referenced by a mesh
+ *
+ */
 
-  guint b_images = sizeof(DsDds*) * n_images;
-  DsDds** images = g_alloca(b_images);
-#if HAVE_MEMSET == 1
-  memset(images, 0, b_images);
-#else
   for(i = 0;
-      i < n_images;
+      i < data->n_meshes;
       i++)
   {
-    images[i] = NULL;
+    tid = data->meshes[i].material;
+    if(seen[tid] == TRUE)
+      continue;
+
+    seen[tid] = TRUE;
+    material = &(data->materials[tid]);
+
+    for(j = 0;
+        j < G_N_ELEMENTS(gl2ai);
+        j++)
+    for(k = material->first[j];
+        k < material->first[j] + material->count[j];
+        k++, n_jobs++)
+    {
+      g_thread_pool_push(pool, GUINT_TO_POINTER(k + 1), &tmp_err);
+      if G_UNLIKELY(tmp_err != NULL)
+      {
+        g_propagate_error(error, tmp_err);
+        goto_error();
+      }
+    }
+  }
+
+  /* wait for every job */
+  g_thread_pool_free(g_steal_pointer(&pool), FALSE, TRUE);
+
+  if G_UNLIKELY(rdata.error != NULL)
+  {
+    g_propagate_error(error, g_steal_pointer(&(rdata.error)));
+    goto_error();
   }
-#endif // HAVE_MEMSET
+
+  g_debug
+  ("(%s: %i): read %u texture files in %.3f ms\r\n",
+   G_STRFUNC,
+   __LINE__,
+   n_jobs,
+   (g_get_monotonic_time() - start) / 1000.);
+
+_error_:
+  if G_UNLIKELY(pool != NULL)
+    g_thread_pool_free(pool, FALSE, TRUE);
+  if G_UNLIKELY(rdata.error != NULL)
+    g_error_free(rdata.error);
+  g_mutex_clear(&(rdata.lock));
+  _g_free0(seen);
+return success;
+}
+
+static gboolean
+translate_material(DsModel* self, Staging* staging, guint material, guint type, GError** error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  guint i;
+
+  guint first = staging->data->materials[material].first[type];
+  guint n_images = staging->data->materials[material].count[type];
+  if(n_images == 0) return success;
+
+  DsDds** images = &(staging->images[first]);
 
   guint width = 0;
   guint height = 0;
@@ -271,30 +596,6 @@ translate_material(DsModel* self, C_STRUCT aiMaterial* material, C_ENUM aiTextur
       i < n_images;
       i++)
   {
-  /*
-   * Get image file path
-   *
-   */
-
-    aiGetMaterialTexture(material, type, i, &name, NULL, NULL, NULL, NULL, NULL, NULL);
-    g_assert(name.length > 0);
-
-    _g_object_unref0(child);
-    child = g_file_get_child(self->priv->source, name.data);
-
-  /*
-   * Actually load image
-   *
-   */
-
-    images[i] =
-    ds_dds_new(child, cancellable, &tmp_err);
-    if G_UNLIKELY(tmp_err != NULL)
-    {
-      g_propagate_error(error, tmp_err);
-      goto_error();
-    }
-
   /*
    * Check consistency across images
    *
@@ -371,18 +672,11 @@ translate_material(DsModel* self, C_STRUCT aiMaterial* material, C_ENUM aiTextur
   );
 
 _error_:
-  _g_object_unref0(child);
-  for(i = 0;
-      i < n_images;
-      i++)
-  {
-    _g_object_unref0(images[i]);
-  }
 return success;
 }
 
 static inline DsModelTexture*
-load_texture_file(DsModel* self, C_STRUCT aiMaterial* material, GCancellable* cancellable, GError** error)
+load_texture_file(DsModel* self, Staging* staging, guint material, GError** error)
 {
   gboolean success = TRUE;
   GError* tmp_err = NULL;
@@ -411,7 +705,7 @@ load_texture_file(DsModel* self, C_STRUCT aiMaterial* material, GCancellable* ca
     );
 
     success =
-    translate_material(self, material, gl2ai[i], cancellable, &tmp_err);
+    translate_material(self, staging, material, i, &tmp_err);
     if G_UNLIKELY(tmp_err != NULL)
     {
       g_propagate_error(error, tmp_err);
@@ -434,22 +728,25 @@ _error_:
 return tex;
 }
 
-static inline gboolean
-load_object_file(DsModel* self, GCancellable* cancellable, GError** error)
+static DsModelData*
+import_object_file(DsModel* self, GCancellable* cancellable, GError** error)
 {
   DsModelPrivate* priv = self->priv;
   gboolean success = TRUE;
   GError* tmp_err = NULL;
   const C_STRUCT aiScene* scene = NULL;
-  guint i, j, k, _v, _i;
+  guint i, j, k, _v, _i, _n;
 
-  GLuint vbo = 0, ibo = 0;
-  DsModelTioArray* tios = NULL;
-  DsModelMeshArray* meshes = NULL;
+  DsModelData* data = NULL;
+  GPtrArray* names = NULL;
   C_STRUCT aiMesh* mesh = NULL;
   C_STRUCT aiFace* face = NULL;
-  DsPencilVertex* vertices = NULL;
-  DsModelIndex* indices = NULL;
+  C_STRUCT aiString name = {0};
+  DsModelDataMaterial* material = NULL;
+  DsPencilPackedVertex packed = {0};
+  DsPencilBasicVertex* basic = NULL;
+  gsize strings_length = 1;
+  gchar* strings = NULL;
 
 /*
  * Load scene
@@ -457,7 +754,7 @@ load_object_file(DsModel* self, GCancellable* cancellable, GError** error)
  */
 
   scene =
-  _ds_model_import_new(self, priv->source, priv->filename, cancellable, &tmp_err);
+  _ds_model_import_new(self, priv->source, priv->filename, priv->attributes, cancellable, &tmp_err);
   if G_UNLIKELY(tmp_err != NULL)
   {
     g_propagate_error(error, tmp_err);
@@ -465,22 +762,13 @@ load_object_file(DsModel* self, GCancellable* cancellable, GError** error)
   }
 
 /*
- * Prepare buffers
+ * Calculate buffers size
  *
  */
 
-  /* create buffers object */
-  __gl_try_catch(
-    glCreateBuffers(1, &vbo);
-    glCreateBuffers(1, &ibo);
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
-
-  /* calculate buffers size */
   gsize n_vertices = 0;
   gsize n_indices = 0;
+  guint index_size = sizeof(guint16);
 
   for(i = 0;
       i < scene->mNumMeshes;
@@ -488,6 +776,10 @@ load_object_file(DsModel* self, GCancellable* cancellable, GError** error)
   {
     n_vertices += scene->mMeshes[i]->mNumVertices;
 
+    /* indices are relative to mesh base vertex */
+    if(scene->mMeshes[i]->mNumVertices > G_MAXUINT16 + 1)
+      index_size = sizeof(guint32);
+
     for(j = 0;
         j < scene->mMeshes[i]->mNumFaces;
         j++)
@@ -496,41 +788,44 @@ load_object_file(DsModel* self, GCancellable* cancellable, GError** error)
     }
   }
 
-  /* allocate buffers */
-  __gl_try_catch(
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, n_vertices * sizeof(DsPencilVertex), NULL, GL_STATIC_DRAW);
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
+  /* collect texture names */
+  names = g_ptr_array_new_with_free_func(g_free);
 
-  __gl_try_catch(
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, n_indices * sizeof(DsModelIndex), NULL, GL_STATIC_DRAW);
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
+  for(i = 0;
+      i < scene->mNumMaterials;
+      i++)
+  for(j = 0;
+      j < G_N_ELEMENTS(gl2ai);
+      j++)
+  {
+    guint n_images = aiGetMaterialTextureCount(scene->mMaterials[i], gl2ai[j]);
+    for(k = 0;
+        k < n_images;
+        k++)
+    {
+      aiGetMaterialTexture(scene->mMaterials[i], gl2ai[j], k, &name, NULL, NULL, NULL, NULL, NULL, NULL);
+      g_assert(name.length > 0);
 
-  tios = (DsModelTioArray*) g_array_new(FALSE, TRUE, sizeof(DsModelTio));
-  g_array_set_size(&(tios->array_), scene->mNumMaterials);
-  g_array_set_clear_func(&(tios->array_), (GDestroyNotify) _tio_clear0);
-  meshes = (DsModelMeshArray*) g_array_new(FALSE, TRUE, sizeof(DsModelMesh));
-  g_array_set_size(&(meshes->array_), scene->mNumMeshes);
-  g_array_set_clear_func(&(meshes->array_), (GDestroyNotify) _mesh_clear0);
+      g_ptr_array_add(names, g_strndup(name.data, name.length));
+      strings_length += name.length + 1;
+    }
+  }
 
-  /* map buffers */
-  __gl_try_catch(
-    vertices = (DsPencilVertex*) glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-    indices = (DsModelIndex*) glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
+  data =
+  _ds_model_data_new
+  (priv->format,
+   index_size,
+   n_vertices,
+   n_indices,
+   scene->mNumMeshes,
+   scene->mNumMaterials,
+   names->len,
+   strings_length);
+
+  compute_bounds(scene, data->aabb);
 
 /*
- * Load onto buffers
+ * Copy contents
  *
  */
 
@@ -539,16 +834,32 @@ load_object_file(DsModel* self, GCancellable* cancellable, GError** error)
       i++)
   {
     mesh = scene->mMeshes[i];
-    meshes->a[i].base_vertex = _v;
-    meshes->a[i].index_offset = _i;
-    meshes->a[i].indices = 0;
+    data->meshes[i].mesh.base_vertex = _v;
+    data->meshes[i].mesh.index_offset = _i;
+    data->meshes[i].mesh.indices = 0;
+    data->meshes[i].material = mesh->mMaterialIndex;
 
     /* copy vertices */
     for(j = 0;
         j < mesh->mNumVertices;
-        j++)
+        j++, _v++)
     {
-      copy_vertex(self, mesh, j, &(vertices[_v++]));
+      copy_vertex(self, mesh, j, data->aabb, &packed);
+
+      switch(data->format)
+      {
+      case DS_PENCIL_FORMAT_PACKED:
+        ((DsPencilPackedVertex*) data->vertices)[_v] = packed;
+        break;
+      case DS_PENCIL_FORMAT_BASIC:
+        basic = &(((DsPencilBasicVertex*) data->vertices)[_v]);
+        memcpy(basic->position, packed.position, sizeof(basic->position));
+        memcpy(basic->uv, packed.uv, sizeof(basic->uv));
+        break;
+      default:
+        g_assert_not_reached();
+        break;
+      }
     }
 
     /* copy indices */
@@ -560,26 +871,137 @@ load_object_file(DsModel* self, GCancellable* cancellable, GError** error)
       G_STATIC_ASSERT(sizeof(face->mIndices[0]) == sizeof(DsModelIndex));
 
 #if HAVE_MEMCPY
-      memcpy(&(indices[_i]), face->mIndices, sizeof(DsModelIndex) * face->mNumIndices);
-#else
+      if(data->index_size == sizeof(DsModelIndex))
+        memcpy(&(((DsModelIndex*) data->indices)[_i]), face->mIndices, sizeof(DsModelIndex) * face->mNumIndices);
+      else
+#endif // HAVE_MEMCPY
       for(k = 0;
           k < face->mNumIndices;
           k++)
       {
-        indices[_i + k] = face->mIndices[k];
+        _ds_model_data_set_index(data, _i + k, face->mIndices[k]);
       }
-#endif // HAVE_MEMCPY
-      meshes->a[i].indices += face->mNumIndices;
+      data->meshes[i].mesh.indices += face->mNumIndices;
       _i += face->mNumIndices;
     }
+  }
+
+  /* copy texture names (first string is an empty one) */
+  strings = (gchar*) data->strings;
+
+  for(i = 0, _n = 0, _i = 1;
+      i < scene->mNumMaterials;
+      i++)
+  for(j = 0, material = &(data->materials[i]);
+      j < G_N_ELEMENTS(gl2ai);
+      j++)
+  {
+    guint n_images = aiGetMaterialTextureCount(scene->mMaterials[i], gl2ai[j]);
+    material->first[j] = _n;
+    material->count[j] = n_images;
+
+    for(k = 0;
+        k < n_images;
+        k++, _n++)
+    {
+      const gchar* name_ = g_ptr_array_index(names, _n);
+      gsize length = strlen(name_) + 1;
+
+      memcpy(strings + _i, name_, length);
+      data->names[_n] = _i;
+      _i += length;
+    }
+  }
+
+  /* so cache can tell when they change */
+  data->companions =
+  _ds_model_import_get_companions(self, priv->filename);
+
+_error_:
+  if(names != NULL)
+    g_ptr_array_unref(names);
+  _ds_model_import_free(self, scene);
+return data;
+}
 
-    /* load textures */
-    guint tid = mesh->mMaterialIndex;
+static inline gboolean
+upload_object_data(DsModel* self, Staging* staging, GError** error)
+{
+  DsModelPrivate* priv = self->priv;
+  DsModelData* data = staging->data;
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  guint i;
+
+  DsModelRange vertices = {0};
+  DsModelRange indices = {0};
+  DsModelTioArray* tios = NULL;
+  DsModelMeshArray* meshes = NULL;
+  GLint base_vertex;
+  GLuint index_offset;
+
+/*
+ * Upload buffers (into geometry heap)
+ *
+ */
+
+  success =
+  _ds_model_heap_alloc
+  ((DsModelHeapKind)
+   data->format,
+   data->n_vertices * ds_pencil_format_get_stride(data->format),
+   data->vertices,
+   &vertices,
+   &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  success =
+  _ds_model_heap_alloc
+  (DS_MODEL_HEAP_INDICES,
+   data->n_indices * data->index_size,
+   data->indices,
+   &indices,
+   &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  /* ranges are aligned to either size */
+  base_vertex = vertices.offset / ds_pencil_format_get_stride(data->format);
+  index_offset = indices.offset / data->index_size;
+
+  tios = (DsModelTioArray*) g_array_new(FALSE, TRUE, sizeof(DsModelTio));
+  g_array_set_size(&(tios->array_), data->n_materials);
+  g_array_set_clear_func(&(tios->array_), (GDestroyNotify) _tio_clear0);
+  meshes = (DsModelMeshArray*) g_array_new(FALSE, TRUE, sizeof(DsModelMesh));
+  g_array_set_size(&(meshes->array_), data->n_meshes);
+  g_array_set_clear_func(&(meshes->array_), (GDestroyNotify) _mesh_clear0);
+
+/*
+ * Load textures
+ *
+ */
+
+  for(i = 0;
+      i < data->n_meshes;
+      i++)
+  {
+    meshes->a[i] = data->meshes[i].mesh;
+    meshes->a[i].base_vertex += base_vertex;
+    meshes->a[i].index_offset += index_offset;
+
+    guint tid = data->meshes[i].material;
     if G_UNLIKELY
       (tios->a[tid].tex == NULL)
     {
       tios->a[tid].tex =
-      load_texture_file(self, scene->mMaterials[tid], cancellable, &tmp_err);
+      load_texture_file(self, staging, tid, &tmp_err);
       if G_UNLIKELY(tmp_err != NULL)
       {
         g_propagate_error(error, tmp_err);
@@ -599,53 +1021,134 @@ load_object_file(DsModel* self, GCancellable* cancellable, GError** error)
  *
  */
 
+  memcpy(priv->aabb, data->aabb, sizeof(priv->aabb));
+  priv->index_size = data->index_size;
   priv->tios = ds_array_ref(tios);
   priv->meshes = ds_array_ref(meshes);
-  self->vbo = ds_steal_handle_id(&vbo);
-  self->ibo = ds_steal_handle_id(&ibo);
+  priv->vertices = vertices;
+  priv->indices = indices;
+  self->vbo = *(vertices.p_buffer);
+  self->ibo = *(indices.p_buffer);
+  memset(&vertices, 0, sizeof(vertices));
+  memset(&indices, 0, sizeof(indices));
 
 _error_:
-  __gl_try_catch(
-    if G_UNLIKELY(indices != NULL)
-      glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-    if G_UNLIKELY(vertices != NULL)
-      glUnmapBuffer(GL_ARRAY_BUFFER);
-    if G_UNLIKELY(ibo != 0)
-      glDeleteBuffers(1, &ibo);
-    if G_UNLIKELY(vbo != 0)
-      glDeleteBuffers(1, &vbo);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-  ,
-    g_warning
-    ("(%s: %i): %s: %i: %s\r\n",
-     G_STRFUNC,
-     __LINE__,
-     g_quark_to_string(glerror->domain),
-     glerror->code,
-     glerror->message);
-    g_error_free(glerror);
-  );
-
+  _ds_model_heap_free(&vertices);
+  _ds_model_heap_free(&indices);
   ds_array_unref(tios);
   ds_array_unref(meshes);
-
-  _ds_model_import_free(self, scene);
-  g_clear_object(&(priv->source));
-  g_clear_pointer(&(priv->filename), g_free);
 return success;
 }
 
-static gboolean
-ds_model_g_initable_iface_init_sync(GInitable    *pself,
-                                    GCancellable *cancellable,
-                                    GError      **error)
+static Staging*
+prepare_object_file(DsModel* self, GCancellable* cancellable, GError** error)
 {
-  DsModel* self = (DsModel*) pself;
   DsModelPrivate* priv = self->priv;
   gboolean success = TRUE;
   GError* tmp_err = NULL;
+  Staging* staging = NULL;
+  gchar* key = NULL;
+
+  staging = g_slice_new0(Staging);
+
+#if !DEBUG
+/*
+ * Try model cache
+ *
+ */
+
+  if G_LIKELY(priv->cache_provider != NULL)
+  {
+    key =
+    _ds_model_cache_key(priv->source, priv->filename, priv->attributes, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+
+    staging->data =
+    _ds_model_cache_try_load(priv->cache_provider, key, priv->source, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      if(g_error_matches(tmp_err, DS_MODEL_ERROR, DS_MODEL_ERROR_INVALID_CACHE))
+        g_clear_error(&tmp_err);
+      else
+      {
+        g_propagate_error(error, tmp_err);
+        goto_error();
+      }
+    }
+  }
+#endif // !DEBUG
+
+/*
+ * Import and cache it
+ *
+ */
+
+  if G_UNLIKELY(staging->data == NULL)
+  {
+    staging->data =
+    import_object_file(self, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+
+    success =
+    _ds_model_data_optimize(staging->data, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+
+#if !DEBUG
+    if G_LIKELY(key != NULL)
+    {
+      _ds_model_cache_try_save(priv->cache_provider, key, priv->source, staging->data, cancellable, &tmp_err);
+      if G_UNLIKELY(tmp_err != NULL)
+      {
+        /* a read-only cache should not prevent loading */
+        g_warning
+        ("(%s: %i): %s: %i: %s\r\n",
+         G_STRFUNC,
+         __LINE__,
+         g_quark_to_string(tmp_err->domain),
+         tmp_err->code,
+         tmp_err->message);
+        g_clear_error(&tmp_err);
+      }
+    }
+#endif // !DEBUG
+  }
+
+/*
+ * Read textures
+ *
+ */
+
+  success =
+  read_textures(self, staging, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+_error_:
+  if G_UNLIKELY(success == FALSE)
+    _staging_free0(staging);
+  _g_free0(key);
+return staging;
+}
+
+static void
+prepare_defaults(DsModel* self)
+{
+  DsModelPrivate* priv = self->priv;
 
   g_assert(priv->source);
 
@@ -656,21 +1159,85 @@ ds_model_g_initable_iface_init_sync(GInitable    *pself,
     g_assert(priv->pencil != NULL);
   }
 
+  if(priv->cache_provider == NULL)
+  {
+    priv->cache_provider =
+    ds_cache_provider_get_default();
+    _g_object_ref0(priv->cache_provider);
+  }
+
+/*
+ * Store only what will be consumed
+ *
+ */
+
+  priv->attributes =
+  _ds_model_resolve_attributes(priv->shader, priv->attributes);
+
+  if(priv->attributes & (DS_MODEL_ATTRIBUTE_NORMAL
+                       | DS_MODEL_ATTRIBUTE_TANGENT
+                       | DS_MODEL_ATTRIBUTE_BITANGENT))
+    priv->format = DS_PENCIL_FORMAT_PACKED;
+  else
+    priv->format = DS_PENCIL_FORMAT_BASIC;
+}
+
+static gboolean
+complete_object_file(DsModel* self, Staging* staging, GError** error)
+{
+  DsModelPrivate* priv = self->priv;
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+
+  success =
+  ds_pencil_bind_format(priv->pencil, priv->format, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
   success =
-  ds_pencil_bind(priv->pencil, &tmp_err);
+  upload_object_data(self, staging, &tmp_err);
   if G_UNLIKELY(tmp_err != NULL)
   {
     g_propagate_error(error, tmp_err);
     goto_error();
   }
 
+_error_:
+  g_clear_object(&(priv->source));
+  g_clear_pointer(&(priv->filename), g_free);
+return success;
+}
+
+static gboolean
+ds_model_g_initable_iface_init_sync(GInitable    *pself,
+                                    GCancellable *cancellable,
+                                    GError      **error)
+{
+  DsModel* self = (DsModel*) pself;
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  Staging* staging = NULL;
+
+  prepare_defaults(self);
+
 /*
  * Load object
  *
  */
 
+  staging =
+  prepare_object_file(self, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
   success =
-  load_object_file(self, cancellable, &tmp_err);
+  complete_object_file(self, staging, &tmp_err);
   if G_UNLIKELY(tmp_err != NULL)
   {
     g_propagate_error(error, tmp_err);
@@ -678,6 +1245,7 @@ ds_model_g_initable_iface_init_sync(GInitable    *pself,
   }
 
 _error_:
+  _staging_free0(staging);
 return success;
 }
 
@@ -687,7 +1255,89 @@ ds_model_g_initable_iface_init(GInitableIface* iface) {
 }
 
 static gboolean
-ds_model_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
+complete_staging(Staging* staging, GError** error)
+{
+  return
+  complete_object_file(staging->model, staging, error);
+}
+
+static void
+init_async_thread(GTask         *task,
+                  DsModel       *self,
+                  gpointer       task_data,
+                  GCancellable  *cancellable)
+{
+  GError* tmp_err = NULL;
+  Staging* staging = NULL;
+
+  staging =
+  prepare_object_file(self, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_task_return_error(task, tmp_err);
+    return;
+  }
+
+/*
+ * Upload on GL thread, which may
+ * not be the one which started
+ * this operation (see DsRenderer's
+ * 'render-thread' setting)
+ *
+ */
+
+  staging->model = self;
+
+  _ds_gl_invoke_sync
+  ((DsGLFunc)
+   complete_staging,
+   staging,
+   &tmp_err);
+
+  _staging_free0(staging);
+
+  if G_UNLIKELY(tmp_err != NULL)
+    g_task_return_error(task, tmp_err);
+  else
+    g_task_return_boolean(task, TRUE);
+}
+
+static void
+ds_model_g_async_initable_iface_init_async(GAsyncInitable      *pself,
+                                           int                  io_priority,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data)
+{
+  DsModel* self = (DsModel*) pself;
+  GTask* task = NULL;
+
+  prepare_defaults(self);
+
+  task = g_task_new(self, cancellable, callback, user_data);
+  g_task_set_source_tag(task, ds_model_g_async_initable_iface_init_async);
+  g_task_set_priority(task, io_priority);
+  g_task_run_in_thread(task, (GTaskThreadFunc) init_async_thread);
+  g_object_unref(task);
+}
+
+static gboolean
+ds_model_g_async_initable_iface_init_finish(GAsyncInitable  *pself,
+                                            GAsyncResult    *res,
+                                            GError         **error)
+{
+  g_return_val_if_fail(g_task_is_valid(res, pself), FALSE);
+return g_task_propagate_boolean(G_TASK(res), error);
+}
+
+static void
+ds_model_g_async_initable_iface_init(GAsyncInitableIface* iface) {
+  iface->init_async = ds_model_g_async_initable_iface_init_async;
+  iface->init_finish = ds_model_g_async_initable_iface_init_finish;
+}
+
+static gboolean
+ds_model_ds_renderable_iface_plan(DsRenderable* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
 {
   gboolean success = TRUE;
   GError* tmp_err = NULL;
@@ -696,25 +1346,59 @@ ds_model_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state,
   DsModel* self = DS_MODEL(pself);
   DsModelPrivate* priv = self->priv;
 
-  GLuint program;
-  GLuint uloc;
+  GLint uloc;
   guint i;
 
-  program = ds_render_state_get_current_program(state);
+  /* plan may only read what initialization left */
+  if G_UNLIKELY(priv->vertices.chunk == NULL)
+  {
+    g_set_error_literal
+    (error,
+     DS_MODEL_ERROR,
+     DS_MODEL_ERROR_FAILED,
+     "Model is not initialized\r\n");
+    goto_error();
+  }
 
 /*
  * VAO switching
  *
  */
 
-  ds_pencil_switch(priv->pencil, state, &(self->vbo));
+  ds_pencil_switch_format(priv->pencil, priv->format, state, (GLuint*) priv->vertices.p_buffer);
+
+  if(ds_render_state_switch_buffer(state, GL_ELEMENT_ARRAY_BUFFER, priv->indices.p_buffer))
+  {
+    ds_render_state_pcall
+    (state,
+     G_CALLBACK(glBindBuffer_s),
+     2,
+     (guintptr) GL_ELEMENT_ARRAY_BUFFER,
+     (guintptr) priv->indices.p_buffer);
+  }
+
+/*
+ * Positions are quantized against
+ * model bounding box
+ *
+ */
+
+  for(i = 0;
+      i < G_N_ELEMENTS(aabb_uniforms);
+      i++)
+  {
+    uloc = ds_render_state_get_uniform_location(state, aabb_uniforms[i]);
+    if G_UNLIKELY(uloc == (-1))
+      continue;
 
-  ds_render_state_pcall
-  (state,
-   G_CALLBACK(glBindBuffer),
-   2,
-   (guintptr) GL_ELEMENT_ARRAY_BUFFER,
-   (guintptr) self->ibo);
+    ds_render_state_pcall
+    (state,
+     G_CALLBACK(glUniform3fv),
+     3,
+     (guintptr) uloc,
+     (guintptr) 1,
+     (guintptr) &(priv->aabb[i * 3]));
+  }
 
 /*
  * Texture binding
@@ -725,22 +1409,16 @@ ds_model_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state,
       i < G_N_ELEMENTS(tex_uniforms);
       i++)
   {
-    __gl_try_catch(
-      uloc = glGetUniformLocation(program, tex_uniforms[i]);
-    ,
-      g_propagate_error(error, glerror);
-      goto_error();
-    );
-
+    uloc = ds_render_state_get_uniform_location(state, tex_uniforms[i]);
     if G_UNLIKELY(uloc == (-1))
       continue;
 
-    __gl_try_catch(
-      glUniform1i(uloc, i);
-    ,
-      g_propagate_error(error, glerror);
-      goto_error();
-    );
+    ds_render_state_setup
+    (state,
+     G_CALLBACK(glUniform1i),
+     2,
+     (guintptr) uloc,
+     (guintptr) i);
   }
 
 /*
@@ -749,7 +1427,7 @@ ds_model_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state,
  */
 
   success =
-  klass->compile((DsModel*) pself, state, cancellable, &tmp_err);
+  klass->plan((DsModel*) pself, state, cancellable, &tmp_err);
   if G_UNLIKELY(tmp_err != NULL)
   {
     g_propagate_error(error, tmp_err);
@@ -763,7 +1441,7 @@ return success;
 static void
 ds_model_ds_renderable_iface_init(DsRenderableIface* iface)
 {
-  iface->compile = ds_model_ds_renderable_iface_compile;
+  iface->plan = ds_model_ds_renderable_iface_plan;
 }
 
 static void
@@ -782,6 +1460,12 @@ ds_model_class_set_property(GObject* pself, guint prop_id, const GValue* value,
   case prop_pencil:
     g_set_object(&(self->priv->pencil), g_value_get_object(value));
     break;
+  case prop_shader:
+    g_set_object(&(self->priv->shader), g_value_get_object(value));
+    break;
+  case prop_attributes:
+    self->priv->attributes = g_value_get_flags(value);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(pself, prop_id, pspec);
     break;
@@ -789,35 +1473,36 @@ ds_model_class_set_property(GObject* pself, guint prop_id, const GValue* value,
 }
 
 static gboolean
-ds_model_class_compile(DsModel* self, DsRenderState* state, GCancellable* cancellable, GError** error)
+ds_model_class_plan(DsModel* self, DsRenderState* state, GCancellable* cancellable, GError** error)
 {
   g_warning
-  ("DsModel::compile not implemented for '%s'\r\n",
+  ("DsModel::plan not implemented for '%s'\r\n",
    g_type_name(G_TYPE_FROM_INSTANCE(self)));
 return FALSE;
 }
 
+static void
+ranges_free(DsModelRange* ranges)
+{
+  _ds_model_heap_free(&(ranges[0]));
+  _ds_model_heap_free(&(ranges[1]));
+  g_slice_free1(sizeof(DsModelRange) * 2, ranges);
+}
+
 static void
 ds_model_class_finalize(GObject* pself)
 {
   DsModel* self = DS_MODEL(pself);
+  DsModelRange* ranges = NULL;
   ds_array_unref(self->priv->tios);
   ds_array_unref(self->priv->meshes);
   g_clear_pointer(&(self->priv->filename), g_free);
 
-  __gl_try_catch(
-    glDeleteBuffers(2, self->bos);
-  ,
-    g_warning
-    ("(%s: %i): %s: %i: %s\r\n",
-     G_STRFUNC,
-     __LINE__,
-     g_quark_to_string(glerror->domain),
-     glerror->code,
-     glerror->message);
-    g_error_free(glerror);
-  );
-
+  /* last reference may drop off GL thread */
+  ranges = g_slice_alloc(sizeof(DsModelRange) * 2);
+  ranges[0] = self->priv->vertices;
+  ranges[1] = self->priv->indices;
+  _ds_gl_invoke((GDestroyNotify) ranges_free, ranges);
 G_OBJECT_CLASS(ds_model_parent_class)->finalize(pself);
 }
 
@@ -825,6 +1510,8 @@ static void
 ds_model_class_dispose(GObject* pself) {
   DsModel* self = DS_MODEL(pself);
   g_clear_object(&(self->priv->source));
+  g_clear_object(&(self->priv->cache_provider));
+  g_clear_object(&(self->priv->shader));
 G_OBJECT_CLASS(ds_model_parent_class)->dispose(pself);
 }
 
@@ -833,7 +1520,7 @@ ds_model_class_init(DsModelClass* klass)
 {
   GObjectClass* oclass = G_OBJECT_CLASS(klass);
 
-  klass->compile = ds_model_class_compile;
+  klass->plan = ds_model_class_plan;
 
   oclass->set_property = ds_model_class_set_property;
   oclass->finalize = ds_model_class_finalize;
@@ -863,6 +1550,23 @@ ds_model_class_init(DsModelClass* klass)
      | G_PARAM_CONSTRUCT_ONLY
      | G_PARAM_STATIC_STRINGS);
 
+  properties[prop_shader] =
+    g_param_spec_object
+    (_TRIPLET("shader"),
+     DS_TYPE_SHADER,
+     G_PARAM_WRITABLE
+     | G_PARAM_CONSTRUCT_ONLY
+     | G_PARAM_STATIC_STRINGS);
+
+  properties[prop_attributes] =
+    g_param_spec_flags
+    (_TRIPLET("attributes"),
+     DS_TYPE_MODEL_ATTRIBUTES,
+     DS_MODEL_ATTRIBUTE_ALL,
+     G_PARAM_WRITABLE
+     | G_PARAM_CONSTRUCT_ONLY
+     | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties
   (oclass,
    prop_number,
@@ -907,3 +1611,21 @@ _ds_model_iterate_tio_groups(DsModel* self,
       return;
   }
 }
+
+G_GNUC_INTERNAL
+DsModelAttributes
+_ds_model_resolve_attributes(DsShader* shader, DsModelAttributes attributes)
+{
+  if(shader != NULL)
+    attributes &= ds_shader_get_active_attributes(shader);
+return attributes | DS_MODEL_ATTRIBUTE_POSITION;
+}
+
+G_GNUC_INTERNAL
+GLenum
+_ds_model_get_index_type(DsModel* self)
+{
+return (self->priv->index_size == sizeof(guint16))
+  ? GL_UNSIGNED_SHORT
+  : GL_UNSIGNED_INT;
+}
@@ -19,6 +19,7 @@
 #define __DS_MODEL_INCLUDED__ 1
 #include <ds_export.h>
 #include <ds_pencil.h>
+#include <ds_shader.h>
 #include <gio/gio.h>
 
 /**
@@ -35,6 +36,7 @@
  * @DS_MODEL_ERROR_NO_INPUT: no input supplied at initialization time.
  * @DS_MODEL_ERROR_INCOMPLETE_IMPORT: incomplete or totally failed import process.
  * @DS_MODEL_ERROR_TEXTURE_LOAD: error loading texture.
+ * @DS_MODEL_ERROR_INVALID_CACHE: invalid or stale model cache file.
  *
  * Error code returned by DsModel API.
  * Note that %DS_MODEL_ERROR_FAILED is here only for compatibility with
@@ -45,8 +47,34 @@ typedef enum {
   DS_MODEL_ERROR_NO_INPUT,
   DS_MODEL_ERROR_INCOMPLETE_IMPORT,
   DS_MODEL_ERROR_TEXTURE_LOAD,
+  DS_MODEL_ERROR_INVALID_CACHE,
 } DsModelError;
 
+/**
+ * DsModelAttributes:
+ * @DS_MODEL_ATTRIBUTE_POSITION: vertex positions (always stored).
+ * @DS_MODEL_ATTRIBUTE_NORMAL: vertex normals.
+ * @DS_MODEL_ATTRIBUTE_UV: texture coordinates.
+ * @DS_MODEL_ATTRIBUTE_TANGENT: vertex tangents.
+ * @DS_MODEL_ATTRIBUTE_BITANGENT: vertex bitangents.
+ * @DS_MODEL_ATTRIBUTE_ALL: every attribute.
+ *
+ * Vertex attributes a model imports and stores.
+ * Each value matches its #DsPencil attribute location
+ * bit, so #ds_shader_get_active_attributes() result
+ * can be used as is.
+ */
+typedef enum /*< flags >*/
+{
+  DS_MODEL_ATTRIBUTE_POSITION = (1 << 0),
+  DS_MODEL_ATTRIBUTE_NORMAL = (1 << 1),
+  DS_MODEL_ATTRIBUTE_UV = (1 << 2),
+  DS_MODEL_ATTRIBUTE_TANGENT = (1 << 3),
+  DS_MODEL_ATTRIBUTE_BITANGENT = (1 << 4),
+  DS_MODEL_ATTRIBUTE_ALL = (1 << 5) - 1,
+} DsModelAttributes;
+
+#define DS_TYPE_MODEL_ATTRIBUTES  (ds_model_attributes_get_type ())
 #define DS_TYPE_MODEL             (ds_model_get_type ())
 #define DS_MODEL(object)          (G_TYPE_CHECK_INSTANCE_CAST((object), DS_TYPE_MODEL, DsModel))
 #define DS_MODEL_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass), DS_TYPE_MODEL, DsModelClass))
@@ -66,9 +94,9 @@ G_BEGIN_DECLS
  * @parent_instance: parent instance.
  * @bos: OpenGL buffer object names array.
  * @vbo: OpenGL vertex buffer object name (where vertices data
- * are stored).
+ * are stored, along with other models' ones).
  * @ibo: OpenGL index buffer object name (where indices data
- * are stored).
+ * are stored, along with other models' ones).
  *
  */
 struct _DsModel
@@ -94,7 +122,7 @@ struct _DsModel
  * DsModelClass:
  * @parent_class: parent class.
  * @vao: OpenGL vertex array object name.
- * @compile: forwards #DsRenderable::compile virtual function implementation,
+ * @plan: forwards #DsRenderable::plan virtual function implementation,
  * since #DsModel already implements it by itself.
  *
  */
@@ -103,7 +131,7 @@ struct _DsModelClass
   GObjectClass parent_class;
 
   /*<public>*/
-  gboolean (*compile) (DsModel* model, DsRenderState* state, GCancellable* cancellable, GError** error);
+  gboolean (*plan) (DsModel* model, DsRenderState* state, GCancellable* cancellable, GError** error);
 };
 
 DEUSEXMAKINA2_API
@@ -111,6 +139,9 @@ GQuark
 ds_model_error_quark();
 DEUSEXMAKINA2_API
 GType
+ds_model_attributes_get_type();
+DEUSEXMAKINA2_API
+GType
 ds_model_get_type();
 
 /*
@@ -124,6 +155,18 @@ ds_model_single_get_type();
 DEUSEXMAKINA2_API
 DsModel*
 ds_model_single_new(GFile* source, const gchar* name, GCancellable* cancellable, GError** error);
+DEUSEXMAKINA2_API
+void
+ds_model_single_new_async(GFile* source, const gchar* name, GCancellable* cancellable, GAsyncReadyCallback callback, gpointer user_data);
+DEUSEXMAKINA2_API
+DsModel*
+ds_model_single_new_full(GFile* source, const gchar* name, DsShader* shader, DsModelAttributes attributes, GCancellable* cancellable, GError** error);
+DEUSEXMAKINA2_API
+void
+ds_model_single_new_full_async(GFile* source, const gchar* name, DsShader* shader, DsModelAttributes attributes, GCancellable* cancellable, GAsyncReadyCallback callback, gpointer user_data);
+DEUSEXMAKINA2_API
+DsModel*
+ds_model_single_new_finish(GAsyncResult* res, GError** error);
 
 G_END_DECLS
 
@@ -0,0 +1,759 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <ds_model_private.h>
+
+typedef struct _Header Header;
+
+static
+const gchar s_magic[4] = "DSM\x1b";
+
+#define CACHE_VERSION (6)
+#define HASH_CHUNK (64 * 1024)
+
+#define _g_bytes_unref0(var) ((var == NULL) ? NULL : (var = (g_bytes_unref (var), NULL)))
+#define _g_mapped_file_unref0(var) ((var == NULL) ? NULL : (var = (g_mapped_file_unref (var), NULL)))
+#define _g_checksum_free0(var) ((var == NULL) ? NULL : (var = (g_checksum_free (var), NULL)))
+#define _g_variant_unref0(var) ((var == NULL) ? NULL : (var = (g_variant_unref (var), NULL)))
+#define _g_file_info_unref0(var) ((var == NULL) ? NULL : (var = (g_object_unref (var), NULL)))
+#define _g_byte_array_unref0(var) ((var == NULL) ? NULL : (var = (g_byte_array_unref (var), NULL)))
+
+/*
+ * Companion files (materials, for
+ * instance) are not part of the key,
+ * since they are known only after an
+ * import; instead, a cache file ends
+ * with a list of them (with their sizes
+ * and modification times), followed by
+ * list length, checked on load
+ *
+ */
+
+#define COMPANIONS_TYPE ((const GVariantType*) "a(stt)")
+#define COMPANION_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+/*
+ * Structs
+ *
+ */
+
+#pragma pack(push, 1)
+#define _PACKED __attribute__((packed, aligned(1)))
+
+struct _Header
+{
+  gchar magic[4];
+  guint version;
+  guint vertex_format;
+  guint vertex_size;
+  guint index_size;
+  guint n_vertices;
+  guint n_indices;
+  guint n_meshes;
+  guint n_materials;
+  guint n_names;
+  guint strings_length;
+  gfloat aabb[6];
+} _PACKED;
+
+#pragma pack(pop)
+
+/*
+ * Every section starts at a four
+ * bytes boundary, so a mapped file
+ * can be used in place
+ *
+ */
+G_STATIC_ASSERT(sizeof(Header) % 4 == 0);
+G_STATIC_ASSERT(sizeof(DsPencilPackedVertex) % 4 == 0);
+G_STATIC_ASSERT(sizeof(DsPencilBasicVertex) % 4 == 0);
+G_STATIC_ASSERT(sizeof(DsModelDataMesh) % 4 == 0);
+G_STATIC_ASSERT(sizeof(DsModelDataMaterial) % 4 == 0);
+
+/*
+ * Layout
+ *
+ */
+
+static gsize
+layout(const Header* header, DsModelData* data, guchar* base)
+{
+  gsize offset = sizeof(Header);
+
+#define section(field,type,count) \
+  G_STMT_START { \
+    if(data != NULL) \
+      data->field = (type*) (base + offset); \
+    offset += sizeof(type) * (gsize) (count); \
+  } G_STMT_END
+
+  section(vertices, guchar, (gsize) header->n_vertices * header->vertex_size);
+  /* 16-bit indices are padded to keep alignment */
+  section(indices, guchar, ((gsize) header->n_indices * header->index_size + 3) & ~(gsize) 3);
+  section(meshes, DsModelDataMesh, header->n_meshes);
+  section(materials, DsModelDataMaterial, header->n_materials);
+  section(names, guint, header->n_names);
+  section(strings, const gchar, header->strings_length);
+
+#undef section
+
+  if(data != NULL)
+  {
+    data->aabb = ((Header*) base)->aabb;
+    data->format = (DsPencilFormat) header->vertex_format;
+    data->n_vertices = header->n_vertices;
+    data->index_size = header->index_size;
+    data->n_indices = header->n_indices;
+    data->n_meshes = header->n_meshes;
+    data->n_materials = header->n_materials;
+    data->n_names = header->n_names;
+  }
+return offset;
+}
+
+static gboolean
+validate(const Header* header, DsModelData* data, GError** error)
+{
+  gboolean success = TRUE;
+  DsModelDataMaterial* material;
+  DsModelDataMesh* mesh;
+  guint i, j;
+
+  if G_UNLIKELY
+    (header->strings_length == 0
+     || data->strings[header->strings_length - 1] != '\0')
+  {
+    g_set_error_literal
+    (error,
+     DS_MODEL_ERROR,
+     DS_MODEL_ERROR_INVALID_CACHE,
+     "Unterminated string table\r\n");
+    goto_error();
+  }
+
+  for(i = 0;
+      i < data->n_names;
+      i++)
+  if G_UNLIKELY(data->names[i] >= header->strings_length)
+  {
+    g_set_error_literal
+    (error,
+     DS_MODEL_ERROR,
+     DS_MODEL_ERROR_INVALID_CACHE,
+     "Texture name out of bounds\r\n");
+    goto_error();
+  }
+
+  for(i = 0;
+      i < data->n_materials;
+      i++)
+  {
+    material = &(data->materials[i]);
+    for(j = 0;
+        j < G_N_ELEMENTS(gl2ai);
+        j++)
+    if G_UNLIKELY
+      (material->first[j] > data->n_names
+       || material->count[j] > data->n_names - material->first[j])
+    {
+      g_set_error_literal
+      (error,
+       DS_MODEL_ERROR,
+       DS_MODEL_ERROR_INVALID_CACHE,
+       "Material out of bounds\r\n");
+      goto_error();
+    }
+  }
+
+  for(i = 0;
+      i < data->n_meshes;
+      i++)
+  {
+    mesh = &(data->meshes[i]);
+    if G_UNLIKELY
+      (mesh->material >= data->n_materials
+       || mesh->mesh.base_vertex < 0
+       || (guint) mesh->mesh.base_vertex > data->n_vertices
+       || mesh->mesh.index_offset > data->n_indices
+       || (guint) mesh->mesh.indices > data->n_indices - mesh->mesh.index_offset)
+    {
+      g_set_error_literal
+      (error,
+       DS_MODEL_ERROR,
+       DS_MODEL_ERROR_INVALID_CACHE,
+       "Mesh out of bounds\r\n");
+      goto_error();
+    }
+
+    /* indices are relative to base vertex */
+    for(j = 0;
+        j < (guint) mesh->mesh.indices;
+        j++)
+    if G_UNLIKELY
+      (_ds_model_data_get_index(data, mesh->mesh.index_offset + j)
+       >= data->n_vertices - (guint) mesh->mesh.base_vertex)
+    {
+      g_set_error_literal
+      (error,
+       DS_MODEL_ERROR,
+       DS_MODEL_ERROR_INVALID_CACHE,
+       "Index out of bounds\r\n");
+      goto_error();
+    }
+  }
+
+_error_:
+return success;
+}
+
+/*
+ * Model data
+ *
+ */
+
+G_GNUC_INTERNAL
+DsModelData*
+_ds_model_data_new(DsPencilFormat  format,
+                   guint           index_size,
+                   guint           n_vertices,
+                   guint           n_indices,
+                   guint           n_meshes,
+                   guint           n_materials,
+                   guint           n_names,
+                   gsize           strings_length)
+{
+  g_return_val_if_fail(index_size == sizeof(guint16) || index_size == sizeof(guint32), NULL);
+  g_return_val_if_fail(strings_length > 0, NULL);
+  g_return_val_if_fail(strings_length <= G_MAXUINT, NULL);
+  DsModelData* data = NULL;
+  Header header = {0};
+  guchar* base = NULL;
+  gsize length;
+
+  memcpy(&(header.magic), &s_magic, sizeof(s_magic));
+  header.version = CACHE_VERSION;
+  header.vertex_format = format;
+  header.vertex_size = ds_pencil_format_get_stride(format);
+  header.index_size = index_size;
+  header.n_vertices = n_vertices;
+  header.n_indices = n_indices;
+  header.n_meshes = n_meshes;
+  header.n_materials = n_materials;
+  header.n_names = n_names;
+  header.strings_length = (guint) strings_length;
+
+  length = layout(&header, NULL, NULL);
+  base = g_malloc0(length);
+  memcpy(base, &header, sizeof(header));
+
+  data = g_slice_new0(DsModelData);
+  data->blob = g_bytes_new_take(base, length);
+  layout(&header, data, base);
+return data;
+}
+
+G_GNUC_INTERNAL
+DsModelData*
+_ds_model_data_new_from_bytes(GBytes* bytes, GError** error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  DsModelData* data = NULL;
+  const Header* header;
+  gsize length = 0;
+
+/*
+ * Sanity checks
+ *
+ */
+
+  header = (const Header*)
+  g_bytes_get_data(bytes, &length);
+
+  if G_UNLIKELY(sizeof(Header) > length || header == NULL)
+  {
+    g_set_error_literal
+    (error,
+     DS_MODEL_ERROR,
+     DS_MODEL_ERROR_INVALID_CACHE,
+     "Invalid file size\r\n");
+    goto_error();
+  }
+
+  if G_UNLIKELY(memcmp(header->magic, s_magic, sizeof(s_magic)) != 0)
+  {
+    g_set_error_literal
+    (error,
+     DS_MODEL_ERROR,
+     DS_MODEL_ERROR_INVALID_CACHE,
+     "Invalid file magic\r\n");
+    goto_error();
+  }
+
+  if G_UNLIKELY
+    (header->version != CACHE_VERSION
+     || (header->vertex_format != DS_PENCIL_FORMAT_PACKED
+      && header->vertex_format != DS_PENCIL_FORMAT_BASIC)
+     || header->vertex_size != ds_pencil_format_get_stride(header->vertex_format)
+     || (header->index_size != sizeof(guint16)
+      && header->index_size != sizeof(guint32)))
+  {
+    g_set_error_literal
+    (error,
+     DS_MODEL_ERROR,
+     DS_MODEL_ERROR_INVALID_CACHE,
+     "Incompatible file version\r\n");
+    goto_error();
+  }
+
+  if G_UNLIKELY(layout(header, NULL, NULL) != length)
+  {
+    g_set_error_literal
+    (error,
+     DS_MODEL_ERROR,
+     DS_MODEL_ERROR_INVALID_CACHE,
+     "Invalid blob size\r\n");
+    goto_error();
+  }
+
+/*
+ * Point into blob
+ *
+ */
+
+  data = g_slice_new0(DsModelData);
+  data->blob = g_bytes_ref(bytes);
+  layout(header, data, (guchar*) header);
+
+  success =
+  validate(header, data, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+_error_:
+  if G_UNLIKELY(success == FALSE)
+    _ds_model_data_free0(data);
+return data;
+}
+
+G_GNUC_INTERNAL
+void
+_ds_model_data_free(DsModelData* data)
+{
+  g_return_if_fail(data != NULL);
+  _g_bytes_unref0(data->blob);
+  g_strfreev(data->companions);
+  g_slice_free(DsModelData, data);
+}
+
+/*
+ * Cache
+ *
+ */
+
+static GFile*
+get_model_cache_file(DsCacheProvider* cprov, const gchar* key, GCancellable* cancellable, GError** error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GFile* return_ = NULL;
+  GFile* basedir = NULL;
+  gchar* name = NULL;
+
+  basedir =
+  ds_folder_provider_child(DS_FOLDER_PROVIDER(cprov), "models", cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  name = g_strconcat(key, ".model", NULL);
+  return_ = g_file_get_child(basedir, name);
+
+_error_:
+  g_clear_object(&basedir);
+  _g_free0(name);
+return return_;
+}
+
+static gboolean
+query_companion(GFile* source, const gchar* name, guint64* size, guint64* mtime, GCancellable* cancellable, GError** error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GFileInfo* info = NULL;
+  GFile* file = NULL;
+
+  file = g_file_get_child(source, name);
+  info =
+  g_file_query_info(file, COMPANION_ATTRIBUTES, G_FILE_QUERY_INFO_NONE, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  *size = (guint64) g_file_info_get_size(info);
+  *mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+         + g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+_error_:
+  _g_file_info_unref0(info);
+  _g_object_unref0(file);
+return success;
+}
+
+static GVariant*
+pack_companions(GFile* source, gchar** companions, GCancellable* cancellable, GError** error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GVariantBuilder builder;
+  guint64 size, mtime;
+  gchar** name;
+
+  g_variant_builder_init(&builder, COMPANIONS_TYPE);
+
+  for(name = companions;
+      name != NULL && *name != NULL;
+      name++)
+  {
+    success =
+    query_companion(source, *name, &size, &mtime, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+
+    g_variant_builder_add(&builder, "(stt)", *name, size, mtime);
+  }
+
+_error_:
+  if G_UNLIKELY(success == FALSE)
+  {
+    g_variant_builder_clear(&builder);
+    return NULL;
+  }
+return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
+static gboolean
+check_companions(GFile* source, GBytes* bytes, GCancellable* cancellable, GError** error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GVariant* companions = NULL;
+  guint64 size, mtime, size_, mtime_;
+  const gchar* name;
+  GVariantIter iter;
+
+  companions =
+  g_variant_new_from_bytes(COMPANIONS_TYPE, bytes, FALSE);
+  g_variant_ref_sink(companions);
+  g_variant_iter_init(&iter, companions);
+
+  while(g_variant_iter_next(&iter, "(&stt)", &name, &size, &mtime))
+  {
+    query_companion(source, name, &size_, &mtime_, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      if(g_error_matches(tmp_err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      {
+        g_propagate_error(error, tmp_err);
+        goto_error();
+      }
+
+      g_clear_error(&tmp_err);
+      size_ = G_MAXUINT64;
+    }
+
+    if G_UNLIKELY(size != size_ || mtime != mtime_)
+    {
+      g_set_error
+      (error,
+       DS_MODEL_ERROR,
+       DS_MODEL_ERROR_INVALID_CACHE,
+       "Companion file '%s' changed\r\n",
+       name);
+      goto_error();
+    }
+  }
+
+_error_:
+  _g_variant_unref0(companions);
+return success;
+}
+
+G_GNUC_INTERNAL
+gchar*
+_ds_model_cache_key(GFile             *source,
+                    const gchar       *name,
+                    DsModelAttributes  attributes,
+                    GCancellable      *cancellable,
+                    GError           **error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GInputStream* stream = NULL;
+  GChecksum* checksum = NULL;
+  GFile* file = NULL;
+  gchar* return_ = NULL;
+  guchar* buffer = NULL;
+  gssize read;
+
+  const guint salt[] =
+  {
+    CACHE_VERSION,
+    _ds_model_import_flags(attributes),
+    attributes,
+    sizeof(DsModelIndex),
+  };
+
+  checksum = g_checksum_new(G_CHECKSUM_SHA256);
+  g_checksum_update(checksum, (const guchar*) salt, sizeof(salt));
+  g_checksum_update(checksum, (const guchar*) name, strlen(name) + 1);
+
+/*
+ * Hash source bytes
+ *
+ */
+
+  file = g_file_get_child(source, name);
+  stream = (GInputStream*)
+  g_file_read(file, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  buffer = g_malloc(HASH_CHUNK);
+
+  do
+  {
+    read =
+    g_input_stream_read(stream, buffer, HASH_CHUNK, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+
+    g_checksum_update(checksum, buffer, read);
+  }
+  while(read > 0);
+
+  return_ = g_strdup(g_checksum_get_string(checksum));
+
+_error_:
+  _g_object_unref0(stream);
+  _g_object_unref0(file);
+  _g_checksum_free0(checksum);
+  _g_free0(buffer);
+return return_;
+}
+
+G_GNUC_INTERNAL
+DsModelData*
+_ds_model_cache_try_load(DsCacheProvider  *cprov,
+                         const gchar      *key,
+                         GFile            *source,
+                         GCancellable     *cancellable,
+                         GError          **error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GMappedFile* mapped = NULL;
+  DsModelData* data = NULL;
+  GBytes* bytes = NULL;
+  GBytes* blob = NULL;
+  GBytes* companions = NULL;
+  GFile* file = NULL;
+  gchar* path = NULL;
+  guint32 tail = 0;
+  gsize length;
+
+  file =
+  get_model_cache_file(cprov, key, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+/*
+ * Map file (or load it whole,
+ * when it is not a local one)
+ *
+ */
+
+  path = g_file_get_path(file);
+  if G_LIKELY(path != NULL)
+  {
+    mapped =
+    g_mapped_file_new(path, FALSE, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      if(g_error_matches(tmp_err, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+      {
+        g_error_free(tmp_err);
+        goto _error_;
+      }
+      else
+      {
+        g_propagate_error(error, tmp_err);
+        goto_error();
+      }
+    }
+
+    bytes = g_mapped_file_get_bytes(mapped);
+  }
+  else
+  {
+    bytes =
+    g_file_load_bytes(file, cancellable, NULL, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      if(g_error_matches(tmp_err, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+      {
+        g_error_free(tmp_err);
+        goto _error_;
+      }
+      else
+      {
+        g_propagate_error(error, tmp_err);
+        goto_error();
+      }
+    }
+  }
+
+/*
+ * Split companion list off
+ *
+ */
+
+  length = g_bytes_get_size(bytes);
+  if G_LIKELY(length >= sizeof(tail))
+    memcpy(&tail, (const guchar*) g_bytes_get_data(bytes, NULL) + length - sizeof(tail), sizeof(tail));
+
+  if G_UNLIKELY(length < sizeof(tail) || tail > length - sizeof(tail))
+  {
+    g_set_error_literal
+    (error,
+     DS_MODEL_ERROR,
+     DS_MODEL_ERROR_INVALID_CACHE,
+     "Invalid file size\r\n");
+    goto_error();
+  }
+
+  length -= sizeof(tail) + tail;
+  blob = g_bytes_new_from_bytes(bytes, 0, length);
+  companions = g_bytes_new_from_bytes(bytes, length, tail);
+
+  success =
+  check_companions(source, companions, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  data =
+  _ds_model_data_new_from_bytes(blob, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+_error_:
+  _g_mapped_file_unref0(mapped);
+  _g_bytes_unref0(companions);
+  _g_bytes_unref0(blob);
+  _g_bytes_unref0(bytes);
+  _g_object_unref0(file);
+  _g_free0(path);
+return data;
+}
+
+G_GNUC_INTERNAL
+gboolean
+_ds_model_cache_try_save(DsCacheProvider  *cprov,
+                         const gchar      *key,
+                         GFile            *source,
+                         DsModelData      *data,
+                         GCancellable     *cancellable,
+                         GError          **error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GVariant* companions = NULL;
+  GByteArray* contents = NULL;
+  GFile* file = NULL;
+  gconstpointer bytes;
+  guint32 tail;
+  gsize length;
+
+  file =
+  get_model_cache_file(cprov, key, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  companions =
+  pack_companions(source, data->companions, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  bytes = g_bytes_get_data(data->blob, &length);
+  tail = (guint32) g_variant_get_size(companions);
+
+  contents = g_byte_array_sized_new(length + tail + sizeof(tail));
+  g_byte_array_append(contents, bytes, length);
+  g_byte_array_append(contents, g_variant_get_data(companions), tail);
+  g_byte_array_append(contents, (const guint8*) &tail, sizeof(tail));
+
+  /* replaced atomically, so a concurrent
+   * reader never maps an half-written file */
+  success =
+  g_file_replace_contents(file, (const gchar*) contents->data, contents->len, NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+_error_:
+  _g_byte_array_unref0(contents);
+  _g_variant_unref0(companions);
+  _g_object_unref0(file);
+return success;
+}
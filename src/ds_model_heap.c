@@ -0,0 +1,299 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <ds_model_private.h>
+
+/*
+ * Geometry heap, shared by every model.
+ * There is a heap per vertex format, plus
+ * one for indices, each made of a few large
+ * immutable-storage buffers (chunks). Ranges
+ * are carved from chunks using a first-fit
+ * free list (coalesced on release), aligned
+ * to vertex stride (so offsets can be turned
+ * into base vertices) or to four bytes (for
+ * indices, whatever their width).
+ *
+ * Since models share buffers, consecutive
+ * draws under a shader do not rebind them.
+ *
+ */
+
+typedef struct _Chunk Chunk;
+typedef struct _Span  Span;
+typedef struct _Heap  Heap;
+
+#define CHUNK_SIZE (32 * 1024 * 1024)
+
+struct _Span
+{
+  gsize offset;
+  gsize length;
+};
+
+struct _Chunk
+{
+  GLuint buffer;
+  gsize length;
+  guint n_ranges;
+  GArray* spans;
+};
+
+struct _Heap
+{
+  GList* chunks;
+};
+
+static Heap heaps[DS_MODEL_HEAP_N];
+G_LOCK_DEFINE_STATIC(heaps);
+
+/*
+ * Helpers
+ *
+ */
+
+static gsize
+get_alignment(DsModelHeapKind kind)
+{
+  if(kind == DS_MODEL_HEAP_INDICES)
+    return 4;
+return ds_pencil_format_get_stride((DsPencilFormat) kind);
+}
+
+static Chunk*
+chunk_new(gsize length, GError** error)
+{
+  gboolean success = TRUE;
+  Chunk* chunk = NULL;
+  GLuint buffer = 0;
+  Span span = {0};
+
+  __gl_try_catch(
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, length, NULL, GL_DYNAMIC_STORAGE_BIT);
+  ,
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
+
+  chunk = g_slice_new0(Chunk);
+  chunk->buffer = ds_steal_handle_id(&buffer);
+  chunk->length = length;
+  chunk->spans = g_array_new(FALSE, FALSE, sizeof(Span));
+
+  span.length = length;
+  g_array_append_val(chunk->spans, span);
+
+_error_:
+  if G_UNLIKELY(buffer != 0)
+    glDeleteBuffers(1, &buffer);
+return chunk;
+}
+
+static void
+chunk_free(Chunk* chunk)
+{
+  __gl_try_catch(
+    glDeleteBuffers(1, &(chunk->buffer));
+  ,
+    g_warning
+    ("(%s: %i): %s: %i: %s\r\n",
+     G_STRFUNC,
+     __LINE__,
+     g_quark_to_string(glerror->domain),
+     glerror->code,
+     glerror->message);
+    g_error_free(glerror);
+  );
+
+  g_array_unref(chunk->spans);
+  g_slice_free(Chunk, chunk);
+}
+
+static gboolean
+chunk_carve(Chunk* chunk, gsize length, gsize* offset)
+{
+  Span* span;
+  guint i;
+
+  for(i = 0;
+      i < chunk->spans->len;
+      i++)
+  {
+    span = &g_array_index(chunk->spans, Span, i);
+    if(span->length < length)
+      continue;
+
+    *offset = span->offset;
+    span->offset += length;
+    span->length -= length;
+
+    if(span->length == 0)
+      g_array_remove_index(chunk->spans, i);
+    return TRUE;
+  }
+return FALSE;
+}
+
+static void
+chunk_release(Chunk* chunk, gsize offset, gsize length)
+{
+  Span span = {offset, length};
+  Span *prev, *next;
+  guint i;
+
+  /* spans are sorted by offset */
+  for(i = 0;
+      i < chunk->spans->len;
+      i++)
+  if(g_array_index(chunk->spans, Span, i).offset > offset)
+    break;
+
+  g_array_insert_val(chunk->spans, i, span);
+
+  /* coalesce with neighbours */
+  if(i + 1 < chunk->spans->len)
+  {
+    next = &g_array_index(chunk->spans, Span, i + 1);
+    prev = &g_array_index(chunk->spans, Span, i);
+    if(prev->offset + prev->length == next->offset)
+    {
+      prev->length += next->length;
+      g_array_remove_index(chunk->spans, i + 1);
+    }
+  }
+
+  if(i > 0)
+  {
+    prev = &g_array_index(chunk->spans, Span, i - 1);
+    next = &g_array_index(chunk->spans, Span, i);
+    if(prev->offset + prev->length == next->offset)
+    {
+      prev->length += next->length;
+      g_array_remove_index(chunk->spans, i);
+    }
+  }
+}
+
+/*
+ * Internal API
+ *
+ */
+
+/*
+ * Must be called on GL thread; @data
+ * is uploaded in place
+ *
+ */
+G_GNUC_INTERNAL
+gboolean
+_ds_model_heap_alloc(DsModelHeapKind   kind,
+                     gsize             length,
+                     gconstpointer     data,
+                     DsModelRange     *range,
+                     GError          **error)
+{
+  g_return_val_if_fail(kind < DS_MODEL_HEAP_N, FALSE);
+  g_return_val_if_fail(range != NULL, FALSE);
+  Heap* heap = &(heaps[kind]);
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  gsize align = get_alignment(kind);
+  gsize offset = 0;
+  Chunk* chunk = NULL;
+  GList* list;
+
+  /* zero-length ranges still get a buffer */
+  length = MAX(length, 1);
+  length = ((length + align - 1) / align) * align;
+
+  G_LOCK(heaps);
+
+  for(list = heap->chunks;
+      list != NULL;
+      list = list->next)
+  if(chunk_carve(list->data, length, &offset))
+  {
+    chunk = list->data;
+    break;
+  }
+
+  if G_UNLIKELY(chunk == NULL)
+  {
+    chunk =
+    chunk_new(MAX(length, (CHUNK_SIZE / align) * align), &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+
+    heap->chunks = g_list_append(heap->chunks, chunk);
+    chunk_carve(chunk, length, &offset);
+  }
+
+  __gl_try_catch(
+    if G_LIKELY(data != NULL)
+      glNamedBufferSubData(chunk->buffer, offset, length, data);
+  ,
+    chunk_release(chunk, offset, length);
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
+
+  ++chunk->n_ranges;
+  range->chunk = chunk;
+  range->p_buffer = &(chunk->buffer);
+  range->kind = kind;
+  range->offset = offset;
+  range->length = length;
+
+_error_:
+  G_UNLOCK(heaps);
+return success;
+}
+
+/*
+ * May delete a chunk, so GL thread only
+ *
+ */
+G_GNUC_INTERNAL
+void
+_ds_model_heap_free(DsModelRange* range)
+{
+  g_return_if_fail(range != NULL);
+  Chunk* chunk = range->chunk;
+  Heap* heap = NULL;
+
+  if G_UNLIKELY(chunk == NULL)
+    return;
+
+  G_LOCK(heaps);
+  heap = &(heaps[range->kind]);
+  chunk_release(chunk, range->offset, range->length);
+
+  /* give back chunks nobody uses, except the first */
+  if(--chunk->n_ranges == 0 && heap->chunks->data != chunk)
+  {
+    heap->chunks = g_list_remove(heap->chunks, chunk);
+    chunk_free(chunk);
+  }
+
+  G_UNLOCK(heaps);
+  memset(range, 0, sizeof(DsModelRange));
+}
@@ -24,6 +24,7 @@ G_DEFINE_QUARK(ds-model-import-aifileio-data-quark,
                ds_model_imp_fio_data);
 
 typedef struct _FioData FioData;
+typedef struct _MapData MapData;
 
 #define _fio_data_free0(var) ((var == NULL) ? NULL : (var = (_fio_data_free0 (var), NULL)))
 #define _fileio_free0(var) ((var == NULL) ? NULL : (var = (_fileio_free0 (var), NULL)))
@@ -42,6 +43,16 @@ struct _FioData
 
   GCancellable* cancellable;
   GError* error;
+  GPtrArray* opened;
+};
+
+struct _MapData
+{
+  FioData* chain;
+  GMappedFile* mapped;
+  const gchar* contents;
+  gsize length;
+  gsize position;
 };
 
 /*
@@ -86,6 +97,23 @@ push_error(FioData* data, GError* src)
     push_error0(data, src);
 }
 
+static void
+push_opened(FioData* data, const gchar* path)
+{
+  guint i;
+
+  if G_UNLIKELY(data->opened == NULL)
+    data->opened = g_ptr_array_new_with_free_func(g_free);
+
+  for(i = 0;
+      i < data->opened->len;
+      i++)
+  if(!strcmp(g_ptr_array_index(data->opened, i), path))
+    return;
+
+  g_ptr_array_add(data->opened, g_strdup(path));
+}
+
 static GError*
 pop_error(FioData* data)
 {
@@ -103,6 +131,7 @@ static void
   {
     g_clear_object(&(data->object));
     g_clear_object(&(data->cancellable));
+    g_clear_pointer(&(data->opened), g_ptr_array_unref);
 
     if G_UNLIKELY(data->error != NULL)
     {
@@ -276,6 +305,8 @@ ai_open_proc(C_STRUCT aiFileIO* fio, const gchar* path, const gchar* mode)
   data2->stream = g_steal_pointer(&stream);
   data2->cancellable = _g_object_ref0(data->cancellable);
   data2->error = NULL;
+  data2->opened = NULL;
+  push_opened(data, path);
 
   ifile->ReadProc = ai_read_proc;
   ifile->WriteProc = NULL;
@@ -326,14 +357,177 @@ aio_close_proc(C_STRUCT aiFileIO* fio, C_STRUCT aiFile* ifile)
   }
 }
 
+/*
+ * aiFileIO virtual functions (mapped)
+ *
+ * Native files are mapped in whole and
+ * served from memory, so Assimp's many
+ * small reads and seeks never reach GIO
+ *
+ */
+
+static size_t
+ai_map_read_proc(C_STRUCT aiFile* ifile, char* buffer, size_t size, size_t count)
+{
+  MapData* data = (MapData*) ifile->UserData;
+  gsize n_items;
+
+  if G_UNLIKELY(size == 0)
+    return 0;
+
+  n_items = MIN(count, (data->length - data->position) / size);
+  memcpy(buffer, data->contents + data->position, n_items * size);
+  data->position += n_items * size;
+return (size_t) n_items;
+}
+
+static size_t
+ai_map_tell_proc(C_STRUCT aiFile* ifile)
+{
+  MapData* data = (MapData*) ifile->UserData;
+return (size_t) data->position;
+}
+
+static size_t
+ai_map_file_size_proc(C_STRUCT aiFile* ifile)
+{
+  MapData* data = (MapData*) ifile->UserData;
+return (size_t) data->length;
+}
+
+static C_ENUM aiReturn
+ai_map_seek_proc(C_STRUCT aiFile* ifile, size_t offset, C_ENUM aiOrigin from)
+{
+  MapData* data = (MapData*) ifile->UserData;
+  gsize position = 0;
+
+  switch(from)
+  {
+  case aiOrigin_SET:
+    position = offset;
+    break;
+  case aiOrigin_CUR:
+    position = data->position + offset;
+    break;
+  case aiOrigin_END:
+    position = data->length + offset;
+    break;
+  default:
+    g_assert_not_reached();
+    break;
+  }
+
+  if G_UNLIKELY(position > data->length)
+    return aiReturn_FAILURE;
+
+  data->position = position;
+return aiReturn_SUCCESS;
+}
+
+static C_STRUCT aiFile*
+ai_map_open_proc(C_STRUCT aiFileIO* fio, const gchar* path, const gchar* mode)
+{
+  FioData* data = (FioData*) fio->UserData;
+  C_STRUCT aiFile* ifile = NULL;
+  GMappedFile* mapped = NULL;
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  gchar* filename = NULL;
+  MapData* data2 = NULL;
+
+  g_assert(mode[0] == 'r');
+
+/*
+ * Map file
+ *
+ */
+
+  GFile* file =
+  g_file_get_child(data->source, path);
+  filename = g_file_get_path(file);
+  g_object_unref(file);
+
+  mapped =
+  g_mapped_file_new(filename, FALSE, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    push_error(data, tmp_err);
+    goto_error();
+  }
+
+/*
+ * Prepare aiFile structure
+ *
+ */
+
+  data2 = g_slice_new0(MapData);
+  ifile = g_slice_new(C_STRUCT aiFile);
+  ifile->UserData = (aiUserData) data2;
+
+  data2->chain = data;
+  data2->length = g_mapped_file_get_length(mapped);
+  data2->contents = g_mapped_file_get_contents(mapped);
+  data2->mapped = g_steal_pointer(&mapped);
+  push_opened(data, path);
+
+  ifile->ReadProc = ai_map_read_proc;
+  ifile->WriteProc = NULL;
+  ifile->TellProc = ai_map_tell_proc;
+  ifile->FileSizeProc = ai_map_file_size_proc;
+  ifile->SeekProc = ai_map_seek_proc;
+  ifile->FlushProc = NULL;
+
+_error_:
+  if G_UNLIKELY(mapped != NULL)
+    g_mapped_file_unref(mapped);
+  _g_free0(filename);
+return ifile;
+}
+
+static void
+aio_map_close_proc(C_STRUCT aiFileIO* fio, C_STRUCT aiFile* ifile)
+{
+  MapData* data2 = (MapData*) ifile->UserData;
+
+  g_mapped_file_unref(data2->mapped);
+  g_slice_free(MapData, data2);
+  g_slice_free(C_STRUCT aiFile, ifile);
+}
+
 /*
  * Entry
  *
  */
 
+G_GNUC_INTERNAL
+guint
+_ds_model_import_flags(DsModelAttributes attributes)
+{
+  guint flags =
+    aiProcess_JoinIdenticalVertices
+  | aiProcess_OptimizeGraph
+  | aiProcess_OptimizeMeshes
+  | aiProcess_Triangulate;
+
+  /*
+   * Skip post-processing steps
+   * which generates attributes
+   * nobody will consume
+   *
+   */
+
+  if(attributes & (DS_MODEL_ATTRIBUTE_TANGENT | DS_MODEL_ATTRIBUTE_BITANGENT))
+    flags |= aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals | aiProcess_GenUVCoords;
+  if(attributes & DS_MODEL_ATTRIBUTE_NORMAL)
+    flags |= aiProcess_GenSmoothNormals;
+  if(attributes & DS_MODEL_ATTRIBUTE_UV)
+    flags |= aiProcess_GenUVCoords;
+return flags;
+}
+
 G_GNUC_INTERNAL
 const C_STRUCT aiScene*
-_ds_model_import_new(DsModel* self, GFile* source, const gchar* name, GCancellable* cancellable, GError** error)
+_ds_model_import_new(DsModel* self, GFile* source, const gchar* name, DsModelAttributes attributes, GCancellable* cancellable, GError** error)
 {
   gboolean success = TRUE;
   GError* tmp_err = NULL;
@@ -348,20 +542,23 @@ _ds_model_import_new(DsModel* self, GFile* source, const gchar* name, GCancellab
   data->source = _g_object_ref0(source);
   data->cancellable = _g_object_ref0(cancellable);
 
-  fio->OpenProc = ai_open_proc;
-  fio->CloseProc = aio_close_proc;
+  if(g_file_is_native(source))
+  {
+    fio->OpenProc = ai_map_open_proc;
+    fio->CloseProc = aio_map_close_proc;
+  }
+  else
+  {
+    fio->OpenProc = ai_open_proc;
+    fio->CloseProc = aio_close_proc;
+  }
+
   fio->UserData = (aiUserData) data;
 
   scene =
   aiImportFileEx
   (name,
-     aiProcess_CalcTangentSpace
-   | aiProcess_GenSmoothNormals
-   | aiProcess_GenUVCoords
-   | aiProcess_JoinIdenticalVertices
-   | aiProcess_OptimizeGraph
-   | aiProcess_OptimizeMeshes
-   | aiProcess_Triangulate,
+   _ds_model_import_flags(attributes),
    fio);
 
   tmp_err = pop_error(data);
@@ -409,6 +606,38 @@ _error_:
 return scene;
 }
 
+/*
+ * Files importer opened besides @name
+ * (materials and such), relative to
+ * source; NULL-terminated
+ *
+ */
+G_GNUC_INTERNAL
+gchar**
+_ds_model_import_get_companions(DsModel* self, const gchar* name)
+{
+  GPtrArray* companions = NULL;
+  FioData* data = NULL;
+  const gchar* path;
+  guint i;
+
+  companions = g_ptr_array_new();
+  data = g_object_get_qdata(G_OBJECT(self), ds_model_imp_fio_data_quark());
+
+  if G_LIKELY(data != NULL && data->opened != NULL)
+  for(i = 0;
+      i < data->opened->len;
+      i++)
+  {
+    path = g_ptr_array_index(data->opened, i);
+    if(strcmp(path, name) != 0)
+      g_ptr_array_add(companions, g_strdup(path));
+  }
+
+  g_ptr_array_add(companions, NULL);
+return (gchar**) g_ptr_array_free(companions, FALSE);
+}
+
 G_GNUC_INTERNAL
 void
 _ds_model_import_free(DsModel* self, const C_STRUCT aiScene* scene)
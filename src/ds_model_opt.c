@@ -0,0 +1,599 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <ds_model_private.h>
+
+/*
+ * Mesh optimization, done once at import
+ * (results land on model cache). Each mesh
+ * goes through three passes:
+ *
+ * - Triangles are reordered for post-transform
+ *   vertex cache locality, using Tipsify (Sander,
+ *   Nehab & Barczak, "Fast triangle reordering
+ *   for vertex locality and reduced overdraw").
+ * - Clusters produced by first pass are sorted
+ *   from outside in (by how much they face away
+ *   from mesh centroid), which reduces overdraw
+ *   without hurting cache locality much.
+ * - Vertices are renumbered (and moved) by first
+ *   use, so vertex fetch walks memory forward.
+ *
+ */
+
+typedef struct _OptData OptData;
+typedef struct _Cluster Cluster;
+
+#define CACHE_SIZE (16)
+
+struct _OptData
+{
+  DsModelData* data;
+  GMutex lock;
+  guint64 triangles;
+  guint64 misses_before;
+  guint64 misses_after;
+};
+
+struct _Cluster
+{
+  guint first;
+  guint count;
+  gfloat sort;
+};
+
+/*
+ * Helpers
+ *
+ */
+
+static guint
+count_misses(const DsModelIndex* indices, guint n_indices, guint n_vertices)
+{
+  guint* stamps = g_new0(guint, n_vertices);
+  guint i, v, time = CACHE_SIZE + 1, misses = 0;
+
+  /* a FIFO cache, as most hardware has */
+  for(i = 0;
+      i < n_indices;
+      i++)
+  {
+    v = indices[i];
+    if(time - stamps[v] > CACHE_SIZE)
+    {
+      stamps[v] = time++;
+      ++misses;
+    }
+  }
+
+  g_free(stamps);
+return misses;
+}
+
+static inline void
+get_position(DsModelData* data, guint stride, guint v, gfloat* p)
+{
+  const gint16* s = (const gint16*) ((const guchar*) data->vertices + (gsize) stride * v);
+  guint k;
+
+  /* position is first member on every packed format */
+  for(k = 0;
+      k < 3;
+      k++)
+  {
+    p[k] = data->aabb[k] + data->aabb[k + 3] * ((gfloat) s[k] / 32767.f);
+  }
+}
+
+static gint
+cluster_compare(gconstpointer a, gconstpointer b)
+{
+  gfloat sa = ((const Cluster*) a)->sort;
+  gfloat sb = ((const Cluster*) b)->sort;
+return (sa < sb) - (sa > sb);
+}
+
+/*
+ * Tipsify
+ *
+ */
+
+static guint
+tipsify(const DsModelIndex  *indices,
+        guint                n_triangles,
+        guint                n_vertices,
+        DsModelIndex        *output,
+        guint               *clusters)
+{
+  guint* offsets = g_new0(guint, n_vertices + 1);
+  guint* adjacency = g_new(guint, n_triangles * 3);
+  guint* live = g_new0(guint, n_vertices);
+  guint* stamps = g_new0(guint, n_vertices);
+  guint* deadend = g_new(guint, n_triangles * 3);
+  guint* candidates = g_new(guint, n_triangles * 3);
+  gboolean* emitted = g_new0(gboolean, n_triangles);
+  guint i, j, t, v, n_candidates;
+  guint n_deadend = 0, n_output = 0, n_clusters = 0;
+  guint time = CACHE_SIZE + 1, cursor = 0;
+  gint fanning = 0, best, priority, score;
+
+  if G_UNLIKELY(n_vertices == 0)
+    goto _error_;
+
+  /* vertex -> triangles adjacency */
+  for(i = 0;
+      i < n_triangles * 3;
+      i++)
+  {
+    ++live[indices[i]];
+  }
+
+  for(v = 0;
+      v < n_vertices;
+      v++)
+  {
+    offsets[v + 1] = offsets[v] + live[v];
+  }
+
+  for(i = 0;
+      i < n_triangles * 3;
+      i++)
+  {
+    v = indices[i];
+    adjacency[offsets[v + 1] - live[v]] = i / 3;
+    --live[v];
+  }
+
+  for(i = 0;
+      i < n_triangles * 3;
+      i++)
+  {
+    ++live[indices[i]];
+  }
+
+  clusters[n_clusters++] = 0;
+
+  while(fanning >= 0)
+  {
+    n_candidates = 0;
+
+    /* emit every pending triangle around fanning vertex */
+    for(j = offsets[fanning];
+        j < offsets[fanning + 1];
+        j++)
+    {
+      t = adjacency[j];
+      if(emitted[t] == TRUE)
+        continue;
+
+      for(i = 0;
+          i < 3;
+          i++)
+      {
+        v = indices[t * 3 + i];
+        output[n_output * 3 + i] = v;
+        deadend[n_deadend++] = v;
+        --live[v];
+
+        candidates[n_candidates++] = v;
+        if(time - stamps[v] > CACHE_SIZE)
+          stamps[v] = time++;
+      }
+
+      emitted[t] = TRUE;
+      ++n_output;
+    }
+
+    /* next fanning vertex, preferably still in cache */
+    best = -1;
+    priority = -1;
+
+    for(i = 0;
+        i < n_candidates;
+        i++)
+    {
+      v = candidates[i];
+      if(live[v] == 0)
+        continue;
+
+      score = 0;
+      if(time - stamps[v] + 2 * live[v] <= CACHE_SIZE)
+        score = time - stamps[v];
+      if(score > priority)
+      {
+        priority = score;
+        best = v;
+      }
+    }
+
+    if(best < 0)
+    {
+      /* dead end, start a new cluster */
+      while(n_deadend > 0)
+      {
+        v = deadend[--n_deadend];
+        if(live[v] > 0)
+        {
+          best = v;
+          break;
+        }
+      }
+
+      while(best < 0 && cursor < n_vertices)
+      {
+        if(live[cursor] > 0)
+          best = cursor;
+        ++cursor;
+      }
+
+      if(best >= 0 && n_output > clusters[n_clusters - 1])
+        clusters[n_clusters++] = n_output;
+    }
+
+    fanning = best;
+  }
+
+  g_assert(n_output == n_triangles);
+
+_error_:
+  g_free(offsets);
+  g_free(adjacency);
+  g_free(live);
+  g_free(stamps);
+  g_free(deadend);
+  g_free(candidates);
+  g_free(emitted);
+return n_clusters;
+}
+
+/*
+ * Overdraw
+ *
+ */
+
+static inline gfloat
+get_triangle(DsModelData          *data,
+             guint                 stride,
+             guint                 base_vertex,
+             const DsModelIndex   *triangle,
+             gfloat               *center,
+             gfloat               *normal)
+{
+  gfloat p[3][3], e1[3], e2[3];
+  guint i, k;
+
+  for(i = 0;
+      i < 3;
+      i++)
+  {
+    get_position(data, stride, base_vertex + triangle[i], p[i]);
+  }
+
+  for(k = 0;
+      k < 3;
+      k++)
+  {
+    e1[k] = p[1][k] - p[0][k];
+    e2[k] = p[2][k] - p[0][k];
+    center[k] = (p[0][k] + p[1][k] + p[2][k]) / 3.f;
+  }
+
+  /* unnormalized, so its length is twice the area */
+  normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+return sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+}
+
+static void
+sort_clusters(DsModelData   *data,
+              guint          stride,
+              guint          base_vertex,
+              DsModelIndex  *indices,
+              guint          n_triangles,
+              guint         *bounds,
+              guint          n_clusters,
+              DsModelIndex  *output)
+{
+  Cluster* clusters = g_new(Cluster, n_clusters);
+  gfloat centroid[3] = {0}, c[3], n[3];
+  gfloat center[3], normal[3];
+  gfloat area, total = 0.f;
+  guint j, k, t, _o;
+
+  /* area-weighted mesh centroid */
+  for(t = 0;
+      t < n_triangles;
+      t++)
+  {
+    area = get_triangle(data, stride, base_vertex, &(indices[t * 3]), center, normal);
+    for(k = 0;
+        k < 3;
+        k++)
+    {
+      centroid[k] += area * center[k];
+    }
+    total += area;
+  }
+
+  if G_LIKELY(total > 0.f)
+  for(k = 0;
+      k < 3;
+      k++)
+  {
+    centroid[k] /= total;
+  }
+
+  /* per-cluster centroid and normal */
+  for(j = 0;
+      j < n_clusters;
+      j++)
+  {
+    clusters[j].first = bounds[j];
+    clusters[j].count = ((j + 1 < n_clusters) ? bounds[j + 1] : n_triangles) - bounds[j];
+    memset(c, 0, sizeof(c));
+    memset(n, 0, sizeof(n));
+    total = 0.f;
+
+    for(t = clusters[j].first;
+        t < clusters[j].first + clusters[j].count;
+        t++)
+    {
+      area = get_triangle(data, stride, base_vertex, &(indices[t * 3]), center, normal);
+      for(k = 0;
+          k < 3;
+          k++)
+      {
+        c[k] += area * center[k];
+        n[k] += normal[k];
+      }
+      total += area;
+    }
+
+    if G_LIKELY(total > 0.f)
+    for(k = 0;
+        k < 3;
+        k++)
+    {
+      c[k] /= total;
+    }
+
+    /* clusters facing outwards go first */
+    clusters[j].sort =
+      (c[0] - centroid[0]) * n[0]
+    + (c[1] - centroid[1]) * n[1]
+    + (c[2] - centroid[2]) * n[2];
+    if G_LIKELY(total > 0.f)
+      clusters[j].sort /= total;
+  }
+
+  g_qsort_with_data
+  (clusters,
+   n_clusters,
+   sizeof(Cluster),
+   (GCompareDataFunc)
+   cluster_compare,
+   NULL);
+
+  for(j = 0, _o = 0;
+      j < n_clusters;
+      j++)
+  {
+    memcpy
+    (&(output[_o * 3]),
+     &(indices[clusters[j].first * 3]),
+     sizeof(DsModelIndex) * 3 * clusters[j].count);
+    _o += clusters[j].count;
+  }
+
+  g_free(clusters);
+}
+
+/*
+ * Vertex fetch
+ *
+ */
+
+static void
+remap_vertices(DsModelData   *data,
+               guint          stride,
+               guint          base_vertex,
+               guint          n_vertices,
+               DsModelIndex  *indices,
+               guint          n_indices)
+{
+  guint* remap = g_new(guint, n_vertices);
+  guchar* vertices = (guchar*) data->vertices + (gsize) stride * base_vertex;
+  guchar* copy = g_malloc((gsize) stride * n_vertices);
+  guint i, v, next = 0;
+
+  memcpy(copy, vertices, (gsize) stride * n_vertices);
+
+  for(v = 0;
+      v < n_vertices;
+      v++)
+  {
+    remap[v] = G_MAXUINT;
+  }
+
+  for(i = 0;
+      i < n_indices;
+      i++)
+  {
+    v = indices[i];
+    if(remap[v] == G_MAXUINT)
+      remap[v] = next++;
+    indices[i] = remap[v];
+  }
+
+  /* unreferenced vertices keep going last */
+  for(v = 0;
+      v < n_vertices;
+      v++)
+  {
+    if(remap[v] == G_MAXUINT)
+      remap[v] = next++;
+    memcpy(vertices + (gsize) stride * remap[v], copy + (gsize) stride * v, stride);
+  }
+
+  g_free(remap);
+  g_free(copy);
+}
+
+/*
+ * Per-mesh job
+ *
+ */
+
+static void
+optimize_mesh_job(gpointer job, OptData* odata)
+{
+  DsModelData* data = odata->data;
+  guint m = GPOINTER_TO_UINT(job) - 1;
+  DsModelMesh* mesh = &(data->meshes[m].mesh);
+  guint stride = ds_pencil_format_get_stride(data->format);
+  guint base_vertex = mesh->base_vertex;
+  guint n_vertices, n_indices = mesh->indices;
+  guint n_triangles = n_indices / 3;
+  DsModelIndex* indices = NULL;
+  DsModelIndex* scratch = NULL;
+  guint* bounds = NULL;
+  guint i, n_clusters;
+  guint before, after;
+
+  n_vertices =
+  (m + 1 < data->n_meshes)
+  ? (guint) data->meshes[m + 1].mesh.base_vertex - base_vertex
+  : data->n_vertices - base_vertex;
+
+  /* lines or points left over by triangulation */
+  if G_UNLIKELY(n_triangles == 0 || n_indices % 3 != 0)
+    return;
+
+  /* work on full width indices, whatever is stored */
+  indices = g_new(DsModelIndex, n_indices);
+
+  for(i = 0;
+      i < n_indices;
+      i++)
+  {
+    indices[i] = _ds_model_data_get_index(data, mesh->index_offset + i);
+    if G_UNLIKELY(indices[i] >= n_vertices)
+    {
+      g_free(indices);
+      return;
+    }
+  }
+
+  before = count_misses(indices, n_indices, n_vertices);
+
+  scratch = g_new(DsModelIndex, n_indices);
+  bounds = g_new(guint, n_triangles);
+
+  n_clusters =
+  tipsify(indices, n_triangles, n_vertices, scratch, bounds);
+  sort_clusters(data, stride, base_vertex, scratch, n_triangles, bounds, n_clusters, indices);
+  remap_vertices(data, stride, base_vertex, n_vertices, indices, n_indices);
+
+  after = count_misses(indices, n_indices, n_vertices);
+
+  for(i = 0;
+      i < n_indices;
+      i++)
+  {
+    _ds_model_data_set_index(data, mesh->index_offset + i, indices[i]);
+  }
+
+  g_mutex_lock(&(odata->lock));
+  odata->triangles += n_triangles;
+  odata->misses_before += before;
+  odata->misses_after += after;
+  g_mutex_unlock(&(odata->lock));
+
+  g_free(indices);
+  g_free(scratch);
+  g_free(bounds);
+}
+
+/*
+ * Internal API
+ *
+ */
+
+G_GNUC_INTERNAL
+gboolean
+_ds_model_data_optimize(DsModelData* data, GError** error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  GThreadPool* pool = NULL;
+  OptData odata = {0};
+  gint64 start = g_get_monotonic_time();
+  guint i;
+
+  odata.data = data;
+  g_mutex_init(&(odata.lock));
+
+  if G_UNLIKELY(data->n_meshes == 0)
+    goto _error_;
+
+  pool =
+  g_thread_pool_new
+  ((GFunc)
+   optimize_mesh_job,
+   &odata,
+   MAX(1, MIN(g_get_num_processors(), data->n_meshes)),
+   FALSE,
+   &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  for(i = 0;
+      i < data->n_meshes;
+      i++)
+  {
+    g_thread_pool_push(pool, GUINT_TO_POINTER(i + 1), &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+  }
+
+  /* wait for every job */
+  g_thread_pool_free(g_steal_pointer(&pool), FALSE, TRUE);
+
+  if G_LIKELY(odata.triangles > 0)
+  g_debug
+  ("(%s: %i): optimized %u meshes in %.3f ms, ACMR %.3f -> %.3f\r\n",
+   G_STRFUNC,
+   __LINE__,
+   data->n_meshes,
+   (g_get_monotonic_time() - start) / 1000.,
+   (gdouble) odata.misses_before / odata.triangles,
+   (gdouble) odata.misses_after / odata.triangles);
+
+_error_:
+  if G_UNLIKELY(pool != NULL)
+    g_thread_pool_free(pool, FALSE, TRUE);
+  g_mutex_clear(&(odata.lock));
+return success;
+}
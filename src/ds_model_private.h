@@ -24,11 +24,17 @@
 #include <assimp/scene.h>
 #include <assimp/vector2.h>
 #include <assimp/vector3.h>
+#include <ds_folder_provider.h>
 #include <ds_macros.h>
 #include <ds_model.h>
 
-typedef struct _DsModelMesh       DsModelMesh;
-typedef struct _DsModelTexture    DsModelTexture;
+typedef struct _DsModelMesh         DsModelMesh;
+typedef struct _DsModelTexture      DsModelTexture;
+typedef struct _DsModelData         DsModelData;
+typedef struct _DsModelDataMesh     DsModelDataMesh;
+typedef struct _DsModelDataMaterial DsModelDataMaterial;
+typedef struct _DsModelRange        DsModelRange;
+typedef guint                       DsModelHeapKind;
 
 typedef gboolean (*DsModelTioIterator) (DsModel* model, DsModelTexture* texture, GList* meshes, gpointer user_data);
 
@@ -65,6 +71,80 @@ struct _DsModelMesh
   GLint base_vertex;
 };
 
+/*
+ * CPU-side model contents, as they will
+ * be uploaded. Every array points into
+ * @blob, which is laid out exactly as
+ * a model cache file (so it can be either
+ * built from an import or mapped from disk).
+ * Vertex positions are relative to @aabb,
+ * which holds bounding box center and half
+ * extent, in that order
+ *
+ */
+
+struct _DsModelDataMesh
+{
+  DsModelMesh mesh;
+  guint material;
+};
+
+struct _DsModelDataMaterial
+{
+  guint first[G_N_ELEMENTS(gl2ai)];
+  guint count[G_N_ELEMENTS(gl2ai)];
+};
+
+struct _DsModelData
+{
+  GBytes* blob;
+
+  gfloat* aabb;
+  DsPencilFormat format;
+  guint n_vertices;
+  gpointer vertices;
+  guint index_size;
+  guint n_indices;
+  gpointer indices;
+  guint n_meshes;
+  DsModelDataMesh* meshes;
+  guint n_materials;
+  DsModelDataMaterial* materials;
+  guint n_names;
+  guint* names;
+  const gchar* strings;
+  gchar** companions;
+};
+
+#define _ds_model_data_get_name(data,idx) ((data)->strings + (data)->names[(idx)])
+#define _ds_model_data_get_index(data,idx) \
+  (((data)->index_size == sizeof(guint16)) \
+   ? (DsModelIndex) ((guint16*) (data)->indices)[(idx)] \
+   : (DsModelIndex) ((guint32*) (data)->indices)[(idx)])
+#define _ds_model_data_set_index(data,idx,value) \
+  (((data)->index_size == sizeof(guint16)) \
+   ? (void) (((guint16*) (data)->indices)[(idx)] = (guint16) (value)) \
+   : (void) (((guint32*) (data)->indices)[(idx)] = (guint32) (value)))
+#define _ds_model_data_free0(var) ((var == NULL) ? NULL : (var = (_ds_model_data_free (var), NULL)))
+
+/*
+ * A range on geometry heap; vertex
+ * heaps are indexed by #DsPencilFormat
+ *
+ */
+
+#define DS_MODEL_HEAP_INDICES (DS_PENCIL_FORMAT_N)
+#define DS_MODEL_HEAP_N (DS_MODEL_HEAP_INDICES + 1)
+
+struct _DsModelRange
+{
+  gpointer chunk;
+  const GLuint* p_buffer;
+  DsModelHeapKind kind;
+  gsize offset;
+  gsize length;
+};
+
 #define _aiReleaseImport0(var) ((var == NULL) ? NULL : (var = (aiReleaseImport (var), NULL)))
 
 #if __cplusplus
@@ -80,6 +160,13 @@ void
 _ds_model_iterate_tio_groups(DsModel             *self,
                              DsModelTioIterator   foreach_tio,
                              gpointer             user_data);
+G_GNUC_INTERNAL
+DsModelAttributes
+_ds_model_resolve_attributes(DsShader          *shader,
+                             DsModelAttributes  attributes);
+G_GNUC_INTERNAL
+GLenum
+_ds_model_get_index_type(DsModel* self);
 
 /*
  * ds_model_buf.c
@@ -101,23 +188,102 @@ _ds_model_compile_switch_ibo(DsModel         *self,
                              DsRenderState   *state,
                              GError         **error);
 
+/*
+ * ds_model_cache.c
+ *
+ */
+
+G_GNUC_INTERNAL
+DsModelData*
+_ds_model_data_new(DsPencilFormat  format,
+                   guint           index_size,
+                   guint           n_vertices,
+                   guint           n_indices,
+                   guint           n_meshes,
+                   guint           n_materials,
+                   guint           n_names,
+                   gsize           strings_length);
+G_GNUC_INTERNAL
+DsModelData*
+_ds_model_data_new_from_bytes(GBytes   *bytes,
+                              GError  **error);
+G_GNUC_INTERNAL
+void
+_ds_model_data_free(DsModelData* data);
+G_GNUC_INTERNAL
+gchar*
+_ds_model_cache_key(GFile             *source,
+                    const gchar       *name,
+                    DsModelAttributes  attributes,
+                    GCancellable      *cancellable,
+                    GError           **error);
+G_GNUC_INTERNAL
+DsModelData*
+_ds_model_cache_try_load(DsCacheProvider  *cprov,
+                         const gchar      *key,
+                         GFile            *source,
+                         GCancellable     *cancellable,
+                         GError          **error);
+G_GNUC_INTERNAL
+gboolean
+_ds_model_cache_try_save(DsCacheProvider  *cprov,
+                         const gchar      *key,
+                         GFile            *source,
+                         DsModelData      *data,
+                         GCancellable     *cancellable,
+                         GError          **error);
+
+/*
+ * ds_model_heap.c
+ *
+ */
+
+G_GNUC_INTERNAL
+gboolean
+_ds_model_heap_alloc(DsModelHeapKind   kind,
+                     gsize             length,
+                     gconstpointer     data,
+                     DsModelRange     *range,
+                     GError          **error);
+G_GNUC_INTERNAL
+void
+_ds_model_heap_free(DsModelRange* range);
+
 /*
  * ds_model_imp.c
  *
  */
 
+G_GNUC_INTERNAL
+guint
+_ds_model_import_flags(DsModelAttributes attributes);
 G_GNUC_INTERNAL
 const C_STRUCT aiScene*
-_ds_model_import_new(DsModel       *self,
-                     GFile         *source,
-                     const gchar   *name,
-                     GCancellable  *cancellable,
-                     GError       **error);
+_ds_model_import_new(DsModel           *self,
+                     GFile             *source,
+                     const gchar       *name,
+                     DsModelAttributes  attributes,
+                     GCancellable      *cancellable,
+                     GError           **error);
+G_GNUC_INTERNAL
+gchar**
+_ds_model_import_get_companions(DsModel                *self,
+                                const gchar            *name);
 G_GNUC_INTERNAL
 void
 _ds_model_import_free(DsModel                *self,
                       const C_STRUCT aiScene *scene);
 
+/*
+ * ds_model_opt.c
+ *
+ */
+
+G_GNUC_INTERNAL
+gboolean
+_ds_model_data_optimize(DsModelData  *data,
+                        GError      **error);
+
 /*
  * ds_model_tex.c
  *
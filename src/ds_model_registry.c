@@ -0,0 +1,564 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <ds_model_private.h>
+#include <ds_model_registry.h>
+
+/**
+ * SECTION:dsmodelregistry
+ * @Short_description: Shared model loader
+ * @Title: DsModelRegistry
+ *
+ * DsModelRegistry hands out #DsModel instances keyed
+ * by source directory, filename and vertex attributes
+ * actually imported (which decides import flags and
+ * vertex format). A model is returned again while
+ * someone still holds it (registry only keeps weak
+ * references), and loaded otherwise. Concurrent
+ * asynchronous requests for the same model share
+ * a single in-flight load.
+ *
+ */
+
+typedef struct _Entry     Entry;
+typedef struct _Waiter    Waiter;
+typedef struct _LoadData  LoadData;
+
+#define _g_hash_table_unref0(var) ((var == NULL) ? NULL : (var = (g_hash_table_unref (var), NULL)))
+
+/*
+ * Entries whose model is gone are
+ * dropped each time table doubles
+ *
+ */
+
+#define PRUNE_MIN (16)
+
+/*
+ * Object definition
+ *
+ */
+
+struct _DsModelRegistry
+{
+  GObject parent_instance;
+
+  /*<private>*/
+  GMutex lock;
+  GHashTable* entries;
+  guint prune_at;
+};
+
+struct _DsModelRegistryClass
+{
+  GObjectClass parent_class;
+};
+
+struct _Entry
+{
+  GWeakRef model;
+  gboolean loading;
+  GMainContext* context;
+  GSList* waiters;
+};
+
+struct _Waiter
+{
+  GTask* task;
+  GSource* cancel;
+};
+
+struct _LoadData
+{
+  DsModelRegistry* registry;
+  gchar* key;
+};
+
+G_DEFINE_TYPE
+(DsModelRegistry,
+ ds_model_registry,
+ G_TYPE_OBJECT);
+
+/*
+ * Helpers
+ *
+ */
+
+static void
+entry_free(Entry* entry)
+{
+  g_weak_ref_clear(&(entry->model));
+  if(entry->context != NULL)
+    g_main_context_unref(entry->context);
+  g_assert(entry->waiters == NULL);
+  g_slice_free(Entry, entry);
+}
+
+static void
+waiter_free(Waiter* waiter)
+{
+  if(waiter->cancel != NULL)
+  {
+    g_source_destroy(waiter->cancel);
+    g_source_unref(waiter->cancel);
+  }
+
+  g_object_unref(waiter->task);
+  g_slice_free(Waiter, waiter);
+}
+
+static gboolean
+entry_is_dead(const gchar* key, Entry* entry, gpointer user_data)
+{
+  DsModel* model = NULL;
+
+  if(entry->loading == TRUE)
+    return FALSE;
+
+  model = g_weak_ref_get(&(entry->model));
+  if(model == NULL)
+    return TRUE;
+
+  g_object_unref(model);
+return FALSE;
+}
+
+static gchar*
+make_key(GFile* source, const gchar* name, DsShader* shader, DsModelAttributes attributes)
+{
+  gchar* uri = g_file_get_uri(source);
+  gchar* key =
+  g_strdup_printf
+  ("%s\n%s\n%x",
+   uri,
+   name,
+   (guint) _ds_model_resolve_attributes(shader, attributes));
+  g_free(uri);
+return key;
+}
+
+/*
+ * Looks up @key, returning a live model
+ * (transfer full) if there is one. Otherwise
+ * @p_entry is set to its (maybe new) entry.
+ * Called with registry lock held.
+ *
+ */
+static DsModel*
+lookup(DsModelRegistry* self, const gchar* key, Entry** p_entry)
+{
+  Entry* entry =
+  g_hash_table_lookup(self->entries, key);
+  DsModel* model = NULL;
+
+  if(entry == NULL)
+  {
+    if G_UNLIKELY(g_hash_table_size(self->entries) >= self->prune_at)
+    {
+      g_hash_table_foreach_remove(self->entries, (GHRFunc) entry_is_dead, NULL);
+      self->prune_at = MAX(PRUNE_MIN, 2 * g_hash_table_size(self->entries));
+    }
+
+    entry = g_slice_new0(Entry);
+    g_weak_ref_init(&(entry->model), NULL);
+    g_hash_table_insert(self->entries, g_strdup(key), entry);
+  }
+  else
+  {
+    model = g_weak_ref_get(&(entry->model));
+  }
+
+  *p_entry = entry;
+return model;
+}
+
+static void
+finish_load(DsModelRegistry* self, const gchar* key, DsModel* model, const GError* error)
+{
+  GSList* waiters = NULL;
+  GSList* list = NULL;
+  Waiter* waiter = NULL;
+  Entry* entry = NULL;
+
+  g_mutex_lock(&(self->lock));
+  entry = g_hash_table_lookup(self->entries, key);
+  g_assert(entry != NULL && entry->loading == TRUE);
+
+  waiters = g_steal_pointer(&(entry->waiters));
+  entry->loading = FALSE;
+  g_clear_pointer(&(entry->context), g_main_context_unref);
+
+  if G_LIKELY(model != NULL)
+    g_weak_ref_set(&(entry->model), model);
+  else
+    g_hash_table_remove(self->entries, key);
+  g_mutex_unlock(&(self->lock));
+
+  for(list = waiters;
+      list != NULL;
+      list = list->next)
+  {
+    waiter = list->data;
+    if G_LIKELY(model != NULL)
+      g_task_return_pointer(waiter->task, g_object_ref(model), g_object_unref);
+    else
+      g_task_return_error(waiter->task, g_error_copy(error));
+    waiter_free(waiter);
+  }
+
+  g_slist_free(waiters);
+}
+
+/*
+ * Runs on waiter's context; whoever
+ * unlinks a waiter (this or finish_load)
+ * is the one which completes it
+ *
+ */
+static gboolean
+waiter_cancelled(GCancellable* cancellable, GTask* task)
+{
+  DsModelRegistry* self = g_task_get_source_object(task);
+  const gchar* key = g_task_get_task_data(task);
+  Waiter* waiter = NULL;
+  Entry* entry = NULL;
+  GSList* list = NULL;
+
+  g_mutex_lock(&(self->lock));
+  entry = g_hash_table_lookup(self->entries, key);
+
+  if G_LIKELY(entry != NULL)
+  for(list = entry->waiters;
+      list != NULL;
+      list = list->next)
+  if(((Waiter*) list->data)->task == task)
+  {
+    waiter = list->data;
+    entry->waiters = g_slist_delete_link(entry->waiters, list);
+    break;
+  }
+
+  g_mutex_unlock(&(self->lock));
+
+  if(waiter != NULL)
+  {
+    g_task_return_error_if_cancelled(task);
+    waiter_free(waiter);
+  }
+return G_SOURCE_REMOVE;
+}
+
+static void
+load_ready(GObject* source_object, GAsyncResult* res, LoadData* ldata)
+{
+  GError* tmp_err = NULL;
+  DsModel* model = NULL;
+
+  model =
+  ds_model_single_new_finish(res, &tmp_err);
+  finish_load(ldata->registry, ldata->key, model, tmp_err);
+
+  _g_object_unref0(model);
+  if G_UNLIKELY(tmp_err != NULL)
+    g_error_free(tmp_err);
+  g_object_unref(ldata->registry);
+  g_free(ldata->key);
+  g_slice_free(LoadData, ldata);
+}
+
+/*
+ * Object class
+ *
+ */
+
+static void
+ds_model_registry_class_finalize(GObject* pself)
+{
+  DsModelRegistry* self = DS_MODEL_REGISTRY(pself);
+  _g_hash_table_unref0(self->entries);
+  g_mutex_clear(&(self->lock));
+G_OBJECT_CLASS(ds_model_registry_parent_class)->finalize(pself);
+}
+
+static void
+ds_model_registry_class_init(DsModelRegistryClass* klass)
+{
+  GObjectClass* oclass = G_OBJECT_CLASS(klass);
+
+  oclass->finalize = ds_model_registry_class_finalize;
+}
+
+static void
+ds_model_registry_init(DsModelRegistry* self)
+{
+  g_mutex_init(&(self->lock));
+  self->prune_at = PRUNE_MIN;
+  self->entries =
+  g_hash_table_new_full
+  (g_str_hash,
+   g_str_equal,
+   g_free,
+   (GDestroyNotify)
+   entry_free);
+}
+
+/*
+ * Object methods
+ *
+ */
+
+/**
+ * ds_model_registry_new: (constructor)
+ *
+ * Creates a new, empty model registry.
+ *
+ * Returns: (transfer full): a new #DsModelRegistry.
+ */
+DsModelRegistry*
+ds_model_registry_new()
+{
+  return (DsModelRegistry*)
+  g_object_new(DS_TYPE_MODEL_REGISTRY, NULL);
+}
+
+/**
+ * ds_model_registry_get_default:
+ *
+ * Gets process-wide model registry.
+ *
+ * Returns: (transfer none): a #DsModelRegistry.
+ */
+DsModelRegistry*
+ds_model_registry_get_default()
+{
+  static DsModelRegistry* registry = NULL;
+  if(g_once_init_enter(&registry))
+  {
+    DsModelRegistry* registry_ =
+    ds_model_registry_new();
+    g_once_init_leave(&registry, registry_);
+  }
+return registry;
+}
+
+/**
+ * ds_model_registry_load:
+ * @registry: a #DsModelRegistry.
+ * @source: source directory where model and all it data resides.
+ * @name: main model filename (note that must be relative to @source).
+ * @shader: (nullable): shader model will be drawn with.
+ * @attributes: vertex attributes to import.
+ * @cancellable: (nullable): a %GCancellable
+ * @error: return location for a #GError
+ *
+ * Gets a #DsModel for @name, either one still alive
+ * or a freshly loaded one (see #ds_model_single_new_full()).
+ * If an asynchronous load for the same model is
+ * in flight, this function iterates the main context
+ * it was started from until it finishes. Must be
+ * called from GL thread.
+ *
+ * Returns: (transfer full): a #DsModel derived instance.
+ */
+DsModel*
+ds_model_registry_load(DsModelRegistry    *registry,
+                       GFile              *source,
+                       const gchar        *name,
+                       DsShader           *shader,
+                       DsModelAttributes   attributes,
+                       GCancellable       *cancellable,
+                       GError            **error)
+{
+  g_return_val_if_fail(DS_IS_MODEL_REGISTRY(registry), NULL);
+  g_return_val_if_fail(G_IS_FILE(source), NULL);
+  g_return_val_if_fail(name != NULL, NULL);
+  g_return_val_if_fail(shader == NULL || DS_IS_SHADER(shader), NULL);
+  g_return_val_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable), NULL);
+  g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+  DsModelRegistry* self = registry;
+  GMainContext* context = NULL;
+  GError* tmp_err = NULL;
+  DsModel* model = NULL;
+  Entry* entry = NULL;
+  gchar* key = NULL;
+
+  key = make_key(source, name, shader, attributes);
+
+  for(;;)
+  {
+    g_mutex_lock(&(self->lock));
+    model = lookup(self, key, &entry);
+    if(model != NULL || entry->loading == FALSE)
+      break;
+
+    /* wait for in-flight load */
+    context = g_main_context_ref(entry->context);
+    g_mutex_unlock(&(self->lock));
+    g_main_context_iteration(context, TRUE);
+    g_main_context_unref(context);
+
+    if G_UNLIKELY(g_cancellable_set_error_if_cancelled(cancellable, error))
+      goto _error_;
+  }
+
+  if G_LIKELY(model != NULL)
+  {
+    g_mutex_unlock(&(self->lock));
+    goto _error_;
+  }
+
+  entry->loading = TRUE;
+  entry->context = g_main_context_ref_thread_default();
+  g_mutex_unlock(&(self->lock));
+
+  model =
+  ds_model_single_new_full(source, name, shader, attributes, cancellable, &tmp_err);
+  finish_load(self, key, model, tmp_err);
+
+  if G_UNLIKELY(tmp_err != NULL)
+    g_propagate_error(error, tmp_err);
+
+_error_:
+  _g_free0(key);
+return model;
+}
+
+/**
+ * ds_model_registry_load_async:
+ * @registry: a #DsModelRegistry.
+ * @source: source directory where model and all it data resides.
+ * @name: main model filename (note that must be relative to @source).
+ * @shader: (nullable): shader model will be drawn with.
+ * @attributes: vertex attributes to import.
+ * @cancellable: (nullable): a %GCancellable
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the model is ready.
+ * @user_data: (closure): data to pass to @callback.
+ *
+ * Asynchronous version of #ds_model_registry_load().
+ * Requests for a model already being loaded just wait
+ * for it. Cancelling @cancellable completes this
+ * request right away (with %G_IO_ERROR_CANCELLED),
+ * but not the shared load. GL objects are created
+ * on GL thread, see #ds_model_single_new_async().
+ *
+ */
+void
+ds_model_registry_load_async(DsModelRegistry     *registry,
+                             GFile               *source,
+                             const gchar         *name,
+                             DsShader            *shader,
+                             DsModelAttributes    attributes,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data)
+{
+  g_return_if_fail(DS_IS_MODEL_REGISTRY(registry));
+  g_return_if_fail(G_IS_FILE(source));
+  g_return_if_fail(name != NULL);
+  g_return_if_fail(shader == NULL || DS_IS_SHADER(shader));
+  g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+  DsModelRegistry* self = registry;
+  LoadData* ldata = NULL;
+  DsModel* model = NULL;
+  Waiter* waiter = NULL;
+  Entry* entry = NULL;
+  GTask* task = NULL;
+  gchar* key = NULL;
+
+  task = g_task_new(self, cancellable, callback, user_data);
+  g_task_set_source_tag(task, ds_model_registry_load_async);
+  key = make_key(source, name, shader, attributes);
+
+  g_mutex_lock(&(self->lock));
+  model = lookup(self, key, &entry);
+
+  if(model != NULL)
+  {
+    g_mutex_unlock(&(self->lock));
+    g_task_return_pointer(task, model, g_object_unref);
+    g_object_unref(task);
+    g_free(key);
+    return;
+  }
+
+  waiter = g_slice_new0(Waiter);
+  waiter->task = task;
+
+  if(cancellable != NULL)
+  {
+    g_task_set_task_data(task, g_strdup(key), g_free);
+    waiter->cancel = g_cancellable_source_new(cancellable);
+
+    g_source_set_callback
+    (waiter->cancel,
+     (GSourceFunc)
+     waiter_cancelled,
+     g_object_ref(task),
+     g_object_unref);
+    g_source_attach(waiter->cancel, g_task_get_context(task));
+  }
+
+  entry->waiters = g_slist_append(entry->waiters, waiter);
+
+  if(entry->loading == TRUE)
+  {
+    g_mutex_unlock(&(self->lock));
+    g_free(key);
+    return;
+  }
+
+  entry->loading = TRUE;
+  entry->context = g_main_context_ref_thread_default();
+  g_mutex_unlock(&(self->lock));
+
+  ldata = g_slice_new(LoadData);
+  ldata->registry = g_object_ref(self);
+  ldata->key = key;
+
+  ds_model_single_new_full_async
+  (source,
+   name,
+   shader,
+   attributes,
+   NULL,
+   (GAsyncReadyCallback)
+   load_ready,
+   ldata);
+}
+
+/**
+ * ds_model_registry_load_finish:
+ * @registry: a #DsModelRegistry.
+ * @res: a #GAsyncResult.
+ * @error: return location for a #GError
+ *
+ * Finishes an operation started with
+ * #ds_model_registry_load_async().
+ *
+ * Returns: (transfer full): a #DsModel derived instance.
+ */
+DsModel*
+ds_model_registry_load_finish(DsModelRegistry  *registry,
+                              GAsyncResult     *res,
+                              GError          **error)
+{
+  g_return_val_if_fail(DS_IS_MODEL_REGISTRY(registry), NULL);
+  g_return_val_if_fail(g_task_is_valid(res, registry), NULL);
+  g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+return g_task_propagate_pointer(G_TASK(res), error);
+}
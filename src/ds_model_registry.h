@@ -0,0 +1,76 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __DS_MODEL_REGISTRY_INCLUDED__
+#define __DS_MODEL_REGISTRY_INCLUDED__ 1
+#include <ds_export.h>
+#include <ds_model.h>
+
+#define DS_TYPE_MODEL_REGISTRY            (ds_model_registry_get_type())
+#define DS_MODEL_REGISTRY(object)         (G_TYPE_CHECK_INSTANCE_CAST((object), DS_TYPE_MODEL_REGISTRY, DsModelRegistry))
+#define DS_MODEL_REGISTRY_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass), DS_TYPE_MODEL_REGISTRY, DsModelRegistryClass))
+#define DS_IS_MODEL_REGISTRY(object)      (G_TYPE_CHECK_INSTANCE_TYPE((object), DS_TYPE_MODEL_REGISTRY))
+#define DS_IS_MODEL_REGISTRY_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), DS_TYPE_MODEL_REGISTRY))
+#define DS_MODEL_REGISTRY_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), DS_TYPE_MODEL_REGISTRY, DsModelRegistryClass))
+
+typedef struct _DsModelRegistry       DsModelRegistry;
+typedef struct _DsModelRegistryClass  DsModelRegistryClass;
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+DEUSEXMAKINA2_API
+GType
+ds_model_registry_get_type();
+
+DEUSEXMAKINA2_API
+DsModelRegistry*
+ds_model_registry_new();
+DEUSEXMAKINA2_API
+DsModelRegistry*
+ds_model_registry_get_default();
+DEUSEXMAKINA2_API
+DsModel*
+ds_model_registry_load(DsModelRegistry    *registry,
+                       GFile              *source,
+                       const gchar        *name,
+                       DsShader           *shader,
+                       DsModelAttributes   attributes,
+                       GCancellable       *cancellable,
+                       GError            **error);
+DEUSEXMAKINA2_API
+void
+ds_model_registry_load_async(DsModelRegistry     *registry,
+                             GFile               *source,
+                             const gchar         *name,
+                             DsShader            *shader,
+                             DsModelAttributes    attributes,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data);
+DEUSEXMAKINA2_API
+DsModel*
+ds_model_registry_load_finish(DsModelRegistry  *registry,
+                              GAsyncResult     *res,
+                              GError          **error);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __DS_MODEL_REGISTRY_INCLUDED__
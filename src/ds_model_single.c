@@ -83,11 +83,19 @@ G_DEFINE_TYPE_WITH_CODE
  DS_TYPE_MODEL,
  );
 
+/*
+ * Same model could be planned
+ * from several threads at once
+ *
+ */
+G_LOCK_DEFINE_STATIC(groups);
+
 static gboolean
 foreach_tio(DsModel* pself, DsModelTexture* tex, GList* meshes)
 {
   struct _Group group = {0};
   DsModelMesh* mesh = NULL;
+  guint index_size;
 
   group.tex = tex;
   group.counts = g_array_new(0, 1, sizeof(TYPEOF_COUNT));
@@ -95,6 +103,11 @@ foreach_tio(DsModel* pself, DsModelTexture* tex, GList* meshes)
   group.bases = g_array_new(0, 1, sizeof(TYPEOF_BASES));
   g_array_append_val(&(((DsModelSingle*) pself)->groups->array_), group);
 
+  index_size =
+  (_ds_model_get_index_type(pself) == GL_UNSIGNED_SHORT)
+  ? sizeof(GLushort)
+  : sizeof(GLuint);
+
   TYPEOF_COUNT count_;
   TYPEOF_INDICES index_;
   TYPEOF_BASES base_;
@@ -105,7 +118,7 @@ foreach_tio(DsModel* pself, DsModelTexture* tex, GList* meshes)
   {
     mesh = meshes->data;
     count_ = mesh->indices;
-    index_ = GUINT_TO_POINTER(mesh->index_offset);
+    index_ = GSIZE_TO_POINTER((gsize) mesh->index_offset * index_size);
     base_ = mesh->base_vertex;
 
     g_array_append_vals(group.counts, &count_, 1);
@@ -130,7 +143,7 @@ generate_groups(DsModelSingle* self)
 }
 
 static gboolean
-ds_model_single_class_compile(DsModel* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
+ds_model_single_class_plan(DsModel* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
 {
   DsModelSingle* self = DS_MODEL_SINGLE(pself);
   DsModel* model = DS_MODEL(self);
@@ -140,10 +153,12 @@ ds_model_single_class_compile(DsModel* pself, DsRenderState* state, GCancellable
   struct _Group* groups;
   guint i;
 
+  G_LOCK(groups);
   if G_UNLIKELY(self->groups == NULL)
   {
     generate_groups(self);
   }
+  G_UNLOCK(groups);
 
 /*
  * Draw meshes
@@ -166,7 +181,7 @@ ds_model_single_class_compile(DsModel* pself, DsRenderState* state, GCancellable
      6,
      (guintptr) GL_TRIANGLES,
      (guintptr) groups[i].counts->data,
-     (guintptr) GL_UNSIGNED_INT,
+     (guintptr) _ds_model_get_index_type(model),
      (guintptr) groups[i].indices->data,
      (guintptr) groups[i].counts->len,
      (guintptr) groups[i].bases->data);
@@ -190,7 +205,7 @@ ds_model_single_class_init(DsModelSingleClass* klass)
   DsModelClass* mclass = DS_MODEL_CLASS(klass);
   GObjectClass* oclass = G_OBJECT_CLASS(klass);
 
-  mclass->compile = ds_model_single_class_compile;
+  mclass->plan = ds_model_single_class_plan;
 
   oclass->finalize = ds_model_single_class_finalize;
 }
@@ -236,3 +251,113 @@ ds_model_single_new(GFile* source, const gchar* name, GCancellable* cancellable,
    "name", name,
    NULL);
 }
+
+/**
+ * ds_model_single_new_async:
+ * @source: source directory where model and all it data resides.
+ * @name: main model filename (note that must be relative to @source).
+ * @cancellable: (nullable): a %GCancellable
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the model is loaded.
+ * @user_data: (closure): data to pass to @callback.
+ *
+ * Asynchronously creates a new instance of #DsModelSingle
+ * object. Model file is imported (and its textures read)
+ * on a worker thread; GL objects are then created on GL
+ * thread (render thread, if #DsRenderer runs on its own)
+ * before @callback is invoked.
+ *
+ */
+void
+ds_model_single_new_async(GFile* source, const gchar* name, GCancellable* cancellable, GAsyncReadyCallback callback, gpointer user_data)
+{
+  g_async_initable_new_async
+  (DS_TYPE_MODEL_SINGLE,
+   G_PRIORITY_DEFAULT,
+   cancellable,
+   callback,
+   user_data,
+   "source", source,
+   "name", name,
+   NULL);
+}
+
+/**
+ * ds_model_single_new_full: (constructor)
+ * @source: source directory where model and all it data resides.
+ * @name: main model filename (note that must be relative to @source).
+ * @shader: (nullable): shader model will be drawn with.
+ * @attributes: vertex attributes to import.
+ * @cancellable: (nullable): a %GCancellable
+ * @error: return location for a #GError
+ *
+ * Create a new instance of #DsModelSingle object,
+ * importing and storing only vertex attributes both
+ * in @attributes and active on @shader (if any).
+ *
+ * Returns: (transfer full): a #DsModel derived instance.
+ */
+DsModel*
+ds_model_single_new_full(GFile* source, const gchar* name, DsShader* shader, DsModelAttributes attributes, GCancellable* cancellable, GError** error)
+{
+  return (DsModel*)
+  g_initable_new
+  (DS_TYPE_MODEL_SINGLE,
+   cancellable,
+   error,
+   "source", source,
+   "name", name,
+   "shader", shader,
+   "attributes", attributes,
+   NULL);
+}
+
+/**
+ * ds_model_single_new_full_async:
+ * @source: source directory where model and all it data resides.
+ * @name: main model filename (note that must be relative to @source).
+ * @shader: (nullable): shader model will be drawn with.
+ * @attributes: vertex attributes to import.
+ * @cancellable: (nullable): a %GCancellable
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the model is loaded.
+ * @user_data: (closure): data to pass to @callback.
+ *
+ * Asynchronous version of #ds_model_single_new_full(),
+ * see #ds_model_single_new_async().
+ *
+ */
+void
+ds_model_single_new_full_async(GFile* source, const gchar* name, DsShader* shader, DsModelAttributes attributes, GCancellable* cancellable, GAsyncReadyCallback callback, gpointer user_data)
+{
+  g_async_initable_new_async
+  (DS_TYPE_MODEL_SINGLE,
+   G_PRIORITY_DEFAULT,
+   cancellable,
+   callback,
+   user_data,
+   "source", source,
+   "name", name,
+   "shader", shader,
+   "attributes", attributes,
+   NULL);
+}
+
+/**
+ * ds_model_single_new_finish: (constructor)
+ * @res: a #GAsyncResult.
+ * @error: return location for a #GError
+ *
+ * Finishes an operation started with #ds_model_single_new_async().
+ *
+ * Returns: (transfer full): a #DsModel derived instance.
+ */
+DsModel*
+ds_model_single_new_finish(GAsyncResult* res, GError** error)
+{
+  GObject* source_object = NULL;
+  GObject* object = NULL;
+
+  source_object = g_async_result_get_source_object(res);
+  object = g_async_initable_new_finish(G_ASYNC_INITABLE(source_object), res, error);
+  g_object_unref(source_object);
+return (DsModel*) object;
+}
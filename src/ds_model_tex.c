@@ -84,30 +84,35 @@ ds_model_texture_ref(DsModelTexture* tex)
 return tex;
 }
 
+static void
+texture_free(DsModelTexture* tex)
+{
+  __gl_try_catch(
+    glDeleteTextures(n_tios, tex->tios);
+  ,
+    g_warning
+    ("(%s: %i): %s: %i: %s\r\n",
+     G_STRFUNC,
+     __LINE__,
+     g_quark_to_string(glerror->domain),
+     glerror->code,
+     glerror->message);
+    g_error_free(glerror);
+  );
+
+  g_slice_free(DsModelTexture, tex);
+}
+
 void
 ds_model_texture_unref(DsModelTexture* tex)
 {
   g_return_if_fail(tex != NULL);
 
+  /* last reference may drop off GL thread */
   gboolean zero =
   g_ref_count_dec(&(tex->refs));
   if(zero == TRUE)
-  {
-    __gl_try_catch(
-      glDeleteTextures(n_tios, tex->tios);
-    ,
-      g_warning
-      ("(%s: %i): %s: %i: %s\r\n",
-       G_STRFUNC,
-       __LINE__,
-       g_quark_to_string(glerror->domain),
-       glerror->code,
-       glerror->message);
-      g_error_free(glerror);
-    );
-
-    g_slice_free(DsModelTexture, tex);
-  }
+    _ds_gl_invoke((GDestroyNotify) texture_free, tex);
 }
 
 G_GNUC_INTERNAL
@@ -33,31 +33,57 @@ GWeakRef __default__ = {0};
  *
  */
 
-static const
-goffset format_offsets[] =
+typedef struct _Attrib Attrib;
+
+struct _Attrib
 {
-  G_STRUCT_OFFSET(DsPencilVertex, position),
-  G_STRUCT_OFFSET(DsPencilVertex, normal),
-  G_STRUCT_OFFSET(DsPencilVertex, uvw),
-  G_STRUCT_OFFSET(DsPencilVertex, tangent),
-  G_STRUCT_OFFSET(DsPencilVertex, bitangent),
+  guint size;
+  GLenum type;
+  GLboolean normalized;
+  goffset offset;
 };
 
+#define n_attribs (5)
+
 static const
-guint format_floats[] =
+Attrib format_attribs[DS_PENCIL_FORMAT_N][n_attribs] =
 {
-  3,
-  3,
-  3,
-  3,
-  3,
+  [DS_PENCIL_FORMAT_FULL] =
+  {
+    {3, GL_FLOAT, GL_FALSE, G_STRUCT_OFFSET(DsPencilVertex, position)},
+    {3, GL_FLOAT, GL_FALSE, G_STRUCT_OFFSET(DsPencilVertex, normal)},
+    {3, GL_FLOAT, GL_FALSE, G_STRUCT_OFFSET(DsPencilVertex, uvw)},
+    {3, GL_FLOAT, GL_FALSE, G_STRUCT_OFFSET(DsPencilVertex, tangent)},
+    {3, GL_FLOAT, GL_FALSE, G_STRUCT_OFFSET(DsPencilVertex, bitangent)},
+  },
+
+  /* bitangent is rebuilt on shader */
+  [DS_PENCIL_FORMAT_PACKED] =
+  {
+    {4, GL_SHORT, GL_TRUE, G_STRUCT_OFFSET(DsPencilPackedVertex, position)},
+    {2, GL_SHORT, GL_TRUE, G_STRUCT_OFFSET(DsPencilPackedVertex, normal)},
+    {2, GL_HALF_FLOAT, GL_FALSE, G_STRUCT_OFFSET(DsPencilPackedVertex, uv)},
+    {2, GL_SHORT, GL_TRUE, G_STRUCT_OFFSET(DsPencilPackedVertex, tangent)},
+    {0, 0, GL_FALSE, 0},
+  },
+
+  [DS_PENCIL_FORMAT_BASIC] =
+  {
+    {4, GL_SHORT, GL_TRUE, G_STRUCT_OFFSET(DsPencilBasicVertex, position)},
+    {0, 0, GL_FALSE, 0},
+    {2, GL_HALF_FLOAT, GL_FALSE, G_STRUCT_OFFSET(DsPencilBasicVertex, uv)},
+    {0, 0, GL_FALSE, 0},
+    {0, 0, GL_FALSE, 0},
+  },
 };
 
-#define n_attribs (5)
-
-/* sanity checks */
-G_STATIC_ASSERT(G_N_ELEMENTS(format_offsets) == n_attribs);
-G_STATIC_ASSERT(G_N_ELEMENTS(format_floats) == n_attribs);
+static const
+gsize format_strides[DS_PENCIL_FORMAT_N] =
+{
+  [DS_PENCIL_FORMAT_FULL] = sizeof(DsPencilVertex),
+  [DS_PENCIL_FORMAT_PACKED] = sizeof(DsPencilPackedVertex),
+  [DS_PENCIL_FORMAT_BASIC] = sizeof(DsPencilBasicVertex),
+};
 
 /*
  * Definition
@@ -69,7 +95,11 @@ struct _DsPencil
   GObject parent_instance;
 
   /*<private>*/
-  GLuint vao;
+  union
+  {
+    GLuint vaos[DS_PENCIL_FORMAT_N];
+    GLuint vao;
+  };
 };
 
 struct _DsPencilClass
@@ -91,7 +121,8 @@ ds_pencil_g_initable_iface_init_sync(GInitable* pself, GCancellable* cancellable
   DsPencil* self = DS_PENCIL(pself);
   gboolean success = TRUE;
   GError* tmp_err = NULL;
-  guint i;
+  const Attrib* attrib;
+  guint i, j;
 
   DsPencil* default_ =
   ds_pencil_get_default();
@@ -107,31 +138,52 @@ ds_pencil_g_initable_iface_init_sync(GInitable* pself, GCancellable* cancellable
   }
 
   __gl_try_catch(
-    glGenVertexArrays(1, &(self->vao));
-    glBindVertexArray(self->vao);
-    g_assert(self->vao > 0);
+    glGenVertexArrays(DS_PENCIL_FORMAT_N, self->vaos);
   ,
     g_propagate_error(error, glerror);
     goto_error();
   );
 
-
-  for(i = 0;
-      i < n_attribs;
-      i++)
+  for(j = 0;
+      j < DS_PENCIL_FORMAT_N;
+      j++)
   {
     __gl_try_catch(
-      glEnableVertexAttribArray(i);
-#if GL_VERSION_4_3 == 1
-      glVertexAttribFormat(i, format_floats[i], GL_FLOAT, GL_FALSE, format_offsets[i]);
-      glVertexAttribBinding(i, 0);
-#endif // GL_VERSION_4_3
+      glBindVertexArray(self->vaos[j]);
+      g_assert(self->vaos[j] > 0);
     ,
       g_propagate_error(error, glerror);
       goto_error();
     );
+
+    for(i = 0;
+        i < n_attribs;
+        i++)
+    {
+      attrib = &(format_attribs[j][i]);
+      if(attrib->size == 0)
+        continue;
+
+      __gl_try_catch(
+        glEnableVertexAttribArray(i);
+#if GL_VERSION_4_3 == 1
+        glVertexAttribFormat(i, attrib->size, attrib->type, attrib->normalized, attrib->offset);
+        glVertexAttribBinding(i, 0);
+#endif // GL_VERSION_4_3
+      ,
+        g_propagate_error(error, glerror);
+        goto_error();
+      );
+    }
   }
 
+  __gl_try_catch(
+    glBindVertexArray(self->vao);
+  ,
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
+
   g_weak_ref_set(&__default__, self);
 _error_:
 return success;
@@ -150,7 +202,7 @@ ds_pencil_class_finalize(GObject* pself)
   if G_LIKELY(self->vao != 0)
   {
     __gl_try_catch(
-      glDeleteVertexArrays(1, &(self->vao));
+      glDeleteVertexArrays(DS_PENCIL_FORMAT_N, self->vaos);
     ,
       g_warning
       ("(%s: %i): %s: %i: %s\r\n",
@@ -237,24 +289,55 @@ glBindBuffer_s(GLenum target, GLuint* p_vbo)
   glBindBuffer(target, *p_vbo);
 }
 
+/**
+ * ds_pencil_format_get_stride:
+ * @format: vertex layout.
+ *
+ * Gets size of a single vertex on @format.
+ *
+ * Returns: vertex size, in bytes.
+ */
+gsize
+ds_pencil_format_get_stride(DsPencilFormat format)
+{
+  g_return_val_if_fail(format < DS_PENCIL_FORMAT_N, 0);
+return format_strides[format];
+}
+
 /**
  * ds_pencil_bind: (method)
  * @pencil: a #DsPencil instance (NULL to use process default pencil).
  * @error: return location for a #GError.
  *
- * Immediately bind internal VAO.
+ * Immediately bind internal VAO for %DS_PENCIL_FORMAT_FULL.
  *
  */
 gboolean
 ds_pencil_bind(DsPencil* pencil, GError** error)
+{
+  return ds_pencil_bind_format(pencil, DS_PENCIL_FORMAT_FULL, error);
+}
+
+/**
+ * ds_pencil_bind_format: (method)
+ * @pencil: a #DsPencil instance (NULL to use process default pencil).
+ * @format: vertex layout.
+ * @error: return location for a #GError.
+ *
+ * Immediately bind internal VAO for @format.
+ *
+ */
+gboolean
+ds_pencil_bind_format(DsPencil* pencil, DsPencilFormat format, GError** error)
 {
   g_return_val_if_fail(DS_IS_PENCIL(pencil), FALSE);
+  g_return_val_if_fail(format < DS_PENCIL_FORMAT_N, FALSE);
   DsPencil* self = pencil;
   gboolean success = TRUE;
   GError* tmp_err = NULL;
 
   __gl_try_catch(
-    glBindVertexArray(self->vao);
+    glBindVertexArray(self->vaos[format]);
   ,
     g_propagate_error(error, glerror);
     goto_error();
@@ -270,13 +353,32 @@ return success;
  * @state: renderer state over which compile VAO switch.
  * @p_vbo: a pointer to vertex buffer object name.
  *
- * Compiles a VAO switch on @state (if necessary).
+ * Compiles a VAO switch on @state (if necessary),
+ * for %DS_PENCIL_FORMAT_FULL.
  *
  */
 void
 ds_pencil_switch(DsPencil* pencil, DsRenderState* state, GLuint* p_vbo)
+{
+  ds_pencil_switch_format(pencil, DS_PENCIL_FORMAT_FULL, state, p_vbo);
+}
+
+/**
+ * ds_pencil_switch_format: (method)
+ * @pencil: a #DsPencil instance (NULL to use process default pencil).
+ * @format: vertex layout of @p_vbo contents.
+ * @state: renderer state over which compile VAO switch.
+ * @p_vbo: a pointer to vertex buffer object name.
+ *
+ * Compiles a VAO switch on @state, along with
+ * @p_vbo binding (each one only if necessary).
+ *
+ */
+void
+ds_pencil_switch_format(DsPencil* pencil, DsPencilFormat format, DsRenderState* state, GLuint* p_vbo)
 {
   g_return_if_fail(DS_IS_PENCIL(pencil));
+  g_return_if_fail(format < DS_PENCIL_FORMAT_N);
   g_return_if_fail(state != NULL);
   g_return_if_fail(p_vbo != NULL && *p_vbo > 0);
   DsPencil* self = pencil;
@@ -286,12 +388,16 @@ ds_pencil_switch(DsPencil* pencil, DsRenderState* state, GLuint* p_vbo)
  *
  */
 
-  ds_render_state_switch_vertex_array(state, self->vao);
+  ds_render_state_switch_vertex_array(state, self->vaos[format]);
 
 /*
  * Switch vbo
  *
  */
+
+  if(!ds_render_state_switch_buffer(state, GL_ARRAY_BUFFER, p_vbo))
+    return;
+
 #if GL_VERSION_4_3 == 1
   ds_render_state_pcall
   (state,
@@ -300,7 +406,7 @@ ds_pencil_switch(DsPencil* pencil, DsRenderState* state, GLuint* p_vbo)
    (guintptr) 0,
    (guintptr) p_vbo,
    (guintptr) 0,
-   (guintptr) sizeof(DsPencilVertex));
+   (guintptr) format_strides[format]);
 #else
   ds_render_state_pcall
   (state,
@@ -309,19 +415,27 @@ ds_pencil_switch(DsPencil* pencil, DsRenderState* state, GLuint* p_vbo)
    (guintptr) GL_ARRAY_BUFFER,
    (guintptr) p_vbo);
 
+  const Attrib* attrib;
   guint i;
+
   for(i = 0;
       i < n_attribs;
       i++)
-  ds_render_state_pcall
-  (state,
-   G_CALLBACK(glVertexAttribPointer),
-   6,
-   (guintptr) i,
-   (guintptr) format_floats[i],
-   (guintptr) GL_FLOAT,
-   (guintptr) GL_FALSE,
-   (guintptr) sizeof(DsModelVertex),
-   (guintptr) format_offsets[i]);
+  {
+    attrib = &(format_attribs[format][i]);
+    if(attrib->size == 0)
+      continue;
+
+    ds_render_state_pcall
+    (state,
+     G_CALLBACK(glVertexAttribPointer),
+     6,
+     (guintptr) i,
+     (guintptr) attrib->size,
+     (guintptr) attrib->type,
+     (guintptr) attrib->normalized,
+     (guintptr) format_strides[format],
+     (guintptr) attrib->offset);
+  }
 #endif // GL_VERSION_4_3
 }
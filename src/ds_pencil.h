@@ -45,6 +45,24 @@ typedef enum
   DS_PENCIL_ERROR_CREATED,
 } DsPencilError;
 
+/**
+ * DsPencilFormat:
+ * @DS_PENCIL_FORMAT_FULL: #DsPencilVertex, five float vectors (60 bytes).
+ * @DS_PENCIL_FORMAT_PACKED: #DsPencilPackedVertex, quantized (20 bytes).
+ * @DS_PENCIL_FORMAT_BASIC: #DsPencilBasicVertex, quantized position and
+ * texture coordinates only (12 bytes).
+ *
+ * Vertex layouts understood by #DsPencil.
+ */
+typedef enum
+{
+  DS_PENCIL_FORMAT_FULL,
+  DS_PENCIL_FORMAT_PACKED,
+  DS_PENCIL_FORMAT_BASIC,
+} DsPencilFormat;
+
+#define DS_PENCIL_FORMAT_N (DS_PENCIL_FORMAT_BASIC + 1)
+
 #define DS_TYPE_PENCIL            (ds_pencil_get_type())
 #define DS_PENCIL(object)         (G_TYPE_CHECK_INSTANCE_CAST((object), DS_TYPE_PENCIL, DsPencil))
 #define DS_PENCIL_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass), DS_TYPE_PENCIL, DsPencilClass))
@@ -55,6 +73,8 @@ typedef enum
 typedef struct _DsPencil        DsPencil;
 typedef struct _DsPencilClass   DsPencilClass;
 typedef struct _DsPencilVertex  DsPencilVertex;
+typedef struct _DsPencilPackedVertex DsPencilPackedVertex;
+typedef struct _DsPencilBasicVertex DsPencilBasicVertex;
 
 #if __cplusplus
 extern "C" {
@@ -69,11 +89,53 @@ struct _DsPencilVertex
   vec3 bitangent;
 };
 
+/**
+ * DsPencilPackedVertex:
+ * @position: position as signed normalized shorts, relative
+ * to model bounding box (see #DsModel); fourth component holds
+ * bitangent sign.
+ * @normal: octahedral-encoded normal, as signed normalized shorts.
+ * @tangent: octahedral-encoded tangent, as signed normalized shorts.
+ * @uv: texture coordinates, as half floats.
+ *
+ * Quantized counterpart of #DsPencilVertex. Bitangent
+ * is not stored, but rebuilt on shader as cross product
+ * of normal and tangent times sign stored on @position.
+ */
+struct _DsPencilPackedVertex
+{
+  gint16 position[4];
+  gint16 normal[2];
+  gint16 tangent[2];
+  guint16 uv[2];
+};
+
+G_STATIC_ASSERT(sizeof(DsPencilPackedVertex) == 20);
+
+/**
+ * DsPencilBasicVertex:
+ * @position: same as #DsPencilPackedVertex position.
+ * @uv: same as #DsPencilPackedVertex uv.
+ *
+ * A #DsPencilPackedVertex stripped of its tangent
+ * frame, for shaders which do not consume it.
+ */
+struct _DsPencilBasicVertex
+{
+  gint16 position[4];
+  guint16 uv[2];
+};
+
+G_STATIC_ASSERT(sizeof(DsPencilBasicVertex) == 12);
+
 DEUSEXMAKINA2_API
 GQuark
 ds_pencil_error_quark();
 DEUSEXMAKINA2_API
 GType
+ds_pencil_format_get_type();
+DEUSEXMAKINA2_API
+GType
 ds_pencil_get_type();
 
 DEUSEXMAKINA2_API
@@ -88,6 +150,15 @@ ds_pencil_bind(DsPencil* pencil, GError** error);
 DEUSEXMAKINA2_API
 void
 ds_pencil_switch(DsPencil* pencil, DsRenderState* state, GLuint* p_vbo);
+DEUSEXMAKINA2_API
+gsize
+ds_pencil_format_get_stride(DsPencilFormat format);
+DEUSEXMAKINA2_API
+gboolean
+ds_pencil_bind_format(DsPencil* pencil, DsPencilFormat format, GError** error);
+DEUSEXMAKINA2_API
+void
+ds_pencil_switch_format(DsPencil* pencil, DsPencilFormat format, DsRenderState* state, GLuint* p_vbo);
 
 #if __cplusplus
 }
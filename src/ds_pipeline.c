@@ -39,6 +39,12 @@
  * using DynASM. Later, the pipeline could be executed every frame without
  * the overhead of generic code tricks.
  *
+ * Updating is made in two phases: a GL-free planning phase, which
+ * records calls for every shader entry (and could run on worker
+ * threads, see #ds_pipeline_update_async()), and a short finalize
+ * phase on GL thread which runs one-shot setup calls and links
+ * recorded calls into machine code.
+ *
  */
 
 G_DEFINE_QUARK(ds-pipeline-error-quark,
@@ -54,10 +60,16 @@ void ds_pipeline_ds_mvp_holder_iface_init(DsMvpHolderIface* iface);
 typedef union  _ShaderList  ShaderList;
 typedef struct _ShaderEntry ShaderEntry;
 typedef union  _ObjectList  ObjectList;
+typedef struct _PlanJob     PlanJob;
+typedef struct _UpdateData  UpdateData;
+typedef struct _Command     Command;
 
 G_GNUC_INTERNAL
 GLuint
 _ds_shader_get_pid(DsShader *shader);
+G_GNUC_INTERNAL
+GHashTable*
+_ds_shader_get_uniforms(DsShader *shader);
 
 /*
  * Object definition
@@ -71,8 +83,18 @@ struct _DsPipeline
   /*<private>*/
   gboolean modified;
   gboolean notified;
+  guint serial;
+  guint built;
+  guint pending;
+  JitMvps mvps;
   JitState ctx;
   JitMain main;
+  GPtrArray* installed;
+
+  /*<private>*/
+  Command* queue;
+  GCallback overlay_func;
+  gpointer overlay_data;
 
   /*<private>*/
   union _ShaderList
@@ -108,6 +130,38 @@ struct _ShaderEntry
   } *objects;
 };
 
+typedef enum
+{
+  COMMAND_APPEND,
+  COMMAND_REMOVE,
+  COMMAND_PRIORITY,
+} CommandType;
+
+struct _Command
+{
+  Command* next;
+  CommandType type;
+  gchar* shader_name;
+  int priority;
+  DsRenderable* object;
+};
+
+struct _PlanJob
+{
+  DsShader* shader;
+  int priority;
+  GList* objects;
+  JitPlan plan;
+};
+
+struct _UpdateData
+{
+  GPtrArray* jobs;
+  guint serial;
+  guint n_pending;
+  GError* error;
+};
+
 G_DEFINE_TYPE_WITH_CODE
 (DsPipeline,
  ds_pipeline,
@@ -146,27 +200,41 @@ static void
 ds_pipeline_ds_mvp_holder_iface_init(DsMvpHolderIface* iface)
 {
   iface->p_model =
-    G_STRUCT_OFFSET(DsPipeline, ctx)
-  + G_STRUCT_OFFSET(JitState, mvps)
+    G_STRUCT_OFFSET(DsPipeline, mvps)
   + G_STRUCT_OFFSET(JitMvps, model);
 
   iface->p_view =
-    G_STRUCT_OFFSET(DsPipeline, ctx)
-  + G_STRUCT_OFFSET(JitState, mvps)
+    G_STRUCT_OFFSET(DsPipeline, mvps)
   + G_STRUCT_OFFSET(JitMvps, view);
 
   iface->p_projection =
-    G_STRUCT_OFFSET(DsPipeline, ctx)
-  + G_STRUCT_OFFSET(JitState, mvps)
+    G_STRUCT_OFFSET(DsPipeline, mvps)
   + G_STRUCT_OFFSET(JitMvps, projection);
 
   iface->notify_view = ds_pipeline_ds_mvp_holder_iface_notify;
   iface->notify_projection = ds_pipeline_ds_mvp_holder_iface_notify;
 }
 
+static void
+command_free(Command* command)
+{
+  g_clear_object(&(command->object));
+  g_clear_pointer(&(command->shader_name), g_free);
+  g_slice_free(Command, command);
+}
+
 static
 void ds_pipeline_class_finalize(GObject* pself) {
   DsPipeline* self = DS_PIPELINE(pself);
+  Command* next = NULL;
+
+  while(self->queue != NULL)
+  {
+    next = self->queue->next;
+    command_free(self->queue);
+    self->queue = next;
+  }
+
   g_list_free(&(self->shaders->list_));
   _ds_jit_compile_free(&(self->ctx));
 G_OBJECT_CLASS(ds_pipeline_parent_class)->finalize(pself);
@@ -203,6 +271,10 @@ static
 void ds_pipeline_class_dispose(GObject* pself) {
   DsPipeline* self = DS_PIPELINE(pself);
 
+  /* code can not run without its objects */
+  self->main = NULL;
+  g_clear_pointer(&(self->installed), g_ptr_array_unref);
+
   ShaderList* list;
   for(list = self->shaders;
       list != NULL;
@@ -342,6 +414,7 @@ ds_pipeline_register_shader(DsPipeline   *pipeline,
    insert_sorted_shader);
 
   pipeline->modified = TRUE;
+  pipeline->serial++;
 }
 
 /**
@@ -379,6 +452,7 @@ ds_pipeline_unregister_shader(DsPipeline   *pipeline,
   }
 
   pipeline->modified = TRUE;
+  pipeline->serial++;
 }
 
 static gint
@@ -407,7 +481,8 @@ return (pr1 > pr2) ? 1 : -1;
  * @object: a #DsRenderable object.
  *
  * Appends @object to @shader_name shader's object
- * list, sorted by @priority.
+ * list, sorted by @priority. Must be called from GL
+ * thread; elsewhere use #ds_pipeline_queue_append_object().
  *
  */
 void
@@ -442,6 +517,7 @@ ds_pipeline_append_object(DsPipeline   *pipeline,
    (GCompareFunc)
    insert_sorted_object);
   pipeline->modified = TRUE;
+  pipeline->serial++;
   entry->n_objects++;
 }
 
@@ -452,6 +528,8 @@ ds_pipeline_append_object(DsPipeline   *pipeline,
  * @object: a #DsRenderable object.
  *
  * Removes @object from @shader_name shader's object list.
+ * Must be called from GL thread; elsewhere use
+ * #ds_pipeline_queue_remove_object().
  *
  */
 void
@@ -472,22 +550,226 @@ ds_pipeline_remove_object(DsPipeline   *pipeline,
     return;
   }
 
+  GList* link =
+  g_list_find(&(entry->objects->list_), object);
+  if G_UNLIKELY(link == NULL)
+  {
+    g_warning("Attempt to remove an object not appended to shader\r\n");
+    return;
+  }
+
   entry->objects =
   (ObjectList*)
-  g_list_remove
+  g_list_delete_link
   (&(entry->objects->list_),
-   g_object_ref(object));
+   link);
+  g_object_unref(object);
   pipeline->modified = TRUE;
+  pipeline->serial++;
   entry->n_objects--;
 }
 
 static void
-mvps_query_start(DsPipeline* self, JitState* ctx, GLuint uloc_jvp, GLuint uloc_mvp)
+set_object_priority(DsPipeline    *pipeline,
+                    const gchar   *shader_name,
+                    int            priority,
+                    DsRenderable  *object)
+{
+  ShaderEntry* entry = NULL;
+  GList* link = NULL;
+
+  entry =
+  shader_list_has(pipeline->shaders, shader_name);
+  if G_UNLIKELY(entry == NULL)
+  {
+    g_warning("Attempt to reorder an object on an inexistent shader\r\n");
+    return;
+  }
+
+  link =
+  g_list_find(&(entry->objects->list_), object);
+  if G_UNLIKELY(link == NULL)
+  {
+    g_warning("Attempt to reorder an object not appended to shader\r\n");
+    return;
+  }
+
+  /* reference is moved, not dropped */
+  entry->objects =
+  (ObjectList*)
+  g_list_delete_link
+  (&(entry->objects->list_),
+   link);
+
+  g_object_set_qdata
+  (G_OBJECT(object),
+   ds_pipeline_priority_quark(),
+   GINT_TO_POINTER(priority));
+
+  entry->objects =
+  (ObjectList*)
+  g_list_insert_sorted
+  (&(entry->objects->list_),
+   object,
+   (GCompareFunc)
+   insert_sorted_object);
+  pipeline->modified = TRUE;
+  pipeline->serial++;
+}
+
+/*
+ * Command queue
+ *
+ * Commands are pushed into a lock-free
+ * singly-linked stack by any thread, then
+ * owner thread takes the whole chain at once
+ * and replays it in submission order.
+ *
+ */
+
+static void
+queue_push(DsPipeline    *pipeline,
+           CommandType    type,
+           const gchar   *shader_name,
+           int            priority,
+           DsRenderable  *object)
+{
+  Command* command = g_slice_new(Command);
+  command->type = type;
+  command->shader_name = g_strdup(shader_name);
+  command->priority = priority;
+  command->object = g_object_ref(object);
+
+  do
+    command->next = g_atomic_pointer_get(&(pipeline->queue));
+  while(!g_atomic_pointer_compare_and_exchange(&(pipeline->queue), command->next, command));
+}
+
+static void
+queue_drain(DsPipeline* pipeline)
+{
+  Command* chain = NULL;
+  Command* command = NULL;
+  Command* next = NULL;
+
+  do
+    chain = g_atomic_pointer_get(&(pipeline->queue));
+  while(!g_atomic_pointer_compare_and_exchange(&(pipeline->queue), chain, NULL));
+
+  /*
+   * Reverse chain, since
+   * it is LIFO-ordered
+   *
+   */
+
+  for(command = NULL;
+      chain != NULL;
+      chain = next)
+  {
+    next = chain->next;
+    chain->next = command;
+    command = chain;
+  }
+
+  for(;
+      command != NULL;
+      command = next)
+  {
+    next = command->next;
+    switch(command->type)
+    {
+    case COMMAND_APPEND:
+      ds_pipeline_append_object(pipeline, command->shader_name, command->priority, command->object);
+      break;
+    case COMMAND_REMOVE:
+      ds_pipeline_remove_object(pipeline, command->shader_name, command->object);
+      break;
+    case COMMAND_PRIORITY:
+      set_object_priority(pipeline, command->shader_name, command->priority, command->object);
+      break;
+    }
+
+    command_free(command);
+  }
+}
+
+/**
+ * ds_pipeline_queue_append_object:
+ * @pipeline: a #DsPipeline object.
+ * @shader_name: shader object which append object to.
+ * @priority: sort priority of @object.
+ * @object: a #DsRenderable object.
+ *
+ * Thread-safe version of #ds_pipeline_append_object().
+ * Request is queued and applied on next pipeline update.
+ *
+ */
+void
+ds_pipeline_queue_append_object(DsPipeline   *pipeline,
+                                const gchar  *shader_name,
+                                int           priority,
+                                DsRenderable *object)
+{
+  g_return_if_fail(DS_IS_PIPELINE(pipeline));
+  g_return_if_fail(shader_name != NULL);
+  g_return_if_fail(DS_IS_RENDERABLE(object));
+  queue_push(pipeline, COMMAND_APPEND, shader_name, priority, object);
+}
+
+/**
+ * ds_pipeline_queue_remove_object:
+ * @pipeline: a #DsPipeline object.
+ * @shader_name: shader object which remove object from.
+ * @object: a #DsRenderable object.
+ *
+ * Thread-safe version of #ds_pipeline_remove_object().
+ * Request is queued and applied on next pipeline update.
+ * Pipeline keeps @object alive until code which does
+ * not draw it is installed.
+ *
+ */
+void
+ds_pipeline_queue_remove_object(DsPipeline   *pipeline,
+                                const gchar  *shader_name,
+                                DsRenderable *object)
+{
+  g_return_if_fail(DS_IS_PIPELINE(pipeline));
+  g_return_if_fail(shader_name != NULL);
+  g_return_if_fail(DS_IS_RENDERABLE(object));
+  queue_push(pipeline, COMMAND_REMOVE, shader_name, 0, object);
+}
+
+/**
+ * ds_pipeline_queue_set_object_priority:
+ * @pipeline: a #DsPipeline object.
+ * @shader_name: shader object which @object was appended to.
+ * @priority: new sort priority of @object.
+ * @object: a #DsRenderable object.
+ *
+ * Queues a sort priority change for @object.
+ * Request is applied on next pipeline update.
+ * This function is thread-safe.
+ *
+ */
+void
+ds_pipeline_queue_set_object_priority(DsPipeline   *pipeline,
+                                      const gchar  *shader_name,
+                                      int           priority,
+                                      DsRenderable *object)
+{
+  g_return_if_fail(DS_IS_PIPELINE(pipeline));
+  g_return_if_fail(shader_name != NULL);
+  g_return_if_fail(DS_IS_RENDERABLE(object));
+  queue_push(pipeline, COMMAND_PRIORITY, shader_name, priority, object);
+}
+
+static void
+mvps_query_start(DsPipeline* self, GLint uloc_jvp, GLint uloc_mvp)
 {
   if G_UNLIKELY
     (self->notified == TRUE)
   {
-    JitMvps* mvps = &(self->ctx.mvps);
+    JitMvps* mvps = &(self->mvps);
     _ds_jit_helper_update_mvps(mvps);
 
     if(uloc_jvp != (-1))
@@ -503,37 +785,51 @@ mvps_query_end(DsPipeline* self)
   self->notified = FALSE;
 }
 
-/**
- * ds_pipeline_update:
- * @pipeline: a #DsPipeline object.
- * @cancellable: (nullable): a %GCancellable
- * @error: return location for a #GError
+static void
+overlay_begin(DsPipeline* self)
+{
+  if(self->overlay_func != NULL)
+    ((void (*) (gpointer)) self->overlay_func) (self->overlay_data);
+}
+
+/*
+ * Planning
  *
- * Updates pipeline.
+ * Generated code points into objects
+ * (buffers, bounds, draw arrays) without
+ * holding references, so installed code
+ * keeps those of the jobs it came from
+ * until it is replaced
  *
- * Returns: TRUE if successful, FALSE otherwise.
  */
-gboolean
-ds_pipeline_update(DsPipeline    *pipeline,
-                   GCancellable  *cancellable,
-                   GError       **error)
+
+static void
+plan_job_free(PlanJob* job)
 {
-  g_return_val_if_fail(DS_IS_PIPELINE(pipeline), FALSE);
-  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
-  JitState* ctx = &(pipeline->ctx);
-  gboolean success = TRUE;
-  GError* tmp_err = NULL;
+  _ds_jit_plan_clear(&(job->plan));
+  g_list_free_full(job->objects, g_object_unref);
+  g_clear_object(&(job->shader));
+  g_slice_free(PlanJob, job);
+}
 
-  /* begin code */
-  _ds_jit_compile_free(ctx);
-  _ds_jit_compile_start(ctx);
+static GPtrArray*
+plan_jobs_new(DsPipeline* pipeline)
+{
+  GPtrArray* jobs =
+  g_ptr_array_new_with_free_func
+  ((GDestroyNotify)
+   plan_job_free);
 
-  /* cycle through programs */
   ShaderList* slist;
   ShaderEntry* entry;
-  ObjectList* olist;
-  GLuint program = 0;
-  GLuint l_jvp, l_mvp;
+  PlanJob* job;
+
+  /*
+   * Snapshot shader entries, so objects
+   * can be appended or removed while
+   * jobs are running
+   *
+   */
 
   for(slist = pipeline->shaders;
       slist != NULL;
@@ -543,73 +839,168 @@ ds_pipeline_update(DsPipeline    *pipeline,
     if(entry->n_objects < 1)
       continue;
 
-    program =
-    _ds_shader_get_pid(entry->shader);
-    ctx->pid = program;
-
-  /*
-   * Prepare mvps
-   *
-   */
+    job = g_slice_new0(PlanJob);
+    job->shader = g_object_ref(entry->shader);
+    job->priority = entry->priority;
+    job->objects =
+    g_list_copy_deep
+    (&(entry->objects->list_),
+     (GCopyFunc)
+     g_object_ref,
+     NULL);
+    g_ptr_array_add(jobs, job);
+  }
+return jobs;
+}
 
-    __gl_try_catch(
-      glUseProgram(program);
-    ,
-      g_propagate_error(error, glerror);
+static gboolean
+plan_job_run(DsPipeline    *pipeline,
+             PlanJob       *job,
+             GCancellable  *cancellable,
+             GError       **error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  DsRenderState* state;
+  GLuint program;
+  GList* list;
+
+  program =
+  _ds_shader_get_pid(job->shader);
+
+  _ds_jit_plan_init
+  (&(job->plan),
+   program,
+   &(pipeline->mvps),
+   _ds_shader_get_uniforms(job->shader));
+  state = (DsRenderState*) &(job->plan);
+
+  /* use program call */
+  ds_render_state_pcall
+  (state,
+   G_CALLBACK(glUseProgram),
+   1,
+   (guintptr) program);
+
+  /* check if matrices must be updated */
+  ds_render_state_pcall
+  (state,
+   G_CALLBACK(mvps_query_start),
+   3,
+   (guintptr) pipeline,
+   (guintptr) ds_render_state_get_uniform_location(state, A_JVP),
+   (guintptr) ds_render_state_get_uniform_location(state, A_MVP));
+
+  /* propagate plan */
+  for(list = job->objects;
+      list != NULL;
+      list = list->next)
+  {
+    if G_UNLIKELY
+      (g_cancellable_set_error_if_cancelled
+       (cancellable, error))
       goto_error();
-    );
 
-    __gl_try_catch(
-      l_mvp = glGetUniformLocation(program, A_MVP);
-    ,
-      g_propagate_error(error, glerror);
+    success =
+    ds_renderable_plan(list->data, state, cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
       goto_error();
-    );
+    }
+  }
+
+_error_:
+return success;
+}
+
+static GPtrArray*
+plan_jobs_refs(GPtrArray* jobs)
+{
+  GPtrArray* refs =
+  g_ptr_array_new_with_free_func(g_object_unref);
+  PlanJob* job;
+  GList* list;
+  guint i;
+
+  for(i = 0;
+      i < jobs->len;
+      i++)
+  {
+    job = g_ptr_array_index(jobs, i);
+    g_ptr_array_add(refs, g_object_ref(job->shader));
+
+    for(list = job->objects;
+        list != NULL;
+        list = list->next)
+    g_ptr_array_add(refs, g_object_ref(list->data));
+  }
+return refs;
+}
+
+static gboolean
+plan_jobs_finalize(DsPipeline  *pipeline,
+                   GPtrArray   *jobs,
+                   guint        serial,
+                   GError     **error)
+{
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  JitState ctx_ = {0};
+  JitState* ctx = &ctx_;
+  gboolean overlay = FALSE;
+  PlanJob* job;
+  guint i;
+
+  /* begin code */
+  _ds_jit_compile_start(ctx);
+
+  for(i = 0;
+      i < jobs->len;
+      i++)
+  {
+    job = g_ptr_array_index(jobs, i);
+
+    /*
+     * Overlay shaders come last (jobs
+     * are sorted by priority), let caller
+     * switch render target before them
+     *
+     */
+
+    if(overlay == FALSE && job->priority >= DS_PIPELINE_PRIORITY_OVERLAY)
+    {
+      _ds_jit_compile_call
+      (ctx,
+       G_CALLBACK(overlay_begin),
+       FALSE,
+       1,
+       (guintptr) pipeline);
+      overlay = TRUE;
+    }
+
+    /*
+     * One-shot setup calls
+     * needs program bound
+     *
+     */
 
     __gl_try_catch(
-      l_jvp = glGetUniformLocation(program, A_JVP);
+      glUseProgram(job->plan.pid);
     ,
       g_propagate_error(error, glerror);
       goto_error();
     );
 
-  /*
-   * Compile
-   *
-   */
-
-    /* use program call */
-    _ds_jit_compile_call
-    (ctx,
-     G_CALLBACK(glUseProgram),
-     TRUE,
-     1,
-     (guintptr) program);
-
-    /* check if matrices must be updated */
-    _ds_jit_compile_call
-    (ctx,
-     G_CALLBACK(mvps_query_start),
-     TRUE,
-     4,
-     (guintptr) pipeline,
-     (guintptr) ctx,
-     (guintptr) l_jvp,
-     (guintptr) l_mvp);
-
-    /* propagate compile */
-    for(olist = entry->objects;
-        olist != NULL;
-        olist = olist->next)
+    success =
+    _ds_jit_plan_run_setup(&(job->plan), &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
     {
-      success =
-      ds_renderable_compile(olist->object, (DsRenderState*) ctx, cancellable, &tmp_err);
-      if G_UNLIKELY(tmp_err != NULL)
-      {
-        g_propagate_error(error, tmp_err);
-        goto_error();
-      }
+      g_propagate_error(error, tmp_err);
+      goto_error();
     }
+
+    _ds_jit_plan_emit(&(job->plan), ctx);
   }
 
   /* reset jvp update flag */
@@ -625,32 +1016,285 @@ _error_:
   _ds_jit_compile_end(ctx);
   if G_LIKELY(success == TRUE)
   {
-    pipeline->main = jitmain;
-    pipeline->modified = FALSE;
+    /*
+     * Ignore results older than
+     * currently installed code
+     *
+     */
+
+    if G_UNLIKELY
+      (pipeline->main != NULL
+       && (gint) (serial - pipeline->built) < 0)
+      _ds_jit_compile_free(ctx);
+    else
+    {
+      _ds_jit_compile_free(&(pipeline->ctx));
+      g_clear_pointer(&(pipeline->installed), g_ptr_array_unref);
+      pipeline->main = jitmain;
+      pipeline->ctx = ctx_;
+      pipeline->installed = plan_jobs_refs(jobs);
+      pipeline->built = serial;
+      pipeline->modified = (pipeline->serial != serial);
+    }
+  }
+  else
+  {
+    _ds_jit_compile_free(ctx);
   }
 return success;
 }
 
+/**
+ * ds_pipeline_update:
+ * @pipeline: a #DsPipeline object.
+ * @cancellable: (nullable): a %GCancellable
+ * @error: return location for a #GError
+ *
+ * Updates pipeline. Must be called from GL thread.
+ *
+ * Returns: TRUE if successful, FALSE otherwise.
+ */
+gboolean
+ds_pipeline_update(DsPipeline    *pipeline,
+                   GCancellable  *cancellable,
+                   GError       **error)
+{
+  g_return_val_if_fail(DS_IS_PIPELINE(pipeline), FALSE);
+  g_return_val_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable), FALSE);
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+  guint serial = pipeline->serial;
+  GPtrArray* jobs = NULL;
+  guint i;
+
+  queue_drain(pipeline);
+  jobs = plan_jobs_new(pipeline);
+
+  for(i = 0;
+      i < jobs->len;
+      i++)
+  {
+    success =
+    plan_job_run(pipeline, g_ptr_array_index(jobs, i), cancellable, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+  }
+
+  success =
+  plan_jobs_finalize(pipeline, jobs, serial, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+_error_:
+  g_ptr_array_unref(jobs);
+return success;
+}
+
+static void
+update_data_free(UpdateData* data)
+{
+  g_ptr_array_unref(data->jobs);
+  g_clear_error(&(data->error));
+  g_slice_free(UpdateData, data);
+}
+
+static void
+plan_job_thread(GTask         *task,
+                DsPipeline    *pipeline,
+                PlanJob       *job,
+                GCancellable  *cancellable)
+{
+  GError* tmp_err = NULL;
+
+  plan_job_run(pipeline, job, cancellable, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+    g_task_return_error(task, tmp_err);
+  else
+    g_task_return_boolean(task, TRUE);
+}
+
+static void
+update_step(DsPipeline  *pipeline,
+            GTask       *task)
+{
+  UpdateData* data = g_task_get_task_data(task);
+
+  if(--data->n_pending > 0)
+    return;
+
+/*
+ * Every job is done,
+ * now link on GL thread
+ *
+ */
+
+  if G_LIKELY(data->error == NULL)
+  {
+    plan_jobs_finalize(pipeline, data->jobs, data->serial, &(data->error));
+  }
+
+  pipeline->pending--;
+
+  if G_UNLIKELY(data->error != NULL)
+    g_task_return_error(task, g_steal_pointer(&(data->error)));
+  else
+    g_task_return_boolean(task, TRUE);
+}
+
+static void
+plan_job_done(DsPipeline    *pipeline,
+              GAsyncResult  *res,
+              GTask         *task)
+{
+  UpdateData* data = g_task_get_task_data(task);
+  GError* tmp_err = NULL;
+
+  g_task_propagate_boolean(G_TASK(res), &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    if(data->error == NULL)
+      data->error = tmp_err;
+    else
+      g_error_free(tmp_err);
+  }
+
+  update_step(pipeline, task);
+  g_object_unref(task);
+}
+
+/**
+ * ds_pipeline_update_async:
+ * @pipeline: a #DsPipeline object.
+ * @cancellable: (nullable): a %GCancellable
+ * @callback: (scope async): a #GAsyncReadyCallback.
+ * @user_data: (closure): data to pass to @callback.
+ *
+ * Asynchronous version of #ds_pipeline_update().
+ * Every shader entry is planned on a worker thread, while
+ * previously produced code keeps being executed. Linking
+ * new code happens on thread-default main context of caller,
+ * which must be GL thread.
+ *
+ */
+void
+ds_pipeline_update_async(DsPipeline          *pipeline,
+                         GCancellable        *cancellable,
+                         GAsyncReadyCallback  callback,
+                         gpointer             user_data)
+{
+  g_return_if_fail(DS_IS_PIPELINE(pipeline));
+  g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+  UpdateData* data = NULL;
+  GTask* task = NULL;
+  GTask* subtask = NULL;
+  guint i;
+
+  task = g_task_new(pipeline, cancellable, callback, user_data);
+  g_task_set_source_tag(task, ds_pipeline_update_async);
+
+  /*
+   * Removals drop object list references
+   * only; code still running until this
+   * update is installed holds its own
+   *
+   */
+
+  queue_drain(pipeline);
+
+  data = g_slice_new0(UpdateData);
+  data->jobs = plan_jobs_new(pipeline);
+  data->serial = pipeline->serial;
+  data->n_pending = data->jobs->len + 1;
+  g_task_set_task_data(task, data, (GDestroyNotify) update_data_free);
+  pipeline->pending++;
+
+  for(i = 0;
+      i < data->jobs->len;
+      i++)
+  {
+    subtask =
+    g_task_new
+    (pipeline,
+     cancellable,
+     (GAsyncReadyCallback)
+     plan_job_done,
+     g_object_ref(task));
+    g_task_set_task_data(subtask, g_ptr_array_index(data->jobs, i), NULL);
+    g_task_run_in_thread(subtask, (GTaskThreadFunc) plan_job_thread);
+    g_object_unref(subtask);
+  }
+
+  /*
+   * Extra pending count accounts
+   * for this function, so empty
+   * pipelines are handled too
+   *
+   */
+
+  update_step(pipeline, task);
+  g_object_unref(task);
+}
+
+/**
+ * ds_pipeline_update_finish:
+ * @pipeline: a #DsPipeline object.
+ * @res: a #GAsyncResult.
+ * @error: return location for a #GError
+ *
+ * Finishes an operation started by #ds_pipeline_update_async().
+ *
+ * Returns: TRUE if successful, FALSE otherwise.
+ */
+gboolean
+ds_pipeline_update_finish(DsPipeline    *pipeline,
+                          GAsyncResult  *res,
+                          GError       **error)
+{
+  g_return_val_if_fail(DS_IS_PIPELINE(pipeline), FALSE);
+  g_return_val_if_fail(g_task_is_valid(res, pipeline), FALSE);
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+return g_task_propagate_boolean(G_TASK(res), error);
+}
+
 /**
  * ds_pipeline_execute:
  * @pipeline: a #DsPipeline object
  *
  * Executes code produced previously by #ds_pipeline_update().
- * Note: if pipeline is modified and not updated, #ds_pipeline_update()
- * is executed under the hood, but since #ds_pipeline_update() could
- * fail it may be lead to a program termination in case of an error is
- * produced.
+ * Note: if pipeline is modified and not updated (neither an
+ * update is in progress), #ds_pipeline_update() is executed under
+ * the hood, but since #ds_pipeline_update() could fail it may be
+ * lead to a program termination in case of an error is produced.
  *
  */
 void
 ds_pipeline_execute(DsPipeline* pipeline)
 {
   g_return_if_fail(DS_IS_PIPELINE(pipeline));
-  JitState* ctx = &(pipeline->ctx);
 
-  if G_UNLIKELY(pipeline->modified == TRUE)
+  gboolean queued =
+  g_atomic_pointer_get(&(pipeline->queue)) != NULL;
+
+  /*
+   * Queued requests are expected to be
+   * picked up here, so only warn about
+   * direct changes left without update
+   *
+   */
+
+  if G_UNLIKELY
+    ((pipeline->modified == TRUE || queued == TRUE)
+     && pipeline->pending == 0)
   {
-    g_warning("Attempt to execute a pipeline containing changes\r\n");
+    if(pipeline->modified == TRUE)
+      g_warning("Attempt to execute a pipeline containing changes\r\n");
 
     GError* tmp_err = NULL;
     ds_pipeline_update(pipeline, NULL, &tmp_err);
@@ -668,8 +1312,18 @@ ds_pipeline_execute(DsPipeline* pipeline)
     }
   }
 
+  /*
+   * An asynchronous update is
+   * on its way, nothing to draw
+   * until it is done
+   *
+   */
+
+  if G_UNLIKELY(pipeline->main == NULL)
+    return;
+
   GError* tmp_err = NULL;
-  pipeline->main(pipeline, &(ctx->mvps), &tmp_err);
+  pipeline->main(pipeline, &(pipeline->mvps), &tmp_err);
   if G_UNLIKELY(tmp_err != NULL)
   {
     g_critical
@@ -683,3 +1337,24 @@ ds_pipeline_execute(DsPipeline* pipeline)
     g_assert_not_reached();
   }
 }
+
+/**
+ * _ds_pipeline_set_overlay_func: (skip)
+ * @pipeline: a #DsPipeline object.
+ * @func: (nullable): function to call, taking @data as only argument.
+ * @data: data to pass to @func.
+ *
+ * Sets a function called during execution right
+ * before first overlay shader (see %DS_PIPELINE_PRIORITY_OVERLAY)
+ * draws, if there is any.
+ *
+ */
+void
+_ds_pipeline_set_overlay_func(DsPipeline  *pipeline,
+                              GCallback    func,
+                              gpointer     data)
+{
+  g_return_if_fail(DS_IS_PIPELINE(pipeline));
+  pipeline->overlay_func = func;
+  pipeline->overlay_data = data;
+}
@@ -29,6 +29,16 @@
 #define DS_IS_PIPELINE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), DS_TYPE_PIPELINE))
 #define DS_PIPELINE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), DS_TYPE_PIPELINE, DsPipelineClass))
 
+/**
+ * DS_PIPELINE_PRIORITY_OVERLAY:
+ *
+ * Shaders registered with this priority or a lower
+ * one (a larger value, such as ds.priority.lower)
+ * draw overlays, like text or UI, which are drawn
+ * on top of scene at native resolution.
+ */
+#define DS_PIPELINE_PRIORITY_OVERLAY (G_PRIORITY_LOW + 1)
+
 typedef struct _DsPipeline      DsPipeline;
 typedef struct _DsPipelineClass DsPipelineClass;
 
@@ -78,16 +88,53 @@ ds_pipeline_remove_object(DsPipeline   *pipeline,
                           const gchar  *shader_name,
                           DsRenderable *object);
 
+DEUSEXMAKINA2_API
+void
+ds_pipeline_queue_append_object(DsPipeline   *pipeline,
+                                const gchar  *shader_name,
+                                int           priority,
+                                DsRenderable *object);
+DEUSEXMAKINA2_API
+void
+ds_pipeline_queue_remove_object(DsPipeline   *pipeline,
+                                const gchar  *shader_name,
+                                DsRenderable *object);
+DEUSEXMAKINA2_API
+void
+ds_pipeline_queue_set_object_priority(DsPipeline   *pipeline,
+                                      const gchar  *shader_name,
+                                      int           priority,
+                                      DsRenderable *object);
+
 DEUSEXMAKINA2_API
 gboolean
 ds_pipeline_update(DsPipeline    *pipeline,
                    GCancellable  *cancellable,
                    GError       **error);
 
+DEUSEXMAKINA2_API
+void
+ds_pipeline_update_async(DsPipeline          *pipeline,
+                         GCancellable        *cancellable,
+                         GAsyncReadyCallback  callback,
+                         gpointer             user_data);
+DEUSEXMAKINA2_API
+gboolean
+ds_pipeline_update_finish(DsPipeline    *pipeline,
+                          GAsyncResult  *res,
+                          GError       **error);
+
 DEUSEXMAKINA2_API
 void
 ds_pipeline_execute(DsPipeline   *pipeline);
 
+/* Internal API */
+G_GNUC_INTERNAL
+void
+_ds_pipeline_set_overlay_func(DsPipeline  *pipeline,
+                              GCallback    func,
+                              gpointer     data);
+
 #if __cplusplus
 }
 #endif // __cplusplus
@@ -41,20 +41,20 @@ typedef DsRenderableIface DsRenderableInterface;
 G_DEFINE_INTERFACE(DsRenderable, ds_renderable, G_TYPE_OBJECT);
 
 static gboolean
-ds_renderable_default_compile(DsRenderable   *renderable,
-                              DsRenderState  *state,
-                              GCancellable   *cancellable,
-                              GError        **error)
+ds_renderable_default_plan(DsRenderable   *renderable,
+                           DsRenderState  *state,
+                           GCancellable   *cancellable,
+                           GError        **error)
 {
   g_warning
-  ("DsRenderable::compile not implemented for '%s'\r\n",
+  ("DsRenderable::plan not implemented for '%s'\r\n",
    g_type_name(G_TYPE_FROM_INSTANCE(renderable)));
 return FALSE;
 }
 
 static
 void ds_renderable_default_init(DsRenderableIface* iface) {
-  iface->compile = ds_renderable_default_compile;
+  iface->plan = ds_renderable_default_plan;
 }
 
 /*
@@ -62,6 +62,43 @@ void ds_renderable_default_init(DsRenderableIface* iface) {
  *
  */
 
+/**
+ * ds_renderable_plan:
+ * @renderable: a #DsRenderable instance.
+ * @state: render plan state.
+ * @cancellable: (nullable): a %GCancellable
+ * @error: return location for a #GError
+ *
+ * Records necessary calls to render @renderable.
+ * This function does not touches GL, so it is safe
+ * to call it from a worker thread.
+ *
+ * Since GL thread keeps going meanwhile, implementations
+ * must only read state fixed once @renderable is
+ * constructed and initialized (construct-only properties,
+ * buffers and tables built on initialization). Anything
+ * changing afterwards must be read by the recorded
+ * calls themselves, at execution (as #DsGameObject does
+ * with its model matrix).
+ *
+ * Returns: whether planning was successful or not.
+ */
+gboolean
+ds_renderable_plan(DsRenderable         *renderable,
+                   DsRenderState        *state,
+                   GCancellable         *cancellable,
+                   GError              **error)
+{
+  g_return_val_if_fail(DS_IS_RENDERABLE(renderable), FALSE);
+  g_return_val_if_fail(state != NULL, FALSE);
+  g_return_val_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable), FALSE);
+  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+  DsRenderableIface* iface =
+  DS_RENDERABLE_GET_IFACE(renderable);
+return iface->plan(renderable, state, cancellable, error);
+}
+
 /**
  * ds_renderable_compile:
  * @renderable: a #DsRenderable instance.
@@ -70,6 +107,8 @@ void ds_renderable_default_init(DsRenderableIface* iface) {
  * @error: return location for a #GError
  *
  * Compiles necessary calls to render @renderable.
+ * Kept for compatibility, it is the same as
+ * ds_renderable_plan().
  *
  * Returns: whether compile was successful or not.
  */
@@ -79,14 +118,7 @@ ds_renderable_compile(DsRenderable         *renderable,
                       GCancellable         *cancellable,
                       GError              **error)
 {
-  g_return_val_if_fail(DS_IS_RENDERABLE(renderable), FALSE);
-  g_return_val_if_fail(state != NULL, FALSE);
-  g_return_val_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable), FALSE);
-  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
-
-  DsRenderableIface* iface =
-  DS_RENDERABLE_GET_IFACE(renderable);
-return iface->compile(renderable, state, cancellable, error);
+return ds_renderable_plan(renderable, state, cancellable, error);
 }
 
 /**
@@ -101,7 +133,27 @@ GLuint
 ds_render_state_get_current_program(DsRenderState* state)
 {
   g_return_val_if_fail(state != NULL, 0);
-return ((JitState*) state)->pid;
+return ((JitPlan*) state)->pid;
+}
+
+/**
+ * ds_render_state_get_uniform_location: (skip)
+ * @state: a #DsRenderable instance.
+ * @name: uniform name.
+ *
+ * Looks up uniform @name on current program reflection.
+ * Use this instead of glGetUniformLocation(), since
+ * render state could live outside GL thread.
+ *
+ * Returns: uniform location, or -1 if it is not active.
+ */
+GLint
+ds_render_state_get_uniform_location(DsRenderState  *state,
+                                     const gchar    *name)
+{
+  g_return_val_if_fail(state != NULL, -1);
+  g_return_val_if_fail(name != NULL, -1);
+return _ds_jit_plan_get_uniform((JitPlan*) state, name);
 }
 
 /**
@@ -117,14 +169,101 @@ void
 ds_render_state_switch_vertex_array(DsRenderState* state, GLuint vao)
 {
   g_return_if_fail(state != NULL);
-  JitState* ctx = (JitState*) state;
+  JitPlan* plan = (JitPlan*) state;
   guintptr vao_ = vao;
 
-  if(ctx->vao != vao)
+  if(plan->vao != vao)
+  {
+    _ds_jit_plan_call(plan, FALSE, G_CALLBACK(glBindVertexArray), TRUE, 1, vao_);
+    plan->vao = vao;
+    plan->vbo = NULL;
+    plan->ibo = NULL;
+  }
+}
+
+/**
+ * ds_render_state_switch_buffer: (skip)
+ * @state: a #DsRenderable instance.
+ * @target: either %GL_ARRAY_BUFFER or %GL_ELEMENT_ARRAY_BUFFER.
+ * @p_buffer: a pointer to buffer object name.
+ *
+ * Tracks buffer bindings on current vertex array.
+ * Buffers are compared by @p_buffer address (names
+ * could be unknown while planning), so objects
+ * sharing a buffer should pass the same pointer.
+ * Caller is expected to record the actual binding
+ * when this function returns %TRUE.
+ *
+ * Returns: whether @p_buffer was not bound to @target yet.
+ */
+gboolean
+ds_render_state_switch_buffer(DsRenderState  *state,
+                              GLenum          target,
+                              const GLuint   *p_buffer)
+{
+  g_return_val_if_fail(state != NULL, FALSE);
+  g_return_val_if_fail(p_buffer != NULL, FALSE);
+  JitPlan* plan = (JitPlan*) state;
+  const GLuint** bound = NULL;
+
+  switch(target)
   {
-    _ds_jit_compile_call(ctx, G_CALLBACK(glBindVertexArray), TRUE, 1, vao_);
-    ctx->vao = vao;
+  case GL_ARRAY_BUFFER:
+    bound = &(plan->vbo);
+    break;
+  case GL_ELEMENT_ARRAY_BUFFER:
+    bound = &(plan->ibo);
+    break;
+  default:
+    g_return_val_if_reached(TRUE);
+    break;
   }
+
+  if(*bound != p_buffer)
+  {
+    *bound = p_buffer;
+    return TRUE;
+  }
+return FALSE;
+}
+
+/**
+ * ds_render_state_setup: (skip)
+ * @state: render compile state.
+ * @callback: function to call.
+ * @n_params: the number of parameter types to follow.
+ * @...: a list of types, one for each parameter.
+ *
+ * Schedules a one-shot call to @callback, which
+ * will be made on GL thread with current program
+ * bound, before pipeline code is linked (useful
+ * for constant uniforms). Setup calls are checked
+ * for GL errors.
+ *
+ */
+void
+ds_render_state_setup(DsRenderState  *state,
+                      GCallback       callback,
+                      guint           n_params,
+                      ...)
+{
+  g_return_if_fail(state != NULL);
+  g_return_if_fail(callback != NULL);
+  g_return_if_fail(n_params <= JIT_MAX_PARAMS);
+
+  va_list l;
+  va_start(l, n_params);
+
+  _ds_jit_plan_call_valist
+  ((JitPlan*)
+   state,
+   TRUE,
+   callback,
+   TRUE,
+   n_params,
+   l);
+
+  va_end(l);
 }
 
 /**
@@ -134,7 +273,7 @@ ds_render_state_switch_vertex_array(DsRenderState* state, GLuint vao)
  * @n_params: the number of parameter types to follow.
  * @...: a list of types, one for each parameter.
  *
- * Compiles a call to @callback.
+ * Records a call to @callback.
  *
  */
 void
@@ -146,13 +285,15 @@ ds_render_state_call(DsRenderState  *state,
   g_return_if_fail(state != NULL);
   g_return_if_fail(callback != NULL);
   g_return_if_fail(n_params > 0);
+  g_return_if_fail(n_params <= JIT_MAX_PARAMS);
 
   va_list l;
   va_start(l, n_params);
 
-  _ds_jit_compile_call_valist
-  ((JitState*)
+  _ds_jit_plan_call_valist
+  ((JitPlan*)
    state,
+   FALSE,
    callback,
    FALSE,
    n_params,
@@ -168,7 +309,7 @@ ds_render_state_call(DsRenderState  *state,
  * @n_params: the number of parameter types to follow.
  * @...: a list of types, one for each parameter.
  *
- * Compiles a protected call to @callback.
+ * Records a protected call to @callback.
  * Protected calls are checked for GL errors.
  *
  */
@@ -181,13 +322,15 @@ ds_render_state_pcall(DsRenderState  *state,
   g_return_if_fail(state != NULL);
   g_return_if_fail(callback != NULL);
   g_return_if_fail(n_params > 0);
+  g_return_if_fail(n_params <= JIT_MAX_PARAMS);
 
   va_list l;
   va_start(l, n_params);
 
-  _ds_jit_compile_call_valist
-  ((JitState*)
+  _ds_jit_plan_call_valist
+  ((JitPlan*)
    state,
+   FALSE,
    callback,
    TRUE,
    n_params,
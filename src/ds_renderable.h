@@ -42,16 +42,25 @@ ds_renderable_get_type();
 /**
  * _DsRenderableIface:
  * @parent_iface: parent type data.
- * @compile: compiles every code needed to render this object.
+ * @plan: records every call needed to render this object.
+ * Implementations must not touch GL here, since plans could
+ * be built outside GL thread; use ds_render_state_setup()
+ * for one-shot GL work instead.
  *
  * The #DsRenderable defined rules to render objects.
  */
 struct _DsRenderableIface
 {
   GTypeInterface parent_iface;
-  gboolean (*compile) (DsRenderable* renderable, DsRenderState* state, GCancellable* cancellable, GError** error);
+  gboolean (*plan) (DsRenderable* renderable, DsRenderState* state, GCancellable* cancellable, GError** error);
 };
 
+DEUSEXMAKINA2_API
+gboolean
+ds_renderable_plan(DsRenderable   *renderable,
+                   DsRenderState  *state,
+                   GCancellable   *cancellable,
+                   GError        **error);
 DEUSEXMAKINA2_API
 gboolean
 ds_renderable_compile(DsRenderable   *renderable,
@@ -61,8 +70,20 @@ ds_renderable_compile(DsRenderable   *renderable,
 
 GLuint
 ds_render_state_get_current_program(DsRenderState* state);
+GLint
+ds_render_state_get_uniform_location(DsRenderState  *state,
+                                     const gchar    *name);
 void
 ds_render_state_switch_vertex_array(DsRenderState* state, GLuint vao);
+gboolean
+ds_render_state_switch_buffer(DsRenderState  *state,
+                              GLenum          target,
+                              const GLuint   *p_buffer);
+void
+ds_render_state_setup(DsRenderState  *state,
+                      GCallback       callback,
+                      guint           n_params,
+                      ...);
 void
 ds_render_state_call(DsRenderState  *state,
                      GCallback       callback,
@@ -17,6 +17,9 @@
  */
 #include <config.h>
 #include <ds_application.h>
+#include <ds_frame_clock.h>
+#include <ds_frame_stats.h>
+#include <ds_game_object_private.h>
 #include <ds_gl.h>
 #include <ds_looper.h>
 #include <ds_macros.h>
@@ -31,6 +34,12 @@ enum {
   conn_width,
   conn_height,
   conn_framelimit,
+  conn_target_fps,
+  conn_vsync,
+  conn_frames_in_flight,
+  conn_dynamic_resolution,
+  conn_frame_budget,
+  conn_min_resolution_scale,
   conn_sensitivity,
   conn_fov,
   conn_fullscreen,
@@ -40,8 +49,76 @@ enum {
 
 #define d self
 
-static void update_view(DsRenderer* self, gfloat xrel, gfloat yrel);
+/*
+ * Frame limiter sleeps until this
+ * close to deadline, then spins
+ *
+ */
+
+#define SPIN_THRESHOLD  (1500)
+#define ACHIEVED_ALPHA  (0.1)
+
+/*
+ * Frames in flight: at most this many,
+ * and never wait on a fence forever
+ *
+ */
+
+#define MAX_IN_FLIGHT   (3)
+#define FENCE_TIMEOUT   (G_GUINT64_CONSTANT(1000000000))
+
+/*
+ * Dynamic resolution: scale is revised
+ * every few frames, in fixed steps, and
+ * only when frame time leaves a band
+ * around budget
+ *
+ */
+
+#define DYNRES_WINDOW   (8)
+#define DYNRES_STEP     (0.05)
+#define DYNRES_HIGH     (1.05)
+#define DYNRES_LOW      (0.85)
+
+/*
+ * Scene GPU time is measured with timer
+ * queries, read back a few frames later
+ * (so reading never stalls)
+ *
+ */
+
+#define N_TIMERS        (MAX_IN_FLIGHT + 1)
+
+/*
+ * Triple-buffered frame state,
+ * 'middle' slot index is stored
+ * with a fresh bit on top of it
+ *
+ */
+
+#define n_frames    (DS_GAME_OBJECT_SLOTS)
+#define FRAME_FRESH (0x4)
+#define FRAME_INDEX (0x3)
+
+typedef struct _FrameState FrameState;
+typedef struct _Offscreen  Offscreen;
+
+struct _Offscreen
+{
+  GLuint fbo;
+  GLuint rbos[2];
+  gint width;
+  gint height;
+};
+
+static void update_front(DsRenderer* self);
+static gboolean latch_view(DsRenderer* self, mat4 view);
 static void update_projection(DsRenderer* self);
+static gboolean offscreen_create(Offscreen* off, gint width, gint height, GError** error);
+static gboolean offscreen_resize(Offscreen* off, gint width, gint height, GError** error);
+static void offscreen_delete(Offscreen* off);
+static void scene_resolve(DsRenderer* self);
+static void scale_update(DsRenderer* self, gint64 elapsed);
 
 /*
  * Object definition
@@ -73,9 +150,77 @@ struct _DsRenderer
   gfloat pitch;
   gfloat sensitivity;
 
+  /*<private>*/
+  GMutex camera_lock;
+  gboolean camera_dirty;
+  gint64 input_time;
+  gint64 latched_time;
+  gboolean latency_log;
+
   /*<private>*/
   gfloat deltaTime;
   gfloat frameTime;
+
+  /*<private>*/
+  gint target_fps;
+  gint target;
+  gint limiter_dirty;
+  gint64 deadline;
+  gint64 last_start;
+  gdouble achieved;
+  gint clock_interval;
+  gint vsync;
+  gint vsync_dirty;
+
+  /*<private>*/
+  gboolean has_sync;
+  gint in_flight;
+  gint in_flight_dirty;
+  GLsync fences[MAX_IN_FLIGHT];
+  guint fence_at;
+  guint n_fences;
+
+  /*<private>*/
+  gboolean headless;
+  Offscreen output;
+
+  /*<private>*/
+  gint dynres;
+  gint budget;
+  gint min_scale;
+  gdouble scale;
+  Offscreen scene;
+  gboolean scene_open;
+  gint native_w;
+  gint native_h;
+  gint64 dynres_acc;
+  guint dynres_frames;
+  gboolean has_timer;
+  GLuint timers[N_TIMERS];
+  gboolean timer_pending[N_TIMERS];
+  guint timer_at;
+
+  /*<private>*/
+  DsFrameStats* stats;
+
+  /*<private>*/
+  gboolean threaded;
+  GThread* thread;
+  GMainContext* context;
+  gint running;
+
+  struct _FrameState
+  {
+    mat4 projection;
+    gint viewport_w;
+    gint viewport_h;
+    guint serial;
+  } current, frames[n_frames];
+
+  guint back;
+  guint front;
+  gint middle;
+  guint projected;
 };
 
 struct _DsRendererClass
@@ -97,6 +242,7 @@ enum {
   prop_gsettings,
   prop_pipeline,
   prop_window,
+  prop_headless,
   prop_number,
 };
 
@@ -135,12 +281,116 @@ on_height_changed(GSettings      *gsettings,
   update_projection(self);
 }
 
+static void
+update_limiter(DsRenderer* self)
+{
+  DsFrameClock* clock =
+  ds_frame_clock_get_default();
+  gint target =
+  g_atomic_int_get(&(d->target));
+
+  if(d->framelimit == TRUE && d->target_fps > 0)
+  {
+    /*
+     * Make frame clock wake up at target
+     * cadence, so limiter only has to absorb
+     * main loop wake-up jitter
+     *
+     */
+
+    if(target == 0)
+      g_atomic_int_set(&(d->clock_interval), (gint) ds_frame_clock_get_interval(clock));
+
+    target = G_USEC_PER_SEC / d->target_fps;
+    if(d->threaded == FALSE)
+      ds_frame_clock_set_interval(clock, target);
+  }
+  else
+  {
+    if(target != 0 && d->threaded == FALSE)
+      ds_frame_clock_set_interval(clock, g_atomic_int_get(&(d->clock_interval)));
+    target = 0;
+  }
+
+  /* deadline is reset on GL thread */
+  g_atomic_int_set(&(d->target), target);
+  g_atomic_int_set(&(d->limiter_dirty), TRUE);
+}
+
 static void
 on_framelimit_changed(GSettings      *gsettings,
                       const gchar    *key,
                       DsRenderer     *self)
 {
   g_settings_get(gsettings, key, "b", &(d->framelimit));
+  update_limiter(self);
+}
+
+static void
+on_target_fps_changed(GSettings      *gsettings,
+                      const gchar    *key,
+                      DsRenderer     *self)
+{
+  g_settings_get(gsettings, key, "i", &(d->target_fps));
+  update_limiter(self);
+}
+
+static void
+on_vsync_changed(GSettings      *gsettings,
+                 const gchar    *key,
+                 DsRenderer     *self)
+{
+  gboolean vsync;
+  g_settings_get(gsettings, key, "b", &vsync);
+
+  /* applied on GL thread */
+  g_atomic_int_set(&(d->vsync), vsync);
+  g_atomic_int_set(&(d->vsync_dirty), TRUE);
+}
+
+static void
+on_frames_in_flight_changed(GSettings      *gsettings,
+                            const gchar    *key,
+                            DsRenderer     *self)
+{
+  gint in_flight;
+  g_settings_get(gsettings, key, "i", &in_flight);
+
+  /* applied on GL thread */
+  g_atomic_int_set(&(d->in_flight), CLAMP(in_flight, 1, MAX_IN_FLIGHT));
+  g_atomic_int_set(&(d->in_flight_dirty), TRUE);
+}
+
+static void
+on_dynamic_resolution_changed(GSettings      *gsettings,
+                              const gchar    *key,
+                              DsRenderer     *self)
+{
+  gboolean dynres;
+  g_settings_get(gsettings, key, "b", &dynres);
+
+  /* applied on GL thread */
+  g_atomic_int_set(&(d->dynres), dynres);
+}
+
+static void
+on_frame_budget_changed(GSettings      *gsettings,
+                        const gchar    *key,
+                        DsRenderer     *self)
+{
+  gdouble budget;
+  g_settings_get(gsettings, key, "d", &budget);
+  g_atomic_int_set(&(d->budget), (gint) (MAX(budget, 1.) * 1000.));
+}
+
+static void
+on_min_resolution_scale_changed(GSettings      *gsettings,
+                                const gchar    *key,
+                                DsRenderer     *self)
+{
+  gdouble min_scale;
+  g_settings_get(gsettings, key, "d", &min_scale);
+  g_atomic_int_set(&(d->min_scale), (gint) (CLAMP(min_scale, 0.1, 1.) * 1000.));
 }
 
 static void
@@ -339,9 +589,14 @@ ds_renderer_g_initable_iface_init_sync(GInitable* pself, GCancellable* cancellab
   g_settings_get(d->gsettings, "fov", "d", &fov);
   g_settings_get(d->gsettings, "sensitivity", "d", &sensitivity);
   g_settings_get(d->gsettings, "framelimit", "b", &(self->framelimit));
+  g_settings_get(d->gsettings, "render-thread", "b", &(self->threaded));
+  g_settings_get(d->gsettings, "target-fps", "i", &(self->target_fps));
 
   d->fov = (gfloat) fov;
   d->sensitivity = (gfloat) sensitivity;
+  d->has_sync = GLEW_VERSION_3_2 || GLEW_ARB_sync;
+  d->has_timer = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+  d->clock_interval = (gint) ds_frame_clock_get_interval(ds_frame_clock_get_default());
 
 /*
  * Get window metrics
@@ -377,6 +632,55 @@ ds_renderer_g_initable_iface_init_sync(GInitable* pself, GCancellable* cancellab
    G_CALLBACK(on_framelimit_changed),
    self);
 
+  d->connections[conn_target_fps] =
+  g_signal_connect
+  (d->gsettings,
+   "changed::target-fps",
+   G_CALLBACK(on_target_fps_changed),
+   self);
+
+  d->connections[conn_vsync] =
+  g_signal_connect
+  (d->gsettings,
+   "changed::vsync",
+   G_CALLBACK(on_vsync_changed),
+   self);
+
+  update_limiter(self);
+  on_vsync_changed(d->gsettings, "vsync", self);
+
+  d->connections[conn_frames_in_flight] =
+  g_signal_connect
+  (d->gsettings,
+   "changed::frames-in-flight",
+   G_CALLBACK(on_frames_in_flight_changed),
+   self);
+  on_frames_in_flight_changed(d->gsettings, "frames-in-flight", self);
+
+  d->connections[conn_dynamic_resolution] =
+  g_signal_connect
+  (d->gsettings,
+   "changed::dynamic-resolution",
+   G_CALLBACK(on_dynamic_resolution_changed),
+   self);
+  on_dynamic_resolution_changed(d->gsettings, "dynamic-resolution", self);
+
+  d->connections[conn_frame_budget] =
+  g_signal_connect
+  (d->gsettings,
+   "changed::frame-budget",
+   G_CALLBACK(on_frame_budget_changed),
+   self);
+  on_frame_budget_changed(d->gsettings, "frame-budget", self);
+
+  d->connections[conn_min_resolution_scale] =
+  g_signal_connect
+  (d->gsettings,
+   "changed::min-resolution-scale",
+   G_CALLBACK(on_min_resolution_scale_changed),
+   self);
+  on_min_resolution_scale_changed(d->gsettings, "min-resolution-scale", self);
+
   d->connections[conn_sensitivity] =
   g_signal_connect
   (d->gsettings,
@@ -457,6 +761,35 @@ ds_renderer_g_initable_iface_init_sync(GInitable* pself, GCancellable* cancellab
   }
 #endif // DEBUG
 
+/*
+ * Headless mode renders into an
+ * offscreen framebuffer, which stays
+ * bound as default one
+ *
+ */
+
+  if(d->headless == TRUE)
+  {
+    success =
+    offscreen_create(&(d->output), d->viewport_w, d->viewport_h, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_propagate_error(error, tmp_err);
+      goto_error();
+    }
+  }
+
+/*
+ * Scene is resolved onto output
+ * before overlays are drawn
+ *
+ */
+
+  _ds_pipeline_set_overlay_func
+  (d->pipeline,
+   G_CALLBACK(scene_resolve),
+   self);
+
 /*
  * Finish by updating things
  *
@@ -473,102 +806,870 @@ ds_renderer_g_initable_iface_init(GInitableIface* iface)
   iface->init = ds_renderer_g_initable_iface_init_sync;
 }
 
-static gboolean
-ds_renderer_class_loop_step(DsLooper* pself)
-{
-  DsRenderer* self =  ((DsRenderer*) pself);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
 /*
- * Frame timing
+ * Offscreen framebuffers: color and
+ * depth-stencil renderbuffers, left
+ * bound after creation or resize
  *
  */
 
-  float current = glfwGetTime();
-  self->deltaTime = current - self->frameTime;
-  self->frameTime = current;
+static gboolean
+offscreen_resize(Offscreen* off, gint width, gint height, GError** error)
+{
+  gboolean success = TRUE;
+  GLenum status;
 
-/*
- * Execute rendering pipeline
- *
- */
+  __gl_try_catch(
+    glBindFramebuffer(GL_FRAMEBUFFER, off->fbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, off->rbos[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, off->rbos[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  ,
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
 
-  ds_pipeline_execute(self->pipeline);
+  __gl_try_catch(
+    status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  ,
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
 
-/*
- * Present display
- *
- */
+  if G_UNLIKELY(status != GL_FRAMEBUFFER_COMPLETE)
+  {
+    g_set_error
+    (error,
+     DS_GL_ERROR,
+     DS_GL_ERROR_INVALID_FRAMEBUFFER_OPERATION,
+     "Incomplete offscreen framebuffer: 0x%x\r\n",
+     status);
+    goto_error();
+  }
 
-  glfwSwapBuffers(d->window);
-return G_SOURCE_CONTINUE;
+  off->width = width;
+  off->height = height;
+
+_error_:
+return success;
 }
 
-static void
-ds_renderer_class_set_property(GObject* pself, guint prop_id, const GValue* value, GParamSpec* pspec)
+static gboolean
+offscreen_create(Offscreen* off, gint width, gint height, GError** error)
 {
-  DsRenderer* self = DS_RENDERER(pself);
-  switch(prop_id)
+  gboolean success = TRUE;
+  GError* tmp_err = NULL;
+
+  __gl_try_catch(
+    glGenFramebuffers(1, &(off->fbo));
+    glGenRenderbuffers(G_N_ELEMENTS(off->rbos), off->rbos);
+    glBindFramebuffer(GL_FRAMEBUFFER, off->fbo);
+  ,
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
+
+  __gl_try_catch(
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, off->rbos[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, off->rbos[1]);
+  ,
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
+
+  success =
+  offscreen_resize(off, width, height, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
   {
-  case prop_gsettings:
-    g_set_object(&(self->gsettings), g_value_get_object(value));
-    break;
-  case prop_pipeline:
-    g_set_object(&(self->pipeline), g_value_get_object(value));
-    break;
-  case prop_window:
-    self->window = g_value_get_pointer(value);
-    break;
-  default:
-    G_OBJECT_WARN_INVALID_PROPERTY_ID(pself, prop_id, pspec);
-    break;
+    g_propagate_error(error, tmp_err);
+    goto_error();
   }
+
+_error_:
+return success;
 }
 
 static void
-ds_renderer_class_dispose(GObject* pself)
+offscreen_delete(Offscreen* off)
 {
-  DsRenderer* self = DS_RENDERER(pself);
-  guint i;
+  if(off->fbo == 0)
+    return;
 
-  for(i = 0;
-      i < conn_number;
-      i++)
-  if(d->connections[i] != 0)
-  {
-    g_signal_handler_disconnect(d->gsettings, d->connections[i]);
-    d->connections[i] = 0;
-  }
+  __gl_try_catch(
+    glDeleteFramebuffers(1, &(off->fbo));
+    glDeleteRenderbuffers(G_N_ELEMENTS(off->rbos), off->rbos);
+  ,
+    g_warning
+    ("(%s: %i): %s: %i: %s\r\n",
+     G_STRFUNC,
+     __LINE__,
+     g_quark_to_string(glerror->domain),
+     glerror->code,
+     glerror->message);
+    g_error_free(glerror);
+  );
 
-  g_clear_object(&(d->gsettings));
-  g_clear_object(&(d->pipeline));
-G_OBJECT_CLASS(ds_renderer_parent_class)->dispose(pself);
+  memset(off, 0, sizeof(Offscreen));
 }
 
+/*
+ * Frame state handoff
+ *
+ */
+
 static void
-ds_renderer_class_init(DsRendererClass* klass)
+emit_projection(DsRenderer* self, FrameState* state)
 {
-  GObjectClass* oclass = G_OBJECT_CLASS(klass);
-  DsLooperClass* lclass = DS_LOOPER_CLASS(klass);
+  GError* tmp_err = NULL;
 
-  lclass->loop_step = ds_renderer_class_loop_step;
+  d->native_w = state->viewport_w;
+  d->native_h = state->viewport_h;
 
-  oclass->set_property = ds_renderer_class_set_property;
-  oclass->dispose = ds_renderer_class_dispose;
+  if G_UNLIKELY
+    (d->headless == TRUE
+     && (d->output.width != state->viewport_w
+      || d->output.height != state->viewport_h))
+  {
+    offscreen_resize(&(d->output), state->viewport_w, state->viewport_h, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_critical
+      ("(%s: %i): %s: %i: %s\r\n",
+       G_STRFUNC,
+       __LINE__,
+       g_quark_to_string(tmp_err->domain),
+       tmp_err->code,
+       tmp_err->message);
+      g_error_free(tmp_err);
+    }
+  }
 
-  signals[sig_update_view] =
-    g_signal_new
-    ("update-view",
-     G_TYPE_FROM_CLASS(klass),
-     G_SIGNAL_ACTION,
-     0,
-     NULL,
-     NULL,
-     g_cclosure_marshal_VOID__POINTER,
-     G_TYPE_NONE,
-     1,
-     G_TYPE_POINTER,
-     G_TYPE_NONE);
+  __gl_try_catch(
+    glViewport(0, 0, state->viewport_w, state->viewport_h);
+  ,
+    g_critical
+    ("(%s: %i): %s: %i: %s\r\n",
+     G_STRFUNC,
+     __LINE__,
+     g_quark_to_string(glerror->domain),
+     glerror->code,
+     glerror->message);
+    g_error_free(glerror);
+    g_assert_not_reached();
+  );
+
+  GValue values[2] = {0};
+  g_value_init(&(values[0]), G_TYPE_OBJECT);
+  g_value_set_object(&(values[0]), self);
+  g_value_init(&(values[1]), G_TYPE_POINTER);
+  g_value_set_pointer(&(values[1]), state->projection);
+
+  g_signal_emitv
+  (values,
+   signals[sig_update_projection],
+   0,
+   NULL);
+
+  g_value_unset(&(values[1]));
+  g_value_unset(&(values[0]));
+}
+
+static void
+emit_view(DsRenderer* self, mat4 view)
+{
+  GValue values[2] = {0};
+  g_value_init(&(values[0]), G_TYPE_OBJECT);
+  g_value_set_object(&(values[0]), self);
+  g_value_init(&(values[1]), G_TYPE_POINTER);
+  g_value_set_pointer(&(values[1]), view);
+
+  g_signal_emitv
+  (values,
+   signals[sig_update_view],
+   0,
+   NULL);
+
+  g_value_unset(&(values[1]));
+  g_value_unset(&(values[0]));
+}
+
+static void
+frame_publish(DsRenderer* self)
+{
+  gint old;
+
+  d->frames[d->back] = d->current;
+  _ds_game_object_publish(d->back);
+
+  do
+    old = g_atomic_int_get(&(d->middle));
+  while(!g_atomic_int_compare_and_exchange(&(d->middle), old, d->back | FRAME_FRESH));
+
+  d->back = old & FRAME_INDEX;
+}
+
+static gboolean
+frame_consume(DsRenderer* self)
+{
+  gint old;
+
+  old = g_atomic_int_get(&(d->middle));
+  if((old & FRAME_FRESH) == 0)
+    return FALSE;
+
+  do
+    old = g_atomic_int_get(&(d->middle));
+  while(!g_atomic_int_compare_and_exchange(&(d->middle), old, d->front));
+
+  d->front = old & FRAME_INDEX;
+  _ds_game_object_consume(d->front);
+return TRUE;
+}
+
+static void
+frame_limit(DsRenderer* self)
+{
+  gint64 now = g_get_monotonic_time();
+  gint64 target, remaining;
+
+  if G_UNLIKELY
+    (g_atomic_int_compare_and_exchange
+     (&(d->limiter_dirty), TRUE, FALSE))
+    d->deadline = 0;
+
+  target = g_atomic_int_get(&(d->target));
+
+  /*
+   * Render thread is not driven by frame
+   * clock, so without vsync nor limiter
+   * keep to clock cadence instead of
+   * spinning
+   *
+   */
+
+  if(target == 0
+    && d->threaded == TRUE
+    && g_atomic_int_get(&(d->vsync)) == FALSE)
+    target = g_atomic_int_get(&(d->clock_interval));
+
+  if(target > 0)
+  {
+    if G_LIKELY(d->deadline > now)
+    {
+      remaining = d->deadline - now;
+      if(remaining > SPIN_THRESHOLD)
+        g_usleep(remaining - SPIN_THRESHOLD);
+      while(g_get_monotonic_time() < d->deadline);
+      now = g_get_monotonic_time();
+    }
+
+    /*
+     * Keep cadence, but when a frame
+     * runs late do not try to catch
+     * up with a burst of frames
+     *
+     */
+
+    d->deadline += target;
+    if G_UNLIKELY(d->deadline <= now)
+      d->deadline = now + target;
+  }
+
+  if G_LIKELY(d->last_start > 0)
+  {
+    gdouble elapsed = (gdouble) (now - d->last_start) / 1000.;
+    d->achieved = (d->achieved == 0.)
+    ? elapsed
+    : d->achieved + ACHIEVED_ALPHA * (elapsed - d->achieved);
+  }
+
+  d->last_start = now;
+}
+
+static void
+fence_wait(DsRenderer* self, GLsync fence)
+{
+  GLenum result =
+  glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+  if G_UNLIKELY(result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+    g_warning("glClientWaitSync(): failed!: 0x%x\r\n", result);
+  glDeleteSync(fence);
+}
+
+static void
+fence_drain(DsRenderer* self)
+{
+  guint i;
+
+  for(i = 0;
+      i < G_N_ELEMENTS(d->fences);
+      i++)
+  if(d->fences[i] != NULL)
+  {
+    fence_wait(self, d->fences[i]);
+    d->fences[i] = NULL;
+  }
+
+  d->fence_at = 0;
+}
+
+/*
+ * Waits until there is less than
+ * 'frames-in-flight' frames queued
+ * on GPU, this is, for fence put after
+ * frame we are 'in_flight' frames ahead
+ *
+ */
+
+static gint64
+frame_throttle(DsRenderer* self)
+{
+  gint64 start = g_get_monotonic_time();
+  GLsync fence;
+
+  if G_UNLIKELY(d->has_sync == FALSE)
+    return 0;
+
+  if G_UNLIKELY
+    (g_atomic_int_compare_and_exchange
+     (&(d->in_flight_dirty), TRUE, FALSE))
+  {
+    fence_drain(self);
+    d->n_fences = g_atomic_int_get(&(d->in_flight));
+  }
+
+  fence = d->fences[d->fence_at];
+  if(fence != NULL)
+  {
+    fence_wait(self, fence);
+    d->fences[d->fence_at] = NULL;
+  }
+return g_get_monotonic_time() - start;
+}
+
+static void
+frame_fence(DsRenderer* self)
+{
+  if G_UNLIKELY(d->has_sync == FALSE)
+    return;
+
+  d->fences[d->fence_at] =
+  glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  d->fence_at = (d->fence_at + 1) % d->n_fences;
+}
+
+/*
+ * Scene timer: a query is started when
+ * scene begins and stopped on resolve;
+ * result for a slot is picked up when
+ * slot comes around again, if ready
+ *
+ */
+
+static void
+timer_begin(DsRenderer* self)
+{
+  GLuint timer, ready = GL_FALSE;
+  GLuint64 elapsed = 0;
+
+  if G_UNLIKELY(d->has_timer == FALSE)
+    return;
+  if G_UNLIKELY(d->timers[0] == 0)
+    glGenQueries(N_TIMERS, d->timers);
+
+  timer = d->timers[d->timer_at];
+  if(d->timer_pending[d->timer_at] == TRUE)
+  {
+    glGetQueryObjectuiv(timer, GL_QUERY_RESULT_AVAILABLE, &ready);
+    if G_LIKELY(ready == GL_TRUE)
+    {
+      glGetQueryObjectui64v(timer, GL_QUERY_RESULT, &elapsed);
+      scale_update(self, (gint64) (elapsed / 1000));
+    }
+
+    d->timer_pending[d->timer_at] = FALSE;
+  }
+
+  glBeginQuery(GL_TIME_ELAPSED, timer);
+}
+
+static void
+timer_end(DsRenderer* self)
+{
+  if G_UNLIKELY(d->has_timer == FALSE)
+    return;
+
+  glEndQuery(GL_TIME_ELAPSED);
+  d->timer_pending[d->timer_at] = TRUE;
+  d->timer_at = (d->timer_at + 1) % N_TIMERS;
+}
+
+static void
+timer_drop(DsRenderer* self)
+{
+  if(d->timers[0] != 0)
+    glDeleteQueries(N_TIMERS, d->timers);
+
+  memset(d->timers, 0, sizeof(d->timers));
+  memset(d->timer_pending, 0, sizeof(d->timer_pending));
+  d->timer_at = 0;
+}
+
+/*
+ * Dynamic resolution: scene renders
+ * into a scaled offscreen framebuffer,
+ * which is upscaled onto output right
+ * before overlays (or at frame end)
+ *
+ */
+
+static void
+scene_begin(DsRenderer* self)
+{
+  GError* tmp_err = NULL;
+  gint width, height;
+
+  if(g_atomic_int_get(&(d->dynres)) == FALSE)
+  {
+    if G_UNLIKELY(d->scene.fbo != 0)
+    {
+      offscreen_delete(&(d->scene));
+      glBindFramebuffer(GL_FRAMEBUFFER, d->output.fbo);
+      glViewport(0, 0, d->native_w, d->native_h);
+      timer_drop(self);
+      d->dynres_acc = 0;
+      d->dynres_frames = 0;
+      d->scale = 1.;
+    }
+    return;
+  }
+
+  width = MAX(1, (gint) (d->native_w * d->scale + 0.5));
+  height = MAX(1, (gint) (d->native_h * d->scale + 0.5));
+
+  if G_UNLIKELY(d->scene.fbo == 0)
+    offscreen_create(&(d->scene), width, height, &tmp_err);
+  else
+  if G_UNLIKELY(d->scene.width != width || d->scene.height != height)
+    offscreen_resize(&(d->scene), width, height, &tmp_err);
+  else
+    glBindFramebuffer(GL_FRAMEBUFFER, d->scene.fbo);
+
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_critical
+    ("(%s: %i): %s: %i: %s\r\n",
+     G_STRFUNC,
+     __LINE__,
+     g_quark_to_string(tmp_err->domain),
+     tmp_err->code,
+     tmp_err->message);
+    g_error_free(tmp_err);
+
+    /* give up until re-enabled */
+    g_atomic_int_set(&(d->dynres), FALSE);
+    offscreen_delete(&(d->scene));
+    glBindFramebuffer(GL_FRAMEBUFFER, d->output.fbo);
+    return;
+  }
+
+  glViewport(0, 0, width, height);
+  d->scene_open = TRUE;
+  timer_begin(self);
+}
+
+static void
+scene_resolve(DsRenderer* self)
+{
+  if(d->scene_open == FALSE)
+    return;
+
+  __gl_try_catch(
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, d->scene.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, d->output.fbo);
+    glBlitFramebuffer
+    (0, 0, d->scene.width, d->scene.height,
+     0, 0, d->native_w, d->native_h,
+     GL_COLOR_BUFFER_BIT,
+     GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, d->output.fbo);
+    glViewport(0, 0, d->native_w, d->native_h);
+    glClear(GL_DEPTH_BUFFER_BIT);
+  ,
+    g_critical
+    ("(%s: %i): %s: %i: %s\r\n",
+     G_STRFUNC,
+     __LINE__,
+     g_quark_to_string(glerror->domain),
+     glerror->code,
+     glerror->message);
+    g_error_free(glerror);
+  );
+
+  timer_end(self);
+  d->scene_open = FALSE;
+}
+
+/*
+ * Fed with scene time only, never swap
+ * or throttle time: those are pinned to
+ * vblank, so scale would never recover
+ * after a missed one
+ *
+ */
+
+static void
+scale_update(DsRenderer* self, gint64 elapsed)
+{
+  gdouble avg, budget, min_scale, scale;
+
+  if(d->scene.fbo == 0)
+    return;
+
+  d->dynres_acc += elapsed;
+  if(++d->dynres_frames < DYNRES_WINDOW)
+    return;
+
+  avg = (gdouble) d->dynres_acc / d->dynres_frames;
+  budget = (gdouble) g_atomic_int_get(&(d->budget));
+  min_scale = (gdouble) g_atomic_int_get(&(d->min_scale)) / 1000.;
+  d->dynres_acc = 0;
+  d->dynres_frames = 0;
+  scale = d->scale;
+
+  /*
+   * Cost goes with pixel count, this is,
+   * with scale squared; steps keep offscreen
+   * framebuffer from being reallocated for
+   * every tiny change
+   *
+   */
+
+  if(avg > budget * DYNRES_HIGH)
+    scale = floor(scale * sqrt(budget / avg) / DYNRES_STEP) * DYNRES_STEP;
+  else
+  if(avg < budget * DYNRES_LOW)
+    scale = scale + DYNRES_STEP;
+
+  d->scale = CLAMP(scale, min_scale, 1.);
+}
+
+static void
+render_frame(DsRenderer* self)
+{
+  if G_UNLIKELY
+    (g_atomic_int_compare_and_exchange
+     (&(d->vsync_dirty), TRUE, FALSE))
+  {
+    glfwSwapInterval(g_atomic_int_get(&(d->vsync)) ? 1 : 0);
+  }
+
+  frame_limit(self);
+
+  if(d->threaded == TRUE)
+  {
+    if(frame_consume(self) == TRUE
+      && d->frames[d->front].serial != d->projected)
+    {
+      d->projected = d->frames[d->front].serial;
+      emit_projection(self, &(d->frames[d->front]));
+    }
+  }
+  else
+  {
+    _ds_game_object_publish(d->back);
+    _ds_game_object_consume(d->back);
+  }
+
+  gint64 waited = frame_throttle(self);
+  gint64 start = g_get_monotonic_time();
+  gint64 executed, swapped;
+  mat4 view;
+
+  scene_begin(self);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+/*
+ * Frame timing
+ *
+ */
+
+  float current = glfwGetTime();
+  self->deltaTime = current - self->frameTime;
+  self->frameTime = current;
+
+/*
+ * Late-latch camera: view is built
+ * from latest input right before
+ * pipeline reads it
+ *
+ */
+
+  if(latch_view(self, view) == TRUE)
+    emit_view(self, view);
+
+/*
+ * Execute rendering pipeline
+ *
+ */
+
+  ds_pipeline_execute(self->pipeline);
+  scene_resolve(self);
+  executed = g_get_monotonic_time();
+
+/*
+ * Present display
+ *
+ */
+
+  if G_LIKELY(d->headless == FALSE)
+    glfwSwapBuffers(d->window);
+  else
+    glFinish();
+  swapped = g_get_monotonic_time();
+
+  frame_fence(self);
+
+  if G_UNLIKELY(d->latency_log == TRUE && d->latched_time > 0)
+  {
+    g_printerr
+    ("latency: %.3f ms (input -> swap)\r\n",
+     (gdouble) (swapped - d->latched_time) / 1000.);
+    d->latched_time = 0;
+  }
+
+  /*
+   * Script time is accounted on default
+   * ring, move it to ours if it is another
+   *
+   */
+
+  if G_UNLIKELY(d->stats != ds_frame_stats_get_default())
+  {
+    ds_frame_stats_add_script_time
+    (d->stats,
+     _ds_frame_stats_take_script_time
+     (ds_frame_stats_get_default()));
+  }
+
+  ds_frame_stats_push
+  (d->stats,
+   swapped - start,
+   executed - start,
+   swapped - executed,
+   waited);
+
+  /* no timer queries, CPU side is the best guess */
+  if G_UNLIKELY(d->has_timer == FALSE)
+    scale_update(self, executed - start);
+}
+
+static gpointer
+render_thread(DsRenderer* self)
+{
+  g_main_context_push_thread_default(d->context);
+  glfwMakeContextCurrent(d->window);
+
+  while(g_atomic_int_get(&(d->running)) == TRUE)
+  {
+    while(g_main_context_iteration(d->context, FALSE));
+    render_frame(self);
+  }
+
+  glfwMakeContextCurrent(NULL);
+  g_main_context_pop_thread_default(d->context);
+return NULL;
+}
+
+/*
+ * With a render thread, main thread
+ * still steps on render phase (after
+ * simulation) but only to hand a frame
+ * state over
+ *
+ */
+
+static gboolean
+ds_renderer_class_loop_step(DsLooper* pself)
+{
+  DsRenderer* self =  ((DsRenderer*) pself);
+  if(d->threaded == TRUE)
+    frame_publish(self);
+  else
+    render_frame(self);
+return G_SOURCE_CONTINUE;
+}
+
+static void
+ds_renderer_class_start(DsLooper* pself)
+{
+  DsRenderer* self =  ((DsRenderer*) pself);
+  DS_LOOPER_CLASS(ds_renderer_parent_class)->start(pself);
+
+  if(d->threaded == FALSE)
+    return;
+
+  if G_LIKELY(d->thread == NULL)
+  {
+    /* hand GL context over */
+    glfwMakeContextCurrent(NULL);
+    _ds_gl_set_context(d->context);
+
+    g_atomic_int_set(&(d->running), TRUE);
+    d->thread =
+    g_thread_new
+    ("renderer",
+     (GThreadFunc)
+     render_thread,
+     self);
+  }
+}
+
+static void
+ds_renderer_class_stop(DsLooper* pself)
+{
+  DsRenderer* self =  ((DsRenderer*) pself);
+  DS_LOOPER_CLASS(ds_renderer_parent_class)->stop(pself);
+
+  if(d->threaded == FALSE)
+    return;
+
+  if G_LIKELY(d->thread != NULL)
+  {
+    g_atomic_int_set(&(d->running), FALSE);
+    g_main_context_wakeup(d->context);
+    g_thread_join(d->thread);
+    d->thread = NULL;
+
+    /* take GL context back */
+    glfwMakeContextCurrent(d->window);
+    _ds_gl_set_context(NULL);
+
+    /* run GL work queued meanwhile */
+    while(g_main_context_iteration(d->context, FALSE));
+  }
+}
+
+static void
+ds_renderer_class_set_property(GObject* pself, guint prop_id, const GValue* value, GParamSpec* pspec)
+{
+  DsRenderer* self = DS_RENDERER(pself);
+  switch(prop_id)
+  {
+  case prop_gsettings:
+    g_set_object(&(self->gsettings), g_value_get_object(value));
+    break;
+  case prop_pipeline:
+    g_set_object(&(self->pipeline), g_value_get_object(value));
+    break;
+  case prop_window:
+    self->window = g_value_get_pointer(value);
+    break;
+  case prop_headless:
+    self->headless = g_value_get_boolean(value);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID(pself, prop_id, pspec);
+    break;
+  }
+}
+
+static void
+ds_renderer_class_dispose(GObject* pself)
+{
+  DsRenderer* self = DS_RENDERER(pself);
+  guint i;
+
+  ds_renderer_class_stop(DS_LOOPER(pself));
+
+  if G_LIKELY(d->has_sync == TRUE)
+    fence_drain(self);
+
+  offscreen_delete(&(d->scene));
+  offscreen_delete(&(d->output));
+  timer_drop(self);
+
+  if(d->pipeline != NULL)
+    _ds_pipeline_set_overlay_func(d->pipeline, NULL, NULL);
+
+  for(i = 0;
+      i < conn_number;
+      i++)
+  if(d->connections[i] != 0)
+  {
+    g_signal_handler_disconnect(d->gsettings, d->connections[i]);
+    d->connections[i] = 0;
+  }
+
+  g_clear_object(&(d->gsettings));
+  g_clear_object(&(d->pipeline));
+G_OBJECT_CLASS(ds_renderer_parent_class)->dispose(pself);
+}
+
+static void
+ds_renderer_class_finalize(GObject* pself)
+{
+  DsRenderer* self = DS_RENDERER(pself);
+  const gchar* csv = NULL;
+  GError* tmp_err = NULL;
+
+/*
+ * Dump frame statistics
+ *
+ */
+
+  csv = g_getenv(DS_FRAME_STATS_CSV_ENV);
+  if G_UNLIKELY(csv != NULL && csv[0] != '\0')
+  {
+    ds_frame_stats_dump_csv(d->stats, csv, &tmp_err);
+    if G_UNLIKELY(tmp_err != NULL)
+    {
+      g_warning
+      ("(%s: %i): %s: %i: %s\r\n",
+       G_STRFUNC,
+       __LINE__,
+       g_quark_to_string(tmp_err->domain),
+       tmp_err->code,
+       tmp_err->message);
+      g_error_free(tmp_err);
+    }
+  }
+
+  ds_frame_stats_unref(d->stats);
+  g_main_context_unref(d->context);
+  g_mutex_clear(&(d->camera_lock));
+G_OBJECT_CLASS(ds_renderer_parent_class)->finalize(pself);
+}
+
+static void
+ds_renderer_class_init(DsRendererClass* klass)
+{
+  GObjectClass* oclass = G_OBJECT_CLASS(klass);
+  DsLooperClass* lclass = DS_LOOPER_CLASS(klass);
+
+  lclass->loop_step = ds_renderer_class_loop_step;
+  lclass->start = ds_renderer_class_start;
+  lclass->stop = ds_renderer_class_stop;
+
+  oclass->set_property = ds_renderer_class_set_property;
+  oclass->finalize = ds_renderer_class_finalize;
+  oclass->dispose = ds_renderer_class_dispose;
+
+  signals[sig_update_view] =
+    g_signal_new
+    ("update-view",
+     G_TYPE_FROM_CLASS(klass),
+     G_SIGNAL_ACTION,
+     0,
+     NULL,
+     NULL,
+     g_cclosure_marshal_VOID__POINTER,
+     G_TYPE_NONE,
+     1,
+     G_TYPE_POINTER,
+     G_TYPE_NONE);
 
   signals[sig_update_projection] =
     g_signal_new
@@ -607,6 +1708,14 @@ ds_renderer_class_init(DsRendererClass* klass)
      | G_PARAM_CONSTRUCT_ONLY
      | G_PARAM_STATIC_STRINGS);
 
+  properties[prop_headless] =
+    g_param_spec_boolean
+    (_TRIPLET("headless"),
+     FALSE,
+     G_PARAM_WRITABLE
+     | G_PARAM_CONSTRUCT_ONLY
+     | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties
   (oclass,
    prop_number,
@@ -616,6 +1725,14 @@ ds_renderer_class_init(DsRendererClass* klass)
 static void
 ds_renderer_init(DsRenderer* self)
 {
+  self->context = g_main_context_new();
+  self->stats = ds_frame_stats_ref(ds_frame_stats_get_default());
+  g_mutex_init(&(self->camera_lock));
+  self->latency_log = g_getenv(DS_RENDERER_LATENCY_ENV) != NULL;
+  self->scale = 1.;
+  self->back = 0;
+  self->front = 1;
+  self->middle = 2;
 }
 
 /*
@@ -632,9 +1749,7 @@ ds_renderer_init(DsRenderer* self)
 #define sensitivity self->sensitivity
 
 static void
-update_view(DsRenderer     *self,
-            gfloat          xrel,
-            gfloat          yrel)
+update_front(DsRenderer* self)
 {
   if(pitch > 89.f)
     pitch = 89.f;
@@ -650,81 +1765,69 @@ update_view(DsRenderer     *self,
   front[2] = sin(yaw_r) * cos(pitch_r);
 
   vec3 right;
-  //vec3 up;
-  vec3 center;
-  mat4 camera;
-
   glm_vec3_cross(front, worldup, right);
   glm_vec3_cross(right, front, up);
-  glm_vec3_add(position, front, center);
-  glm_lookat(position, center, up, camera);
+
+  self->camera_dirty = TRUE;
+  if(self->input_time == 0)
+    self->input_time = g_get_monotonic_time();
+}
 
 /*
- * Emit signal
+ * Called from whichever thread renders,
+ * just before pipeline execution, so view
+ * matrix reflects input received until
+ * last moment instead of last frame
  *
  */
 
-  GValue values[2] = {0};
-  g_value_init(&(values[0]), G_TYPE_OBJECT);
-  g_value_set_object(&(values[0]), self);
-  g_value_init(&(values[1]), G_TYPE_POINTER);
-  g_value_set_pointer(&(values[1]), camera);
+static gboolean
+latch_view(DsRenderer* self, mat4 view)
+{
+  vec3 center;
 
-  g_signal_emitv
-  (values,
-   signals[sig_update_view],
-   0,
-   NULL);
+  g_mutex_lock(&(self->camera_lock));
+  if(self->camera_dirty == FALSE)
+  {
+    g_mutex_unlock(&(self->camera_lock));
+    return FALSE;
+  }
 
-  g_value_unset(&(values[1]));
-  g_value_unset(&(values[0]));
+  glm_vec3_add(position, front, center);
+  glm_lookat(position, center, up, view);
+
+  self->latched_time = self->input_time;
+  self->input_time = 0;
+  self->camera_dirty = FALSE;
+  g_mutex_unlock(&(self->camera_lock));
+return TRUE;
 }
 
 static void
 update_projection(DsRenderer* self)
 {
-  mat4 projection;
   glm_perspective
   (glm_rad(d->fov),
      ((gfloat) d->width)
    / ((gfloat) d->height),
    0.1f,
    100.0f,
-   projection);
+   d->current.projection);
 
-  __gl_try_catch(
-    glViewport(0, 0, d->viewport_w, d->viewport_h);
-  ,
-    g_critical
-    ("(%s: %i): %s: %i: %s\r\n",
-     G_STRFUNC,
-     __LINE__,
-     g_quark_to_string(glerror->domain),
-     glerror->code,
-     glerror->message);
-    g_error_free(glerror);
-    g_assert_not_reached();
-  );
+  d->current.viewport_w = d->viewport_w;
+  d->current.viewport_h = d->viewport_h;
+  d->current.serial++;
 
 /*
- * Emit signal
+ * Emit signal, or hand it over
+ * to render thread
  *
  */
 
-  GValue values[2] = {0};
-  g_value_init(&(values[0]), G_TYPE_OBJECT);
-  g_value_set_object(&(values[0]), self);
-  g_value_init(&(values[1]), G_TYPE_POINTER);
-  g_value_set_pointer(&(values[1]), projection);
-
-  g_signal_emitv
-  (values,
-   signals[sig_update_projection],
-   0,
-   NULL);
-
-  g_value_unset(&(values[1]));
-  g_value_unset(&(values[0]));
+  if(d->threaded == TRUE)
+    frame_publish(self);
+  else
+    emit_projection(self, &(d->current));
 }
 
 #undef sensitivity
@@ -741,12 +1844,15 @@ update_projection(DsRenderer* self)
  * @gsettings: (not nullable): a #GSettings object.
  * @pipeline: (not nullable) (type Ds.Pipeline): pipeline object to execute.
  * @window: (not nullable): SDL window object.
+ * @headless: whether @window has no visible surface.
  * @cancellable: (nullable): a %GCancellable
  * @error: return location for a #GError
  *
  * Creates a new #DsRenderer instance, which uses @window
  * as rendering target and @pipeline as rendering pipeline.
  * @gsettings is used to get and watch rendering settings.
+ * If @headless is %TRUE, rendering goes to an offscreen
+ * framebuffer instead of @window's.
  *
  * Returns: (transfer full): a new #DsRenderer object.
  */
@@ -754,6 +1860,7 @@ DsRenderer*
 ds_renderer_new(GSettings      *gsettings,
                 gpointer        pipeline,
                 gpointer        window,
+                gboolean        headless,
                 GCancellable   *cancellable,
                 GError        **error)
 {
@@ -765,6 +1872,8 @@ ds_renderer_new(GSettings      *gsettings,
    "gsettings", gsettings,
    "pipeline", pipeline,
    "window", window,
+   "headless", headless,
+   "phase", DS_FRAME_CLOCK_PHASE_RENDER,
    NULL);
 }
 
@@ -782,7 +1891,35 @@ ds_renderer_force_update(DsRenderer* renderer)
   g_return_if_fail(DS_IS_RENDERER(renderer));
 
   update_projection(renderer);
-  update_view(renderer, 0, 0);
+
+  g_mutex_lock(&(renderer->camera_lock));
+  update_front(renderer);
+  g_mutex_unlock(&(renderer->camera_lock));
+}
+
+/**
+ * ds_renderer_stamp_input:
+ * @renderer: a #DsRenderer object.
+ * @timestamp: when input was sampled (see #DsEvEntry).
+ *
+ * Tells @renderer that camera changes about to be
+ * made come from input sampled at @timestamp, so
+ * latency log measures from there (earliest input
+ * since last frame is kept). Without it, time of
+ * #ds_renderer_look() or #ds_renderer_move() call
+ * is used instead.
+ *
+ */
+void
+ds_renderer_stamp_input(DsRenderer  *renderer,
+                        gint64       timestamp)
+{
+  g_return_if_fail(DS_IS_RENDERER(renderer));
+  g_mutex_lock(&(renderer->camera_lock));
+
+  if(renderer->input_time == 0 || renderer->input_time > timestamp)
+    renderer->input_time = timestamp;
+  g_mutex_unlock(&(renderer->camera_lock));
 }
 
 #define yaw         renderer->yaw
@@ -797,6 +1934,8 @@ ds_renderer_force_update(DsRenderer* renderer)
  *
  * Performs some kind of "look around" action,
  * which ofcourse depends on game mechanics.
+ * View matrix is not built here, but latched
+ * right before next frame is rendered.
  *
  */
 void
@@ -805,13 +1944,15 @@ ds_renderer_look(DsRenderer  *renderer,
                  gfloat       yrel)
 {
   g_return_if_fail(DS_IS_RENDERER(renderer));
+  g_mutex_lock(&(renderer->camera_lock));
 
   /* calculate euler angles */
   yaw = yaw + (xrel * sensitivity);
   pitch = pitch - (yrel * sensitivity);
 
-  /* update view */
-  update_view(renderer, xrel, yrel);
+  /* view is built on next frame */
+  update_front(renderer);
+  g_mutex_unlock(&(renderer->camera_lock));
 }
 
 #undef sensitivity
@@ -845,6 +1986,7 @@ ds_renderer_move(DsRenderer  *renderer,
                  gboolean     relative)
 {
   g_return_if_fail(DS_IS_RENDERER(renderer));
+  g_mutex_lock(&(renderer->camera_lock));
 
   /* calculate new position */
   vec3 vec_ = {xrel, yrel, zrel};
@@ -868,10 +2010,127 @@ ds_renderer_move(DsRenderer  *renderer,
     glm_vec3_add(position, vec_, position);
   }
 
-  update_view(renderer, 0, 0);
+  /* view is built on next frame */
+  update_front(renderer);
+  g_mutex_unlock(&(renderer->camera_lock));
 }
 
 #undef sensitivity
 #undef up
 #undef front
 #undef position
+
+/**
+ * ds_renderer_get_context:
+ * @renderer: a #DsRenderer object.
+ *
+ * Gets main context which owns GL context. If 'render-thread'
+ * setting is enabled, this is a context iterated by render
+ * thread between frames, and any GL work (such as pipeline
+ * updates or GL resource loading) should be dispatched to it
+ * (see g_main_context_invoke()). Otherwise it returns
+ * global-default main context.
+ *
+ * Returns: (transfer none): a #GMainContext.
+ */
+GMainContext*
+ds_renderer_get_context(DsRenderer* renderer)
+{
+  g_return_val_if_fail(DS_IS_RENDERER(renderer), NULL);
+  if(renderer->threaded == TRUE)
+    return renderer->context;
+return g_main_context_default();
+}
+
+/**
+ * ds_renderer_get_target_frame_time:
+ * @renderer: a #DsRenderer object.
+ *
+ * Gets frame time frame limiter aims for,
+ * as set by 'framelimit' and 'target-fps'
+ * settings.
+ *
+ * Returns: target frame time in milliseconds,
+ * or zero if frame rate is not limited.
+ */
+gdouble
+ds_renderer_get_target_frame_time(DsRenderer* renderer)
+{
+  g_return_val_if_fail(DS_IS_RENDERER(renderer), 0.);
+return (gdouble) g_atomic_int_get(&(renderer->target)) / 1000.;
+}
+
+/**
+ * ds_renderer_get_achieved_frame_time:
+ * @renderer: a #DsRenderer object.
+ *
+ * Gets frame time actually achieved, as an
+ * exponential moving average of the time
+ * between consecutive frames.
+ *
+ * Returns: achieved frame time in milliseconds.
+ */
+gdouble
+ds_renderer_get_achieved_frame_time(DsRenderer* renderer)
+{
+  g_return_val_if_fail(DS_IS_RENDERER(renderer), 0.);
+return renderer->achieved;
+}
+
+/**
+ * ds_renderer_get_frame_stats:
+ * @renderer: a #DsRenderer object.
+ *
+ * Gets frame statistics @renderer records
+ * every frame into.
+ *
+ * Returns: (transfer none): a #DsFrameStats.
+ */
+DsFrameStats*
+ds_renderer_get_frame_stats(DsRenderer* renderer)
+{
+  g_return_val_if_fail(DS_IS_RENDERER(renderer), NULL);
+return renderer->stats;
+}
+
+/**
+ * ds_renderer_set_frame_stats:
+ * @renderer: a #DsRenderer object.
+ * @stats: (nullable): a #DsFrameStats, or %NULL for default ones.
+ *
+ * Makes @renderer record frames into @stats, for
+ * instance a ring sized for a benchmark run. Must
+ * be called while @renderer is stopped.
+ *
+ */
+void
+ds_renderer_set_frame_stats(DsRenderer    *renderer,
+                            DsFrameStats  *stats)
+{
+  g_return_if_fail(DS_IS_RENDERER(renderer));
+  g_return_if_fail(renderer->thread == NULL);
+
+  if(stats == NULL)
+    stats = ds_frame_stats_get_default();
+
+  ds_frame_stats_ref(stats);
+  ds_frame_stats_unref(renderer->stats);
+  renderer->stats = stats;
+}
+
+/**
+ * ds_renderer_get_resolution_scale:
+ * @renderer: a #DsRenderer object.
+ *
+ * Gets scale scene is currently rendered at,
+ * relative to output size. It is always 1 unless
+ * 'dynamic-resolution' setting is enabled.
+ *
+ * Returns: resolution scale, from 'min-resolution-scale' to 1.
+ */
+gdouble
+ds_renderer_get_resolution_scale(DsRenderer* renderer)
+{
+  g_return_val_if_fail(DS_IS_RENDERER(renderer), 1.);
+return renderer->scale;
+}
@@ -18,6 +18,7 @@
 #ifndef __DS_RENDERER_INCLUDED__
 #define __DS_RENDERER_INCLUDED__ 1
 #include <ds_export.h>
+#include <ds_frame_stats.h>
 #include <gio/gio.h>
 
 #define DS_TYPE_RENDERER            (ds_renderer_get_type())
@@ -27,6 +28,15 @@
 #define DS_IS_RENDERER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), DS_TYPE_RENDERER))
 #define DS_RENDERER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), DS_TYPE_RENDERER, DsRendererClass))
 
+/**
+ * DS_RENDERER_LATENCY_ENV:
+ *
+ * Environment variable which, when set, makes
+ * renderer log time from camera input to frame
+ * presentation, for every frame which has any.
+ */
+#define DS_RENDERER_LATENCY_ENV "DS_LATENCY_LOG"
+
 typedef struct _DsRenderer      DsRenderer;
 typedef struct _DsRendererClass DsRendererClass;
 
@@ -43,6 +53,7 @@ DsRenderer*
 ds_renderer_new(GSettings      *gsettings,
                 gpointer        pipeline,
                 gpointer        window,
+                gboolean        headless,
                 GCancellable   *cancellable,
                 GError        **error);
 DEUSEXMAKINA2_API
@@ -50,6 +61,10 @@ void
 ds_renderer_force_update(DsRenderer* renderer);
 DEUSEXMAKINA2_API
 void
+ds_renderer_stamp_input(DsRenderer  *renderer,
+                        gint64       timestamp);
+DEUSEXMAKINA2_API
+void
 ds_renderer_look(DsRenderer  *renderer,
                  gfloat       xrel,
                  gfloat       yrel);
@@ -60,6 +75,25 @@ ds_renderer_move(DsRenderer  *renderer,
                  gfloat       yrel,
                  gfloat       zrel,
                  gboolean     relative);
+DEUSEXMAKINA2_API
+GMainContext*
+ds_renderer_get_context(DsRenderer* renderer);
+DEUSEXMAKINA2_API
+gdouble
+ds_renderer_get_target_frame_time(DsRenderer* renderer);
+DEUSEXMAKINA2_API
+gdouble
+ds_renderer_get_achieved_frame_time(DsRenderer* renderer);
+DEUSEXMAKINA2_API
+DsFrameStats*
+ds_renderer_get_frame_stats(DsRenderer* renderer);
+DEUSEXMAKINA2_API
+void
+ds_renderer_set_frame_stats(DsRenderer    *renderer,
+                            DsFrameStats  *stats);
+DEUSEXMAKINA2_API
+gdouble
+ds_renderer_get_resolution_scale(DsRenderer* renderer);
 
 #if __cplusplus
 }
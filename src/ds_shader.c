@@ -86,6 +86,8 @@ struct _DsShader
 
   /*<private>*/
   GLuint pid;
+  GHashTable* uniforms;
+  guint attributes;
   DsCacheProvider* cache_provider;
 
   /*<private>*/
@@ -446,6 +448,117 @@ _error_:
 return success;
 }
 
+static gboolean
+reflect_uniforms(GLuint pid, GHashTable* uniforms, GError** error)
+{
+  gboolean success = TRUE;
+  GLint i, n_uniforms = 0;
+  GLint maxlen = 0;
+  GLsizei length;
+  GLint location;
+  GLint size;
+  GLenum type;
+  gchar* name = NULL;
+
+  __gl_try_catch(
+    glGetProgramiv(pid, GL_ACTIVE_UNIFORMS, &n_uniforms);
+    glGetProgramiv(pid, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxlen);
+  ,
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
+
+  name = g_malloc(maxlen + 1);
+
+  for(i = 0;
+      i < n_uniforms;
+      i++)
+  {
+    __gl_try_catch(
+      glGetActiveUniform(pid, i, maxlen + 1, &length, &size, &type, name);
+      location = glGetUniformLocation(pid, name);
+    ,
+      g_propagate_error(error, glerror);
+      goto_error();
+    );
+
+    /*
+     * Uniforms on blocks
+     * has no location
+     *
+     */
+    if G_UNLIKELY(location < 0)
+      continue;
+
+    /*
+     * Arrays are reported as 'name[0]',
+     * keep bare name
+     *
+     */
+    if(length > 3 && g_str_has_suffix(name, "[0]"))
+      name[length - 3] = '\0';
+
+    g_hash_table_insert
+    (uniforms,
+     g_strdup(name),
+     GINT_TO_POINTER(location));
+  }
+
+_error_:
+  _g_free0(name);
+return success;
+}
+
+static gboolean
+reflect_attributes(GLuint pid, guint* attributes, GError** error)
+{
+  gboolean success = TRUE;
+  GLint i, n_attributes = 0;
+  GLint maxlen = 0;
+  GLint location;
+  GLint size;
+  GLenum type;
+  gchar* name = NULL;
+
+  __gl_try_catch(
+    glGetProgramiv(pid, GL_ACTIVE_ATTRIBUTES, &n_attributes);
+    glGetProgramiv(pid, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxlen);
+  ,
+    g_propagate_error(error, glerror);
+    goto_error();
+  );
+
+  name = g_malloc(maxlen + 1);
+  *attributes = 0;
+
+  for(i = 0;
+      i < n_attributes;
+      i++)
+  {
+    __gl_try_catch(
+      glGetActiveAttrib(pid, i, maxlen + 1, NULL, &size, &type, name);
+      location = glGetAttribLocation(pid, name);
+    ,
+      g_propagate_error(error, glerror);
+      goto_error();
+    );
+
+    /*
+     * Built-ins (gl_VertexID and
+     * friends) has no location
+     *
+     */
+    if G_UNLIKELY(location < 0 || location >= 32)
+      continue;
+
+    *attributes |= 1 << location;
+  }
+
+_error_:
+  _g_free0(name);
+return success;
+}
+
 static gboolean
 ds_shader_g_initable_iface_init_sync(GInitable     *pself,
                                      GCancellable  *cancellable,
@@ -638,6 +751,27 @@ ds_shader_g_initable_iface_init_sync(GInitable     *pself,
     }
   }
 
+/*
+ * Reflect uniforms and attributes
+ *
+ */
+
+  success =
+  reflect_uniforms(pid, self->uniforms, &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
+  success =
+  reflect_attributes(pid, &(self->attributes), &tmp_err);
+  if G_UNLIKELY(tmp_err != NULL)
+  {
+    g_propagate_error(error, tmp_err);
+    goto_error();
+  }
+
 /*
  * Finish program
  *
@@ -697,6 +831,7 @@ void ds_shader_class_set_property(GObject* pself, guint prop_id, const GValue* v
 static
 void ds_shader_class_finalize(GObject* pself) {
   DsShader* self = DS_SHADER(pself);
+  g_hash_table_unref(self->uniforms);
 
   __gl_try(
     glDeleteProgram(self->pid);
@@ -814,6 +949,12 @@ void ds_shader_class_init(DsShaderClass* klass) {
 
 static
 void ds_shader_init(DsShader* self) {
+  self->uniforms =
+  g_hash_table_new_full
+  (g_str_hash,
+   g_str_equal,
+   g_free,
+   NULL);
 }
 
 /*
@@ -906,6 +1047,51 @@ ds_shader_new_from_files(GFile           *vertex_file,
    NULL);
 }
 
+/**
+ * ds_shader_get_uniform_location:
+ * @shader: a #DsShader instance.
+ * @name: uniform name.
+ *
+ * Looks up @name on uniforms reflected from @shader
+ * program when it was linked. Unlike glGetUniformLocation()
+ * this does not touches GL, so it can be called from
+ * any thread.
+ *
+ * Returns: uniform location, or -1 if @shader has no
+ * active uniform called @name.
+ */
+GLint
+ds_shader_get_uniform_location(DsShader     *shader,
+                               const gchar  *name)
+{
+  g_return_val_if_fail(DS_IS_SHADER(shader), -1);
+  g_return_val_if_fail(name != NULL, -1);
+  gpointer location;
+
+  if(g_hash_table_lookup_extended(shader->uniforms, name, NULL, &location))
+    return GPOINTER_TO_INT(location);
+return -1;
+}
+
+/**
+ * ds_shader_get_active_attributes:
+ * @shader: a #DsShader instance.
+ *
+ * Gets which vertex attribute locations are
+ * actually consumed by @shader program, as
+ * reflected when it was linked. As with
+ * #ds_shader_get_uniform_location() it can be
+ * called from any thread.
+ *
+ * Returns: a bitmask, bit N set when location N is active.
+ */
+guint
+ds_shader_get_active_attributes(DsShader* shader)
+{
+  g_return_val_if_fail(DS_IS_SHADER(shader), 0);
+return shader->attributes;
+}
+
 G_GNUC_INTERNAL
 GLuint
 _ds_shader_get_pid(DsShader *shader)
@@ -913,3 +1099,11 @@ _ds_shader_get_pid(DsShader *shader)
   g_return_val_if_fail(DS_IS_SHADER(shader), 0);
 return shader->pid;
 }
+
+G_GNUC_INTERNAL
+GHashTable*
+_ds_shader_get_uniforms(DsShader *shader)
+{
+  g_return_val_if_fail(DS_IS_SHADER(shader), NULL);
+return shader->uniforms;
+}
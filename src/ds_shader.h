@@ -19,6 +19,7 @@
 #define __DS_SHADER_INCLUDED__ 1
 #include <ds_export.h>
 #include <ds_folder_provider.h>
+#include <ds_gl.h>
 #include <cglm/cglm.h>
 #include <gio/gio.h>
 
@@ -98,6 +99,14 @@ ds_shader_new_from_files(GFile           *vertex_file,
                          GCancellable    *cancellable,
                          GError         **error);
 
+DEUSEXMAKINA2_API
+GLint
+ds_shader_get_uniform_location(DsShader     *shader,
+                               const gchar  *name);
+DEUSEXMAKINA2_API
+guint
+ds_shader_get_active_attributes(DsShader* shader);
+
 #if __cplusplus
 }
 #endif // __cplusplus
@@ -0,0 +1,488 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <ds_frame_stats.h>
+#include <ds_game_object_private.h>
+#include <ds_looper.h>
+#include <ds_macros.h>
+#include <ds_simulation.h>
+
+/**
+ * SECTION:dssimulation
+ * @Short_description: Fixed timestep simulation
+ * @Title: DsSimulation
+ *
+ * DsSimulation advances game state on fixed steps,
+ * independently of frame rate. On every frame clock
+ * tick it accumulates elapsed time and consumes it in
+ * steps of 1 / 'tick-rate' seconds, emitting
+ * #DsGameObject::update on every object it holds
+ * and #DsSimulation::tick for global handlers.
+ *
+ * Left-over time is used to interpolate object
+ * transforms between last two simulation states,
+ * right before render phase. Steps per frame are
+ * capped by 'max-ticks' setting, so a slow frame
+ * does not feed on itself (spiral of death).
+ *
+ */
+
+static void
+ds_simulation_g_initable_iface_init(GInitableIface* iface);
+
+enum
+{
+  conn_tick_rate,
+  conn_max_ticks,
+  conn_number,
+};
+
+/*
+ * Object definition
+ *
+ */
+
+struct _DsSimulation
+{
+  DsLooper parent_instance;
+
+  /*<private>*/
+  GSettings* gsettings;
+  GList* objects;
+
+  gint64 step;
+  gint64 last;
+  gint64 accumulator;
+  gint64 fixed_delta;
+  gint max_ticks;
+  gfloat alpha;
+
+  gulong connections[conn_number];
+};
+
+struct _DsSimulationClass
+{
+  DsLooperClass parent_class;
+};
+
+enum
+{
+  prop_0,
+  prop_gsettings,
+  prop_number,
+};
+
+static
+GParamSpec* properties[prop_number] = {0};
+
+enum
+{
+  sig_tick,
+  sig_number,
+};
+
+static
+guint signals[sig_number] = {0};
+
+G_DEFINE_TYPE_WITH_CODE
+(DsSimulation,
+ ds_simulation,
+ DS_TYPE_LOOPER,
+ G_IMPLEMENT_INTERFACE
+ (G_TYPE_INITABLE,
+  ds_simulation_g_initable_iface_init));
+
+static void
+on_tick_rate_changed(GSettings      *gsettings,
+                     const gchar    *key,
+                     DsSimulation   *self)
+{
+  gint tick_rate;
+  g_settings_get(gsettings, key, "i", &tick_rate);
+  self->step = G_USEC_PER_SEC / MAX(tick_rate, 1);
+}
+
+static void
+on_max_ticks_changed(GSettings      *gsettings,
+                     const gchar    *key,
+                     DsSimulation   *self)
+{
+  g_settings_get(gsettings, key, "i", &(self->max_ticks));
+  self->max_ticks = MAX(self->max_ticks, 1);
+}
+
+static gboolean
+ds_simulation_g_initable_iface_init_sync(GInitable* pself, GCancellable* cancellable, GError** error)
+{
+  DsSimulation* self = DS_SIMULATION(pself);
+
+/*
+ * Connects settings
+ *
+ */
+
+  self->connections[conn_tick_rate] =
+  g_signal_connect
+  (self->gsettings,
+   "changed::tick-rate",
+   G_CALLBACK(on_tick_rate_changed),
+   self);
+  on_tick_rate_changed(self->gsettings, "tick-rate", self);
+
+  self->connections[conn_max_ticks] =
+  g_signal_connect
+  (self->gsettings,
+   "changed::max-ticks",
+   G_CALLBACK(on_max_ticks_changed),
+   self);
+  on_max_ticks_changed(self->gsettings, "max-ticks", self);
+return TRUE;
+}
+
+static void
+ds_simulation_g_initable_iface_init(GInitableIface* iface)
+{
+  iface->init = ds_simulation_g_initable_iface_init_sync;
+}
+
+static gboolean
+ds_simulation_class_loop_step(DsLooper* pself)
+{
+  DsSimulation* self = DS_SIMULATION(pself);
+  gint64 now = g_get_monotonic_time();
+  gdouble step = (gdouble) self->step / G_USEC_PER_SEC;
+  gint64 script;
+  GList* objects;
+  GList* list;
+  gint ticks;
+
+  if G_UNLIKELY(self->last == 0)
+    self->last = now;
+
+  if G_UNLIKELY(self->fixed_delta > 0)
+    self->accumulator += self->fixed_delta;
+  else
+    self->accumulator += now - self->last;
+  self->last = now;
+
+/*
+ * Spiral-of-death clamp: if we are
+ * so behind that catching up would
+ * take more than 'max-ticks' steps,
+ * drop excess time and slow down
+ * simulation instead
+ *
+ */
+
+  if G_UNLIKELY(self->accumulator > self->step * self->max_ticks)
+    self->accumulator = self->step * self->max_ticks;
+
+/*
+ * Fixed steps
+ *
+ */
+
+  for(ticks = 0;
+      self->accumulator >= self->step;
+      ticks++)
+  {
+    /*
+     * Handlers may add or remove objects
+     * while we walk them, so walk a copy
+     * (changes apply from next step on)
+     *
+     */
+
+    objects =
+    g_list_copy_deep
+    (self->objects,
+     (GCopyFunc)
+     g_object_ref,
+     NULL);
+
+    for(list = objects;
+        list != NULL;
+        list = list->next)
+      _ds_game_object_snapshot(list->data);
+
+    script = g_get_monotonic_time();
+
+    for(list = objects;
+        list != NULL;
+        list = list->next)
+      ds_game_object_update(list->data, step);
+
+    g_list_free_full(objects, g_object_unref);
+    g_signal_emit(self, signals[sig_tick], 0, step);
+
+    ds_frame_stats_add_script_time
+    (ds_frame_stats_get_default(),
+     g_get_monotonic_time() - script);
+
+    self->accumulator -= self->step;
+  }
+
+/*
+ * Interpolate transforms
+ *
+ */
+
+  self->alpha = (gfloat) self->accumulator / (gfloat) self->step;
+
+  for(list = self->objects;
+      list != NULL;
+      list = list->next)
+    _ds_game_object_interpolate(list->data, self->alpha);
+return G_SOURCE_CONTINUE;
+}
+
+static void
+ds_simulation_class_start(DsLooper* pself)
+{
+  DsSimulation* self = DS_SIMULATION(pself);
+
+  /* do not count time spent stopped */
+  self->last = 0;
+  self->accumulator = 0;
+
+DS_LOOPER_CLASS(ds_simulation_parent_class)->start(pself);
+}
+
+static void
+ds_simulation_class_set_property(GObject* pself, guint prop_id, const GValue* value, GParamSpec* pspec)
+{
+  DsSimulation* self = DS_SIMULATION(pself);
+  switch(prop_id)
+  {
+  case prop_gsettings:
+    g_set_object(&(self->gsettings), g_value_get_object(value));
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID(pself, prop_id, pspec);
+    break;
+  }
+}
+
+static void
+ds_simulation_class_dispose(GObject* pself)
+{
+  DsSimulation* self = DS_SIMULATION(pself);
+  guint i;
+
+  for(i = 0;
+      i < conn_number;
+      i++)
+  if(self->connections[i] != 0)
+  {
+    g_signal_handler_disconnect(self->gsettings, self->connections[i]);
+    self->connections[i] = 0;
+  }
+
+  g_list_free_full(self->objects, g_object_unref);
+  self->objects = NULL;
+
+  g_clear_object(&(self->gsettings));
+G_OBJECT_CLASS(ds_simulation_parent_class)->dispose(pself);
+}
+
+static void
+ds_simulation_class_init(DsSimulationClass* klass)
+{
+  GObjectClass* oclass = G_OBJECT_CLASS(klass);
+  DsLooperClass* lclass = DS_LOOPER_CLASS(klass);
+
+  lclass->loop_step = ds_simulation_class_loop_step;
+  lclass->start = ds_simulation_class_start;
+
+  oclass->set_property = ds_simulation_class_set_property;
+  oclass->dispose = ds_simulation_class_dispose;
+
+  /**
+   * DsSimulation::tick:
+   * @object: the #DsSimulation object which launches the signal.
+   * @step: simulation step length, in seconds.
+   *
+   * Emitted once per fixed simulation step, after
+   * every object has been updated. Connect here
+   * game logic which is not bound to an object.
+   *
+   */
+  signals[sig_tick] =
+    g_signal_new
+    ("tick",
+     G_TYPE_FROM_CLASS(klass),
+     G_SIGNAL_RUN_FIRST,
+     0,
+     NULL,
+     NULL,
+     g_cclosure_marshal_VOID__DOUBLE,
+     G_TYPE_NONE,
+     1,
+     G_TYPE_DOUBLE);
+
+  properties[prop_gsettings] =
+    g_param_spec_object
+    (_TRIPLET("gsettings"),
+     G_TYPE_SETTINGS,
+     G_PARAM_WRITABLE
+     | G_PARAM_CONSTRUCT_ONLY
+     | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties
+  (oclass,
+   prop_number,
+   properties);
+}
+
+static void
+ds_simulation_init(DsSimulation* self)
+{
+}
+
+/*
+ * Object methods
+ *
+ */
+
+/**
+ * ds_simulation_new: (constructor)
+ * @gsettings: (not nullable): a #GSettings object.
+ * @cancellable: (nullable): a %GCancellable.
+ * @error: return location for a #GError.
+ *
+ * Creates a new #DsSimulation, which steps at
+ * rate specified by @gsettings.
+ *
+ * Returns: (transfer full): see description.
+ */
+DsSimulation*
+ds_simulation_new(GSettings      *gsettings,
+                  GCancellable   *cancellable,
+                  GError        **error)
+{
+  return (DsSimulation*)
+  g_initable_new
+  (DS_TYPE_SIMULATION,
+   cancellable,
+   error,
+   "gsettings", gsettings,
+   "phase", DS_FRAME_CLOCK_PHASE_UPDATE,
+   NULL);
+}
+
+/**
+ * ds_simulation_add_object:
+ * @simulation: a #DsSimulation instance.
+ * @object: a #DsGameObject instance.
+ *
+ * Adds @object to @simulation, so it gets
+ * updated on every step, and its transform
+ * interpolated on every frame.
+ *
+ */
+void
+ds_simulation_add_object(DsSimulation  *simulation,
+                         DsGameObject  *object)
+{
+  g_return_if_fail(DS_IS_SIMULATION(simulation));
+  g_return_if_fail(DS_IS_GAME_OBJECT(object));
+  DsSimulation* self = simulation;
+
+  /* start from a still state */
+  _ds_game_object_snapshot(object);
+
+  self->objects =
+  g_list_prepend(self->objects, g_object_ref(object));
+}
+
+/**
+ * ds_simulation_remove_object:
+ * @simulation: a #DsSimulation instance.
+ * @object: a #DsGameObject instance.
+ *
+ * Removes @object from @simulation.
+ *
+ */
+void
+ds_simulation_remove_object(DsSimulation  *simulation,
+                            DsGameObject  *object)
+{
+  g_return_if_fail(DS_IS_SIMULATION(simulation));
+  g_return_if_fail(DS_IS_GAME_OBJECT(object));
+  DsSimulation* self = simulation;
+  GList* link = NULL;
+
+  link = g_list_find(self->objects, object);
+  if G_LIKELY(link != NULL)
+  {
+    self->objects = g_list_delete_link(self->objects, link);
+    g_object_unref(object);
+  }
+}
+
+/**
+ * ds_simulation_get_step:
+ * @simulation: a #DsSimulation instance.
+ *
+ * Gets simulation step length.
+ *
+ * Returns: step length, in seconds.
+ */
+gdouble
+ds_simulation_get_step(DsSimulation* simulation)
+{
+  g_return_val_if_fail(DS_IS_SIMULATION(simulation), 0.);
+return (gdouble) simulation->step / G_USEC_PER_SEC;
+}
+
+/**
+ * ds_simulation_get_alpha:
+ * @simulation: a #DsSimulation instance.
+ *
+ * Gets interpolation factor used on last frame,
+ * this is, how far (from 0 to 1) between last two
+ * simulation states objects were rendered.
+ *
+ * Returns: interpolation factor.
+ */
+gdouble
+ds_simulation_get_alpha(DsSimulation* simulation)
+{
+  g_return_val_if_fail(DS_IS_SIMULATION(simulation), 0.);
+return simulation->alpha;
+}
+
+/**
+ * ds_simulation_set_fixed_delta:
+ * @simulation: a #DsSimulation instance.
+ * @delta: time to advance per frame, in microseconds, or zero.
+ *
+ * Makes @simulation advance exactly @delta per
+ * frame instead of elapsed wall time, so a run
+ * driven by replayed input is deterministic.
+ * Zero goes back to wall time.
+ *
+ */
+void
+ds_simulation_set_fixed_delta(DsSimulation  *simulation,
+                              gint64         delta)
+{
+  g_return_if_fail(DS_IS_SIMULATION(simulation));
+  g_return_if_fail(delta >= 0);
+  simulation->fixed_delta = delta;
+}
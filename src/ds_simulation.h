@@ -0,0 +1,70 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __DS_SIMULATION_INCLUDED__
+#define __DS_SIMULATION_INCLUDED__ 1
+#include <ds_export.h>
+#include <ds_game_object.h>
+#include <gio/gio.h>
+
+#define DS_TYPE_SIMULATION            (ds_simulation_get_type())
+#define DS_SIMULATION(object)         (G_TYPE_CHECK_INSTANCE_CAST((object), DS_TYPE_SIMULATION, DsSimulation))
+#define DS_SIMULATION_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass), DS_TYPE_SIMULATION, DsSimulationClass))
+#define DS_IS_SIMULATION(object)      (G_TYPE_CHECK_INSTANCE_TYPE((object), DS_TYPE_SIMULATION))
+#define DS_IS_SIMULATION_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), DS_TYPE_SIMULATION))
+#define DS_SIMULATION_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), DS_TYPE_SIMULATION, DsSimulationClass))
+
+typedef struct _DsSimulation      DsSimulation;
+typedef struct _DsSimulationClass DsSimulationClass;
+
+#if __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+DEUSEXMAKINA2_API
+GType
+ds_simulation_get_type();
+
+DEUSEXMAKINA2_API
+DsSimulation*
+ds_simulation_new(GSettings      *gsettings,
+                  GCancellable   *cancellable,
+                  GError        **error);
+DEUSEXMAKINA2_API
+void
+ds_simulation_add_object(DsSimulation  *simulation,
+                         DsGameObject  *object);
+DEUSEXMAKINA2_API
+void
+ds_simulation_remove_object(DsSimulation  *simulation,
+                            DsGameObject  *object);
+DEUSEXMAKINA2_API
+gdouble
+ds_simulation_get_step(DsSimulation* simulation);
+DEUSEXMAKINA2_API
+gdouble
+ds_simulation_get_alpha(DsSimulation* simulation);
+DEUSEXMAKINA2_API
+void
+ds_simulation_set_fixed_delta(DsSimulation  *simulation,
+                              gint64         delta);
+
+#if __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __DS_SIMULATION_INCLUDED__
@@ -498,11 +498,10 @@ void ds_skybox_g_initable_iface_init(GInitableIface* iface) {
 }
 
 static gboolean
-ds_skybox_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
+ds_skybox_ds_renderable_iface_plan(DsRenderable* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
 {
   DsSkybox* self = DS_SKYBOX(pself);
   gboolean success = TRUE;
-  GError* tmp_err = NULL;
   GLint uloc = 0;
 
 /*
@@ -510,17 +509,8 @@ ds_skybox_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state,
  *
  */
 
-  GLuint program =
-  ds_render_state_get_current_program(state);
-
   /* get uniform */
-  __gl_try_catch(
-    uloc = glGetUniformLocation(program, "a_skybox");
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
-
+  uloc = ds_render_state_get_uniform_location(state, "a_skybox");
   if G_UNLIKELY(uloc == (-1))
   {
     g_set_error_literal
@@ -532,12 +522,12 @@ ds_skybox_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state,
   }
 
   /* select texture unit */
-  __gl_try_catch(
-    glUniform1i(uloc, 0);
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
+  ds_render_state_setup
+  (state,
+   G_CALLBACK(glUniform1i),
+   2,
+   (guintptr) uloc,
+   (guintptr) 0);
 
 /*
  * Compile calls
@@ -634,25 +624,12 @@ ds_skybox_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state,
    (guintptr) GL_LESS);
 
 _error_:
-  __gl_try(
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-  );
-  __gl_catch(
-    g_warning
-    ("(%s:%i): %s: %i: %s\r\n",
-     G_STRFUNC,
-     __LINE__,
-     g_quark_to_string(glerror->domain),
-     glerror->code,
-     glerror->message);
-    g_error_free(glerror);
-  ,);
 return success;
 }
 
 static
 void ds_skybox_ds_renderable_iface_init(DsRenderableIface* iface) {
-  iface->compile = ds_skybox_ds_renderable_iface_compile;
+  iface->plan = ds_skybox_ds_renderable_iface_plan;
 }
 
 static
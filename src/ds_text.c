@@ -88,29 +88,22 @@ G_DEFINE_TYPE_WITH_CODE
  });
 
 static gboolean
-ds_text_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
+ds_text_ds_renderable_iface_plan(DsRenderable* pself, DsRenderState* state, GCancellable* cancellable, GError** error)
 {
   DsText* self = DS_TEXT(pself);
   gboolean success = TRUE;
-  GError* tmp_err = NULL;
   GLint uloc = 0;
 
+  /* setup calls are deferred */
+  static const vec3 color = {1.f, 1.f, 1.f};
+
 /*
  * Fill uniforms
  *
  */
 
-  GLuint program =
-  ds_render_state_get_current_program(state);
-
   /* get uniform */
-  __gl_try_catch(
-    uloc = glGetUniformLocation(program, "a_charmap");
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
-
+  uloc = ds_render_state_get_uniform_location(state, "a_charmap");
   if G_UNLIKELY(uloc == (-1))
   {
     g_set_error_literal
@@ -122,21 +115,15 @@ ds_text_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state, G
   }
 
   /* select texture unit */
-  __gl_try_catch(
-    glUniform1i(uloc, 0);
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
+  ds_render_state_setup
+  (state,
+   G_CALLBACK(glUniform1i),
+   2,
+   (guintptr) uloc,
+   (guintptr) 0);
 
   /* get uniform */
-  __gl_try_catch(
-    uloc = glGetUniformLocation(program, "a_color");
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
-
+  uloc = ds_render_state_get_uniform_location(state, "a_color");
   if G_UNLIKELY(uloc == (-1))
   {
     g_set_error_literal
@@ -147,15 +134,14 @@ ds_text_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state, G
     goto_error();
   }
 
-  vec3 color = {1.f, 1.f, 1.f};
-
   /* set text color */
-  __gl_try_catch(
-    glUniform3fv(uloc, 1, color);
-  ,
-    g_propagate_error(error, glerror);
-    goto_error();
-  );
+  ds_render_state_setup
+  (state,
+   G_CALLBACK(glUniform3fv),
+   3,
+   (guintptr) uloc,
+   (guintptr) 1,
+   (guintptr) color);
 
 /*
  * Compile calls
@@ -180,25 +166,12 @@ ds_text_ds_renderable_iface_compile(DsRenderable* pself, DsRenderState* state, G
   /* draw things */
 
 _error_:
-  __gl_try_catch(
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glActiveTexture(GL_TEXTURE0);
-  ,
-    g_warning
-    ("(%s:%i): %s: %i: %s\r\n",
-     G_STRFUNC,
-     __LINE__,
-     g_quark_to_string(glerror->domain),
-     glerror->code,
-     glerror->message);
-    g_error_free(glerror);
-  );
 return success;
 }
 
 static
 void ds_text_ds_renderable_iface_init(DsRenderableIface* iface) {
-  iface->compile = ds_text_ds_renderable_iface_compile;
+  iface->plan = ds_text_ds_renderable_iface_plan;
 }
 
 static
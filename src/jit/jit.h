@@ -37,6 +37,8 @@
 # define jitmain  ((JitMain)(ctx->labels[ctx->n_main]))
 #endif // __INSIDE_DYNASM_FILE__
 
+#define JIT_MAX_PARAMS (8)
+
 typedef struct {
 /*
  * IMPORTANT
@@ -59,10 +61,33 @@ typedef struct {
   guint n_main;
   gpointer block;
   gsize blocksz;
+} JitState;
+
+typedef struct {
+  GCallback callback;
+  gboolean protected_;
+  guint n_params;
+  guintptr params[JIT_MAX_PARAMS];
+} JitCall;
+
+/*
+ * JitPlan is what DsRenderState actually is.
+ * It records calls instead of emitting machine
+ * code, so it never touches GL (neither dasm state)
+ * and several plans could be built concurrently.
+ *
+ */
+
+typedef struct {
   GLuint pid;
   GLuint vao;
-  JitMvps mvps;
-} JitState;
+  const GLuint* vbo;      /* bound on vao (by address) */
+  const GLuint* ibo;      /* bound on vao (by address) */
+  JitMvps* mvps;
+  GHashTable* uniforms;   /* shader reflection (read-only) */
+  GArray* setup;          /* JitCall, run once on GL thread */
+  GArray* calls;          /* JitCall, compiled into pipeline */
+} JitPlan;
 
 typedef void (*JitMain) (gpointer instance, JitMvps* mvps, GError** error);
 
@@ -99,6 +124,56 @@ _ds_jit_compile_call(JitState  *ctx,
                      gboolean  protected_,
                      guint      n_params,
                      ...);
+G_GNUC_INTERNAL
+void
+_ds_jit_compile_call_array(JitState        *ctx,
+                           GCallback        callback,
+                           gboolean         protected_,
+                           guint            n_params,
+                           const guintptr  *params);
+
+/*
+ * Plans
+ *
+ */
+
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_init(JitPlan    *plan,
+                  GLuint      pid,
+                  JitMvps    *mvps,
+                  GHashTable *uniforms);
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_clear(JitPlan* plan);
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_call_valist(JitPlan   *plan,
+                         gboolean   setup,
+                         GCallback  callback,
+                         gboolean   protected_,
+                         guint      n_params,
+                         va_list    l);
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_call(JitPlan   *plan,
+                  gboolean   setup,
+                  GCallback  callback,
+                  gboolean   protected_,
+                  guint      n_params,
+                  ...);
+G_GNUC_INTERNAL
+GLint
+_ds_jit_plan_get_uniform(JitPlan      *plan,
+                         const gchar  *name);
+G_GNUC_INTERNAL
+gboolean
+_ds_jit_plan_run_setup(JitPlan   *plan,
+                       GError   **error);
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_emit(JitPlan   *plan,
+                  JitState  *ctx);
 
 /*
  * Helpers
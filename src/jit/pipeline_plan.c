@@ -0,0 +1,175 @@
+/*  Copyright 2021-2022 MarcosHCK
+ *  This file is part of deusexmakina2.
+ *
+ *  deusexmakina2 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  deusexmakina2 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with deusexmakina2.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <config.h>
+#include <jit.h>
+
+typedef guintptr P;
+typedef void (*JitCall0) (void);
+typedef void (*JitCall1) (P);
+typedef void (*JitCall2) (P, P);
+typedef void (*JitCall3) (P, P, P);
+typedef void (*JitCall4) (P, P, P, P);
+typedef void (*JitCall5) (P, P, P, P, P);
+typedef void (*JitCall6) (P, P, P, P, P, P);
+typedef void (*JitCall7) (P, P, P, P, P, P, P);
+typedef void (*JitCall8) (P, P, P, P, P, P, P, P);
+
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_init(JitPlan    *plan,
+                  GLuint      pid,
+                  JitMvps    *mvps,
+                  GHashTable *uniforms)
+{
+  plan->pid = pid;
+  plan->vao = 0;
+  plan->vbo = NULL;
+  plan->ibo = NULL;
+  plan->mvps = mvps;
+  plan->uniforms = (uniforms == NULL) ? NULL : g_hash_table_ref(uniforms);
+  plan->setup = g_array_new(FALSE, FALSE, sizeof(JitCall));
+  plan->calls = g_array_new(FALSE, FALSE, sizeof(JitCall));
+}
+
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_clear(JitPlan* plan)
+{
+  g_clear_pointer(&(plan->uniforms), g_hash_table_unref);
+  g_clear_pointer(&(plan->setup), g_array_unref);
+  g_clear_pointer(&(plan->calls), g_array_unref);
+}
+
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_call_valist(JitPlan   *plan,
+                         gboolean   setup,
+                         GCallback  callback,
+                         gboolean   protected_,
+                         guint      n_params,
+                         va_list    l)
+{
+  g_return_if_fail(n_params <= JIT_MAX_PARAMS);
+  JitCall call = {0};
+  guint i;
+
+  call.callback = callback;
+  call.protected_ = protected_;
+  call.n_params = n_params;
+
+  for(i = 0;
+      i < n_params;
+      i++)
+    call.params[i] = va_arg(l, guintptr);
+
+  if(setup == TRUE)
+    g_array_append_val(plan->setup, call);
+  else
+    g_array_append_val(plan->calls, call);
+}
+
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_call(JitPlan   *plan,
+                  gboolean   setup,
+                  GCallback  callback,
+                  gboolean   protected_,
+                  guint      n_params,
+                  ...)
+{
+  va_list l;
+  va_start(l, n_params);
+  _ds_jit_plan_call_valist(plan, setup, callback, protected_, n_params, l);
+  va_end(l);
+}
+
+G_GNUC_INTERNAL
+GLint
+_ds_jit_plan_get_uniform(JitPlan      *plan,
+                         const gchar  *name)
+{
+  gpointer location;
+
+  if G_LIKELY(plan->uniforms != NULL)
+  {
+    if(g_hash_table_lookup_extended(plan->uniforms, name, NULL, &location))
+      return GPOINTER_TO_INT(location);
+  }
+return -1;
+}
+
+G_GNUC_INTERNAL
+gboolean
+_ds_jit_plan_run_setup(JitPlan   *plan,
+                       GError   **error)
+{
+  gboolean success = TRUE;
+  JitCall* call;
+  guint i;
+
+  for(i = 0;
+      i < plan->setup->len;
+      i++)
+  {
+    call = &g_array_index(plan->setup, JitCall, i);
+
+#define p call->params
+    switch(call->n_params)
+    {
+    case 0: ((JitCall0) call->callback) (); break;
+    case 1: ((JitCall1) call->callback) (p[0]); break;
+    case 2: ((JitCall2) call->callback) (p[0], p[1]); break;
+    case 3: ((JitCall3) call->callback) (p[0], p[1], p[2]); break;
+    case 4: ((JitCall4) call->callback) (p[0], p[1], p[2], p[3]); break;
+    case 5: ((JitCall5) call->callback) (p[0], p[1], p[2], p[3], p[4]); break;
+    case 6: ((JitCall6) call->callback) (p[0], p[1], p[2], p[3], p[4], p[5]); break;
+    case 7: ((JitCall7) call->callback) (p[0], p[1], p[2], p[3], p[4], p[5], p[6]); break;
+    case 8: ((JitCall8) call->callback) (p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]); break;
+    default: g_assert_not_reached(); break;
+    }
+#undef p
+
+    if(call->protected_ == TRUE)
+    {
+      if G_UNLIKELY(ds_gl_has_error() == TRUE)
+      {
+        g_propagate_error(error, ds_gl_get_error());
+        success = FALSE;
+        break;
+      }
+    }
+  }
+return success;
+}
+
+G_GNUC_INTERNAL
+void
+_ds_jit_plan_emit(JitPlan   *plan,
+                  JitState  *ctx)
+{
+  JitCall* call;
+  guint i;
+
+  for(i = 0;
+      i < plan->calls->len;
+      i++)
+  {
+    call = &g_array_index(plan->calls, JitCall, i);
+    _ds_jit_compile_call_array(ctx, call->callback, call->protected_, call->n_params, call->params);
+  }
+}
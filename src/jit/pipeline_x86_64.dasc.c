@@ -239,13 +239,13 @@ _ds_jit_compile_free(JitState* ctx)
 
 G_GNUC_INTERNAL
 void
-_ds_jit_compile_call_valist(JitState *ctx,
-                            GCallback callback,
-                            gboolean  protected_,
-                            guint     n_params,
-                            va_list   l)
+_ds_jit_compile_call_array(JitState        *ctx,
+                           GCallback        callback,
+                           gboolean         protected_,
+                           guint            n_params,
+                           const guintptr  *params)
 {
-  guint i, j;
+  guint i;
   guintptr arg;
 
 /*
@@ -257,7 +257,7 @@ _ds_jit_compile_call_valist(JitState *ctx,
       i < n_params;
       i++)
   {
-    arg = va_arg(l, guintptr);
+    arg = params[i];
     switch(i)
     {
     case 0:
@@ -303,6 +303,27 @@ _ds_jit_compile_call_valist(JitState *ctx,
   }
 }
 
+G_GNUC_INTERNAL
+void
+_ds_jit_compile_call_valist(JitState *ctx,
+                            GCallback callback,
+                            gboolean  protected_,
+                            guint     n_params,
+                            va_list   l)
+{
+  guintptr params[JIT_MAX_PARAMS];
+  guint i;
+
+  g_return_if_fail(n_params <= JIT_MAX_PARAMS);
+
+  for(i = 0;
+      i < n_params;
+      i++)
+    params[i] = va_arg(l, guintptr);
+
+  _ds_jit_compile_call_array(ctx, callback, protected_, n_params, params);
+}
+
 G_GNUC_INTERNAL
 void
 _ds_jit_compile_call(JitState  *ctx,